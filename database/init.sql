@@ -21,6 +21,12 @@ CREATE TABLE cameras (
     resolution VARCHAR(20) DEFAULT '1080p',
     fps INT DEFAULT 25,
     bitrate INT DEFAULT 4000,
+    recording_mode VARCHAR(20) DEFAULT 'auto', -- auto, passthrough, transcode
+    recording_trigger VARCHAR(20) DEFAULT 'continuous', -- continuous, event, motion
+    pre_roll_seconds INT DEFAULT 10,
+    post_roll_seconds INT DEFAULT 30,
+    storage_quota_gb INT, -- NULL = no quota (all tiers)
+    retention_days INT, -- NULL = global RETENTION_DAYS
     
     -- Streaming settings
     enable_low_stream BOOLEAN DEFAULT TRUE,
@@ -38,7 +44,10 @@ CREATE TABLE cameras (
     created_by UUID,
     
     -- Indexes
-    CONSTRAINT unique_camera_name UNIQUE(name)
+    CONSTRAINT unique_camera_name UNIQUE(name),
+    CONSTRAINT check_recording_mode CHECK (recording_mode IN ('auto', 'passthrough', 'transcode')),
+    CONSTRAINT check_storage_quota_gb CHECK (storage_quota_gb IS NULL OR storage_quota_gb > 0),
+    CONSTRAINT check_retention_days CHECK (retention_days IS NULL OR retention_days > 0)
 );
 
 CREATE INDEX idx_cameras_status ON cameras(status);
@@ -47,14 +56,18 @@ CREATE INDEX idx_cameras_location ON cameras(location);
 -- ============================================
 -- Recordings Table
 -- ============================================
+-- Partitioned by day on start_time (recordings_pYYYYMMDD, see Time
+-- Partitions below): retention drops whole days, range queries only
+-- scan the days they cover.
 CREATE TABLE recordings (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID NOT NULL DEFAULT uuid_generate_v4(),
     camera_id UUID NOT NULL REFERENCES cameras(id) ON DELETE CASCADE,
     
     -- File information
     filename VARCHAR(255) NOT NULL,
     filepath TEXT NOT NULL,
     file_size BIGINT,
+    chunk_offset BIGINT, -- Segment packed in a chunk file at filepath, NULL = own file
     
     -- Recording metadata
     start_time TIMESTAMP NOT NULL,
@@ -65,6 +78,7 @@ CREATE TABLE recordings (
     resolution VARCHAR(20),
     fps INT,
     codec VARCHAR(50),
+    bitrate BIGINT, -- bits per second
     
     -- Storage tier
     storage_tier VARCHAR(20) DEFAULT 'hot', -- hot, warm, cold
@@ -72,12 +86,18 @@ CREATE TABLE recordings (
     -- Metadata
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     
-    CONSTRAINT unique_recording UNIQUE(camera_id, start_time)
-);
+    PRIMARY KEY (id, start_time),
+    CONSTRAINT unique_recording UNIQUE(camera_id, start_time),
+    CONSTRAINT check_storage_tier CHECK (storage_tier IN ('hot', 'warm', 'cold')),
+    CONSTRAINT check_chunk_offset CHECK (chunk_offset IS NULL OR chunk_offset >= 0)
+) PARTITION BY RANGE (start_time);
+
+CREATE TABLE recordings_default PARTITION OF recordings DEFAULT;
 
 CREATE INDEX idx_recordings_camera ON recordings(camera_id);
 CREATE INDEX idx_recordings_time ON recordings(start_time, end_time);
 CREATE INDEX idx_recordings_tier ON recordings(storage_tier);
+CREATE INDEX idx_recordings_filepath ON recordings(filepath);  -- Tier mover updates by path
 
 -- ============================================
 -- Live Streams Table
@@ -113,10 +133,11 @@ CREATE INDEX idx_streams_status ON live_streams(status);
 -- ============================================
 -- Events Table (for AI/Analytics)
 -- ============================================
+-- Partitioned by day on event_time, dropped together with recordings
 CREATE TABLE events (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID NOT NULL DEFAULT uuid_generate_v4(),
     camera_id UUID NOT NULL REFERENCES cameras(id) ON DELETE CASCADE,
-    recording_id UUID REFERENCES recordings(id) ON DELETE SET NULL,
+    recording_id UUID, -- recordings.id; no foreign key, the recordings key is (id, start_time)
     
     -- Event info
     event_type VARCHAR(50) NOT NULL, -- motion, lpr, vehicle, person, alert
@@ -134,12 +155,17 @@ CREATE TABLE events (
     
     -- Metadata
     processed BOOLEAN DEFAULT FALSE,
-    acknowledged BOOLEAN DEFAULT FALSE
-);
+    acknowledged BOOLEAN DEFAULT FALSE,
+    
+    PRIMARY KEY (id, event_time)
+) PARTITION BY RANGE (event_time);
+
+CREATE TABLE events_default PARTITION OF events DEFAULT;
 
 CREATE INDEX idx_events_camera ON events(camera_id);
 CREATE INDEX idx_events_type ON events(event_type);
 CREATE INDEX idx_events_time ON events(event_time);
+CREATE INDEX idx_events_created ON events(created_at);
 CREATE INDEX idx_events_data ON events USING GIN(event_data);
 
 -- ============================================
@@ -173,8 +199,9 @@ CREATE INDEX idx_users_role ON users(role);
 -- ============================================
 -- System Metrics Table
 -- ============================================
+-- Partitioned by day on recorded_at (RECORDER_METRICS_RETENTION_DAYS)
 CREATE TABLE system_metrics (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID NOT NULL DEFAULT uuid_generate_v4(),
     
     -- Metrics
     metric_type VARCHAR(50) NOT NULL, -- cpu, memory, disk, network, recording
@@ -186,11 +213,15 @@ CREATE TABLE system_metrics (
     camera_id UUID REFERENCES cameras(id) ON DELETE CASCADE,
     
     -- Timestamp
-    recorded_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    recorded_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
     
     -- Metadata
-    metadata JSONB
-);
+    metadata JSONB,
+    
+    PRIMARY KEY (id, recorded_at)
+) PARTITION BY RANGE (recorded_at);
+
+CREATE TABLE system_metrics_default PARTITION OF system_metrics DEFAULT;
 
 CREATE INDEX idx_metrics_type ON system_metrics(metric_type);
 CREATE INDEX idx_metrics_time ON system_metrics(recorded_at);
@@ -235,6 +266,147 @@ CREATE TRIGGER calculate_duration
     FOR EACH ROW
     EXECUTE FUNCTION calculate_recording_duration();
 
+-- Tell the recorder which cameras changed (LISTEN camera_changes, payload = id)
+-- Only columns the recorder uses: last_seen heartbeats do not notify
+CREATE OR REPLACE FUNCTION notify_camera_change()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('camera_changes', OLD.id::text);
+    ELSE
+        PERFORM pg_notify('camera_changes', NEW.id::text);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER notify_cameras_insert_delete
+    AFTER INSERT OR DELETE ON cameras
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_camera_change();
+
+CREATE TRIGGER notify_cameras_update
+    AFTER UPDATE ON cameras
+    FOR EACH ROW
+    WHEN ((OLD.name, OLD.rtsp_url, OLD.location, OLD.status, OLD.recording_mode, OLD.recording_trigger,
+           OLD.pre_roll_seconds, OLD.post_roll_seconds, OLD.storage_quota_gb, OLD.retention_days)
+          IS DISTINCT FROM
+          (NEW.name, NEW.rtsp_url, NEW.location, NEW.status, NEW.recording_mode, NEW.recording_trigger,
+           NEW.pre_roll_seconds, NEW.post_roll_seconds, NEW.storage_quota_gb, NEW.retention_days))
+    EXECUTE FUNCTION notify_camera_change();
+
+-- ============================================
+-- Time Partitions
+-- ============================================
+-- Daily partitions <table>_pYYYYMMDD for [from_day, from_day + days).
+-- Rows of such a day already in the <table>_default partition are moved
+-- into the new partition (a DEFAULT partition holding rows of the range
+-- would make CREATE ... PARTITION OF fail).
+CREATE OR REPLACE FUNCTION create_time_partitions(parent REGCLASS, from_day DATE, days INT)
+RETURNS INT AS $$
+DECLARE
+    table_name TEXT := (SELECT relname FROM pg_class WHERE oid = parent);
+    default_name TEXT := table_name || '_default';
+    key_column TEXT;
+    day DATE;
+    partition_name TEXT;
+    has_rows BOOLEAN;
+    created INT := 0;
+BEGIN
+    PERFORM pg_advisory_xact_lock(hashtext('time_partitions'));
+
+    SELECT a.attname INTO key_column
+    FROM pg_partitioned_table p
+    JOIN pg_attribute a ON a.attrelid = p.partrelid AND a.attnum = p.partattrs[0]
+    WHERE p.partrelid = parent;
+    IF key_column IS NULL THEN
+        RAISE EXCEPTION '% is not partitioned', parent;
+    END IF;
+
+    FOR i IN 0 .. days - 1 LOOP
+        day := from_day + i;
+        partition_name := table_name || '_p' || to_char(day, 'YYYYMMDD');
+        CONTINUE WHEN to_regclass(partition_name) IS NOT NULL;
+
+        has_rows := FALSE;
+        IF to_regclass(default_name) IS NOT NULL THEN
+            EXECUTE format('SELECT EXISTS (SELECT 1 FROM %I WHERE %I >= %L AND %I < %L)',
+                           default_name, key_column, day, key_column, day + 1) INTO has_rows;
+        END IF;
+
+        IF has_rows THEN
+            EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS INCLUDING CONSTRAINTS)',
+                           partition_name, table_name);
+            EXECUTE format('WITH moved AS (DELETE FROM %I WHERE %I >= %L AND %I < %L RETURNING *) '
+                           'INSERT INTO %I SELECT * FROM moved',
+                           default_name, key_column, day, key_column, day + 1, partition_name);
+            EXECUTE format('ALTER TABLE %I ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                           table_name, partition_name, day, day + 1);
+        ELSE
+            EXECUTE format('CREATE TABLE %I PARTITION OF %I FOR VALUES FROM (%L) TO (%L)',
+                           partition_name, table_name, day, day + 1);
+        END IF;
+        created := created + 1;
+    END LOOP;
+    RETURN created;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Partitions of the time-partitioned tables from yesterday (time zone
+-- slack) to days_ahead days from today
+CREATE OR REPLACE FUNCTION ensure_time_partitions(days_ahead INT)
+RETURNS INT AS $$
+BEGIN
+    RETURN create_time_partitions('recordings', CURRENT_DATE - 1, days_ahead + 2)
+         + create_time_partitions('events', CURRENT_DATE - 1, days_ahead + 2)
+         + create_time_partitions('system_metrics', CURRENT_DATE - 1, days_ahead + 2);
+END;
+$$ LANGUAGE plpgsql;
+
+-- Retention: drop the daily partitions that end on or before cutoff and
+-- delete the rows before cutoff left in the DEFAULT partition. A drop
+-- waits at most 5 s for the table lock (fails, retried next run).
+CREATE OR REPLACE FUNCTION drop_time_partitions_before(parent REGCLASS, cutoff DATE)
+RETURNS INT AS $$
+DECLARE
+    table_name TEXT := (SELECT relname FROM pg_class WHERE oid = parent);
+    key_column TEXT;
+    partition_name TEXT;
+    dropped INT := 0;
+BEGIN
+    PERFORM pg_advisory_xact_lock(hashtext('time_partitions'));
+    PERFORM set_config('lock_timeout', '5s', true);
+
+    SELECT a.attname INTO key_column
+    FROM pg_partitioned_table p
+    JOIN pg_attribute a ON a.attrelid = p.partrelid AND a.attnum = p.partattrs[0]
+    WHERE p.partrelid = parent;
+    IF key_column IS NULL THEN
+        RAISE EXCEPTION '% is not partitioned', parent;
+    END IF;
+
+    FOR partition_name IN
+        SELECT c.relname FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid
+        WHERE i.inhparent = parent
+          AND CASE WHEN c.relname ~ ('^' || table_name || '_p[0-9]{8}$')
+                   THEN to_date(right(c.relname, 8), 'YYYYMMDD') + 1 <= cutoff
+                   ELSE FALSE END
+        ORDER BY c.relname
+    LOOP
+        EXECUTE format('DROP TABLE %I', partition_name);
+        dropped := dropped + 1;
+    END LOOP;
+
+    IF to_regclass(table_name || '_default') IS NOT NULL THEN
+        EXECUTE format('DELETE FROM %I WHERE %I < %L', table_name || '_default', key_column, cutoff);
+    END IF;
+    RETURN dropped;
+END;
+$$ LANGUAGE plpgsql;
+-- Today and the week ahead; the recorder keeps creating them
+-- (RECORDER_PARTITION_DAYS_AHEAD) and drops expired ones
+SELECT ensure_time_partitions(7);
+
 -- ============================================
 -- Initial Data (Development)
 -- ============================================
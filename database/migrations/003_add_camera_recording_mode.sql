@@ -0,0 +1,27 @@
+-- Migration: Add per-camera recording mode
+-- Date: 2026-10-16
+-- Description: Let the recorder remux H.264/H.265 cameras instead of re-encoding
+
+-- ============================================
+-- Recording Mode Column
+-- ============================================
+-- auto:        passthrough when the camera codec is H.264/H.265, transcode otherwise
+-- passthrough: always remux camera packets into the MP4 segments
+-- transcode:   always re-encode (hevc_nvenc / h264_vaapi)
+DO $$ 
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='cameras' AND column_name='recording_mode') THEN
+        ALTER TABLE cameras ADD COLUMN recording_mode VARCHAR(20) DEFAULT 'auto';
+        ALTER TABLE cameras ADD CONSTRAINT check_recording_mode
+            CHECK (recording_mode IN ('auto', 'passthrough', 'transcode'));
+    END IF;
+END $$;
+
+COMMENT ON COLUMN cameras.recording_mode IS 'Recording mode: auto, passthrough, transcode';
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: cameras.recording_mode added';
+END $$;
@@ -0,0 +1,43 @@
+-- Migration: Add event-triggered recording settings
+-- Date: 2026-10-16
+-- Description: Record only around events, with an in-memory pre-roll
+
+-- ============================================
+-- Recording Trigger Columns
+-- ============================================
+-- continuous: record all the time in 180 s segments
+-- event:      keep a pre-roll in memory, record when a row lands in events
+--             (API: POST /api/cameras/:id/trigger)
+-- motion:     like event, plus the recorder's own packet-size motion detector
+DO $$ 
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='cameras' AND column_name='recording_trigger') THEN
+        ALTER TABLE cameras ADD COLUMN recording_trigger VARCHAR(20) DEFAULT 'continuous';
+        ALTER TABLE cameras ADD CONSTRAINT check_recording_trigger
+            CHECK (recording_trigger IN ('continuous', 'event', 'motion'));
+    END IF;
+
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='cameras' AND column_name='pre_roll_seconds') THEN
+        ALTER TABLE cameras ADD COLUMN pre_roll_seconds INT DEFAULT 10;
+    END IF;
+
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='cameras' AND column_name='post_roll_seconds') THEN
+        ALTER TABLE cameras ADD COLUMN post_roll_seconds INT DEFAULT 30;
+    END IF;
+END $$;
+
+COMMENT ON COLUMN cameras.recording_trigger IS 'Recording trigger: continuous, event, motion';
+COMMENT ON COLUMN cameras.pre_roll_seconds IS 'Seconds of video kept in memory before an event';
+COMMENT ON COLUMN cameras.post_roll_seconds IS 'Seconds recorded after the last event';
+
+-- The recorder polls new events by insertion time
+CREATE INDEX IF NOT EXISTS idx_events_created ON events(created_at);
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: event-triggered recording columns added';
+END $$;
@@ -0,0 +1,26 @@
+-- Migration: Index recordings by file path
+-- Date: 2026-10-16
+-- Description: The recorder's tier mover rewrites filepath and storage_tier by path
+
+-- ============================================
+-- File Path Index
+-- ============================================
+-- The tier mover runs UPDATE recordings SET filepath, storage_tier
+-- WHERE filepath = <old path> once per moved segment; the API's
+-- scan looks rows up by filepath too.
+CREATE INDEX IF NOT EXISTS idx_recordings_filepath ON recordings(filepath);
+
+DO $$ 
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM information_schema.table_constraints 
+                   WHERE table_name='recordings' AND constraint_name='check_storage_tier') THEN
+        ALTER TABLE recordings ADD CONSTRAINT check_storage_tier
+            CHECK (storage_tier IN ('hot', 'warm', 'cold'));
+    END IF;
+END $$;
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: recordings filepath index added';
+END $$;
@@ -0,0 +1,38 @@
+-- Migration: Add per-camera storage quotas
+-- Date: 2026-10-16
+-- Description: Byte and retention quotas per camera for fair-share eviction
+
+-- ============================================
+-- Storage Quota Columns
+-- ============================================
+-- storage_quota_gb: bytes a camera may keep over all storage tiers;
+--                   beyond it the camera's own oldest segments go first
+-- retention_days:   overrides RETENTION_DAYS for this camera
+-- NULL = no quota / global retention. Under disk pressure the recorder
+-- evicts what cameras hold beyond their quota, then shares the rest of
+-- the deficit in proportion to each camera's quota.
+DO $$ 
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='cameras' AND column_name='storage_quota_gb') THEN
+        ALTER TABLE cameras ADD COLUMN storage_quota_gb INT;
+        ALTER TABLE cameras ADD CONSTRAINT check_storage_quota_gb
+            CHECK (storage_quota_gb IS NULL OR storage_quota_gb > 0);
+    END IF;
+
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='cameras' AND column_name='retention_days') THEN
+        ALTER TABLE cameras ADD COLUMN retention_days INT;
+        ALTER TABLE cameras ADD CONSTRAINT check_retention_days
+            CHECK (retention_days IS NULL OR retention_days > 0);
+    END IF;
+END $$;
+
+COMMENT ON COLUMN cameras.storage_quota_gb IS 'Per camera storage quota in GB over all tiers (NULL = none)';
+COMMENT ON COLUMN cameras.retention_days IS 'Per camera retention in days (NULL = global RETENTION_DAYS)';
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: camera storage quota columns added';
+END $$;
@@ -0,0 +1,30 @@
+-- Migration: Segments packed into chunk files
+-- Date: 2026-10-16
+-- Description: A recording can be a byte range of a chunk file (RECORDING_CHUNK_MINUTES)
+
+-- ============================================
+-- Chunk Offset Column
+-- ============================================
+-- chunk_offset: NULL = filepath is the segment's own MP4 file;
+--               otherwise the segment is bytes
+--               [chunk_offset, chunk_offset + file_size) of the chunk
+--               file at filepath (listed in its .idx sidecar)
+-- Every segment of a chunk shares its filepath, so the tier mover's
+-- UPDATE by filepath moves them all together.
+DO $$ 
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM information_schema.columns 
+                   WHERE table_name='recordings' AND column_name='chunk_offset') THEN
+        ALTER TABLE recordings ADD COLUMN chunk_offset BIGINT;
+        ALTER TABLE recordings ADD CONSTRAINT check_chunk_offset
+            CHECK (chunk_offset IS NULL OR chunk_offset >= 0);
+    END IF;
+END $$;
+
+COMMENT ON COLUMN recordings.chunk_offset IS 'Byte offset of the segment in a chunk file (NULL = own file)';
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: recordings chunk_offset column added';
+END $$;
@@ -0,0 +1,57 @@
+-- Migration: Notify the recorder of camera changes
+-- Date: 2026-10-16
+-- Description: NOTIFY camera_changes on insert/delete/edit of cameras, so the recorder reconciles without a restart
+
+-- ============================================
+-- Notify Function
+-- ============================================
+-- Payload = camera id. The recorder LISTENs on camera_changes, re-reads
+-- the named cameras and starts, stops or restarts just those recorders.
+-- Notifications are sent on commit; the same id twice in one
+-- transaction arrives once.
+CREATE OR REPLACE FUNCTION notify_camera_change()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('camera_changes', OLD.id::text);
+    ELSE
+        PERFORM pg_notify('camera_changes', NEW.id::text);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- ============================================
+-- Triggers
+-- ============================================
+-- Updates notify only when a column the recorder reads changes, so the
+-- recorder's own last_seen heartbeats stay silent.
+DO $$ 
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM pg_trigger WHERE tgname = 'notify_cameras_insert_delete') THEN
+        CREATE TRIGGER notify_cameras_insert_delete
+            AFTER INSERT OR DELETE ON cameras
+            FOR EACH ROW
+            EXECUTE FUNCTION notify_camera_change();
+    END IF;
+
+    IF NOT EXISTS (SELECT 1 FROM pg_trigger WHERE tgname = 'notify_cameras_update') THEN
+        CREATE TRIGGER notify_cameras_update
+            AFTER UPDATE ON cameras
+            FOR EACH ROW
+            WHEN ((OLD.name, OLD.rtsp_url, OLD.location, OLD.status, OLD.recording_mode, OLD.recording_trigger,
+                   OLD.pre_roll_seconds, OLD.post_roll_seconds, OLD.storage_quota_gb, OLD.retention_days)
+                  IS DISTINCT FROM
+                  (NEW.name, NEW.rtsp_url, NEW.location, NEW.status, NEW.recording_mode, NEW.recording_trigger,
+                   NEW.pre_roll_seconds, NEW.post_roll_seconds, NEW.storage_quota_gb, NEW.retention_days))
+            EXECUTE FUNCTION notify_camera_change();
+    END IF;
+END $$;
+
+COMMENT ON FUNCTION notify_camera_change() IS 'NOTIFY camera_changes with the camera id (recorder live reconciliation)';
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: camera change notifications added';
+END $$;
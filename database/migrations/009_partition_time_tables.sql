@@ -0,0 +1,208 @@
+-- Migration: Partition recordings, events and system_metrics by day
+-- Date: 2026-10-16
+-- Description: Daily range partitions created ahead of time; retention drops whole partitions instead of deleting rows
+
+-- ============================================
+-- Partition Functions
+-- ============================================
+-- Daily partitions <table>_pYYYYMMDD for [from_day, from_day + days).
+-- Rows of such a day already in the <table>_default partition are moved
+-- into the new partition (a DEFAULT partition holding rows of the range
+-- would make CREATE ... PARTITION OF fail).
+CREATE OR REPLACE FUNCTION create_time_partitions(parent REGCLASS, from_day DATE, days INT)
+RETURNS INT AS $$
+DECLARE
+    table_name TEXT := (SELECT relname FROM pg_class WHERE oid = parent);
+    default_name TEXT := table_name || '_default';
+    key_column TEXT;
+    day DATE;
+    partition_name TEXT;
+    has_rows BOOLEAN;
+    created INT := 0;
+BEGIN
+    PERFORM pg_advisory_xact_lock(hashtext('time_partitions'));
+
+    SELECT a.attname INTO key_column
+    FROM pg_partitioned_table p
+    JOIN pg_attribute a ON a.attrelid = p.partrelid AND a.attnum = p.partattrs[0]
+    WHERE p.partrelid = parent;
+    IF key_column IS NULL THEN
+        RAISE EXCEPTION '% is not partitioned', parent;
+    END IF;
+
+    FOR i IN 0 .. days - 1 LOOP
+        day := from_day + i;
+        partition_name := table_name || '_p' || to_char(day, 'YYYYMMDD');
+        CONTINUE WHEN to_regclass(partition_name) IS NOT NULL;
+
+        has_rows := FALSE;
+        IF to_regclass(default_name) IS NOT NULL THEN
+            EXECUTE format('SELECT EXISTS (SELECT 1 FROM %I WHERE %I >= %L AND %I < %L)',
+                           default_name, key_column, day, key_column, day + 1) INTO has_rows;
+        END IF;
+
+        IF has_rows THEN
+            EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS INCLUDING CONSTRAINTS)',
+                           partition_name, table_name);
+            EXECUTE format('WITH moved AS (DELETE FROM %I WHERE %I >= %L AND %I < %L RETURNING *) '
+                           'INSERT INTO %I SELECT * FROM moved',
+                           default_name, key_column, day, key_column, day + 1, partition_name);
+            EXECUTE format('ALTER TABLE %I ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                           table_name, partition_name, day, day + 1);
+        ELSE
+            EXECUTE format('CREATE TABLE %I PARTITION OF %I FOR VALUES FROM (%L) TO (%L)',
+                           partition_name, table_name, day, day + 1);
+        END IF;
+        created := created + 1;
+    END LOOP;
+    RETURN created;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Partitions of the time-partitioned tables from yesterday (time zone
+-- slack) to days_ahead days from today
+CREATE OR REPLACE FUNCTION ensure_time_partitions(days_ahead INT)
+RETURNS INT AS $$
+BEGIN
+    RETURN create_time_partitions('recordings', CURRENT_DATE - 1, days_ahead + 2)
+         + create_time_partitions('events', CURRENT_DATE - 1, days_ahead + 2)
+         + create_time_partitions('system_metrics', CURRENT_DATE - 1, days_ahead + 2);
+END;
+$$ LANGUAGE plpgsql;
+
+-- Retention: drop the daily partitions that end on or before cutoff and
+-- delete the rows before cutoff left in the DEFAULT partition. A drop
+-- waits at most 5 s for the table lock (fails, retried next run).
+CREATE OR REPLACE FUNCTION drop_time_partitions_before(parent REGCLASS, cutoff DATE)
+RETURNS INT AS $$
+DECLARE
+    table_name TEXT := (SELECT relname FROM pg_class WHERE oid = parent);
+    key_column TEXT;
+    partition_name TEXT;
+    dropped INT := 0;
+BEGIN
+    PERFORM pg_advisory_xact_lock(hashtext('time_partitions'));
+    PERFORM set_config('lock_timeout', '5s', true);
+
+    SELECT a.attname INTO key_column
+    FROM pg_partitioned_table p
+    JOIN pg_attribute a ON a.attrelid = p.partrelid AND a.attnum = p.partattrs[0]
+    WHERE p.partrelid = parent;
+    IF key_column IS NULL THEN
+        RAISE EXCEPTION '% is not partitioned', parent;
+    END IF;
+
+    FOR partition_name IN
+        SELECT c.relname FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid
+        WHERE i.inhparent = parent
+          AND CASE WHEN c.relname ~ ('^' || table_name || '_p[0-9]{8}$')
+                   THEN to_date(right(c.relname, 8), 'YYYYMMDD') + 1 <= cutoff
+                   ELSE FALSE END
+        ORDER BY c.relname
+    LOOP
+        EXECUTE format('DROP TABLE %I', partition_name);
+        dropped := dropped + 1;
+    END LOOP;
+
+    IF to_regclass(table_name || '_default') IS NOT NULL THEN
+        EXECUTE format('DELETE FROM %I WHERE %I < %L', table_name || '_default', key_column, cutoff);
+    END IF;
+    RETURN dropped;
+END;
+$$ LANGUAGE plpgsql;
+
+-- ============================================
+-- Convert Existing Tables
+-- ============================================
+-- A plain table is renamed, a partitioned one created LIKE it, its rows
+-- copied over (days older than 90 stay in the DEFAULT partition), and
+-- its indexes, unique and foreign keys, triggers and comment recreated.
+-- The primary key becomes (id, <partition column>). Tables that are
+-- already partitioned are left alone.
+CREATE FUNCTION pg_temp.partition_by_day(table_name TEXT, key_column TEXT)
+RETURNS VOID AS $$
+DECLARE
+    old_name TEXT := table_name || '_unpartitioned';
+    first_day DATE;
+    table_comment TEXT;
+    index_defs TEXT[];
+    constraint_defs TEXT[];
+    trigger_defs TEXT[];
+    def TEXT;
+BEGIN
+    IF (SELECT relkind FROM pg_class WHERE oid = to_regclass(table_name)) IS DISTINCT FROM 'r' THEN
+        RETURN;
+    END IF;
+
+    table_comment := obj_description(table_name::regclass, 'pg_class');
+    SELECT array_agg(pg_get_indexdef(i.indexrelid)) INTO index_defs
+    FROM pg_index i
+    WHERE i.indrelid = table_name::regclass
+      AND NOT EXISTS (SELECT 1 FROM pg_constraint c WHERE c.conindid = i.indexrelid);
+    SELECT array_agg(format('ALTER TABLE %I ADD CONSTRAINT %I %s', table_name, conname, pg_get_constraintdef(oid)))
+    INTO constraint_defs
+    FROM pg_constraint
+    WHERE conrelid = table_name::regclass AND contype IN ('u', 'f');
+    SELECT array_agg(pg_get_triggerdef(oid)) INTO trigger_defs
+    FROM pg_trigger
+    WHERE tgrelid = table_name::regclass AND NOT tgisinternal;
+
+    -- Foreign keys to this table (events.recording_id) need a unique
+    -- id, which a partitioned table only has together with the date
+    FOR def IN
+        SELECT format('ALTER TABLE %s DROP CONSTRAINT %I', conrelid::regclass, conname)
+        FROM pg_constraint
+        WHERE confrelid = table_name::regclass AND contype = 'f'
+    LOOP
+        EXECUTE def;
+    END LOOP;
+
+    EXECUTE format('UPDATE %I SET %I = CURRENT_TIMESTAMP WHERE %I IS NULL', table_name, key_column, key_column);
+    EXECUTE format('ALTER TABLE %I RENAME TO %I', table_name, old_name);
+    EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS INCLUDING CONSTRAINTS INCLUDING COMMENTS) '
+                   'PARTITION BY RANGE (%I)', table_name, old_name, key_column);
+    EXECUTE format('ALTER TABLE %I ALTER COLUMN %I SET NOT NULL', table_name, key_column);
+
+    EXECUTE format('SELECT min(%I)::date FROM %I', key_column, old_name) INTO first_day;
+    first_day := GREATEST(LEAST(COALESCE(first_day, CURRENT_DATE), CURRENT_DATE - 1), CURRENT_DATE - 90);
+    PERFORM create_time_partitions(table_name::regclass, first_day, CURRENT_DATE - first_day + 8);
+    EXECUTE format('CREATE TABLE %I PARTITION OF %I DEFAULT', table_name || '_default', table_name);
+
+    EXECUTE format('INSERT INTO %I SELECT * FROM %I', table_name, old_name);
+    EXECUTE format('DROP TABLE %I', old_name);
+
+    EXECUTE format('ALTER TABLE %I ADD PRIMARY KEY (id, %I)', table_name, key_column);
+    FOREACH def IN ARRAY COALESCE(constraint_defs, '{}') LOOP
+        EXECUTE def;
+    END LOOP;
+    FOREACH def IN ARRAY COALESCE(index_defs, '{}') LOOP
+        EXECUTE def;
+    END LOOP;
+    FOREACH def IN ARRAY COALESCE(trigger_defs, '{}') LOOP
+        EXECUTE def;
+    END LOOP;
+    EXECUTE format('COMMENT ON TABLE %I IS %L', table_name, table_comment);
+
+    RAISE NOTICE '% partitioned by day on %', table_name, key_column;
+END;
+$$ LANGUAGE plpgsql;
+
+-- recordings first: it drops the events.recording_id foreign key
+SELECT pg_temp.partition_by_day('recordings', 'start_time');
+SELECT pg_temp.partition_by_day('events', 'event_time');
+SELECT pg_temp.partition_by_day('system_metrics', 'recorded_at');
+
+-- Today and the week ahead; the recorder keeps creating them
+-- (RECORDER_PARTITION_DAYS_AHEAD) and drops expired ones
+SELECT ensure_time_partitions(7);
+
+COMMENT ON FUNCTION create_time_partitions(REGCLASS, DATE, INT) IS 'Create daily partitions <table>_pYYYYMMDD, moving matching rows out of <table>_default';
+COMMENT ON FUNCTION ensure_time_partitions(INT) IS 'Daily partitions of recordings, events and system_metrics from yesterday to days_ahead days ahead';
+COMMENT ON FUNCTION drop_time_partitions_before(REGCLASS, DATE) IS 'Retention: drop daily partitions ending on or before cutoff, and older rows of <table>_default';
+COMMENT ON COLUMN events.recording_id IS 'recordings.id (no foreign key: recordings is partitioned, its key is (id, start_time))';
+
+-- Print success message
+DO $$ 
+BEGIN
+    RAISE NOTICE 'Migration completed successfully: recordings, events and system_metrics partitioned by day';
+END $$;
@@ -19,7 +19,8 @@ module.exports = {
         QSV_HIGH_QUALITY: '1440p',
         RETENTION_DAYS: '2',
         MIN_FREE_SPACE_GB: '10',
-        CLEANUP_INTERVAL_HOURS: '1',
+        STORAGE_SAMPLE_SECONDS: '10',
+        EVICTION_HORIZON_MINUTES: '30',
         MAX_RETRIES: '10',
         RETRY_DELAY_SECONDS: '5',
         // MediaMTX health check settings
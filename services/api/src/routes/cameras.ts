@@ -113,6 +113,39 @@ router.put('/:id', async (req: Request, res: Response) => {
   }
 });
 
+// POST /api/cameras/:id/trigger - Start/extend an event recording
+// The recorder picks the event up from the events table (cameras with
+// recording_trigger 'event' or 'motion'; continuous cameras ignore it)
+router.post('/:id/trigger', async (req: Request, res: Response) => {
+  try {
+    const { id } = req.params;
+    const { event_type = 'manual', event_data = null } = req.body || {};
+    
+    const result = await pool.query(
+      'INSERT INTO events (camera_id, event_type, event_data, event_time) SELECT id, $2, $3, NOW() FROM cameras WHERE id = $1 RETURNING id, camera_id, event_type, event_time',
+      [id, event_type, event_data]
+    );
+    
+    if (result.rowCount === 0) {
+      return res.status(404).json({
+        success: false,
+        error: 'Camera not found'
+      });
+    }
+    
+    res.status(201).json({
+      success: true,
+      data: result.rows[0]
+    });
+  } catch (error) {
+    console.error('Error triggering recording:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to trigger recording'
+    });
+  }
+});
+
 // DELETE /api/cameras/:id - Delete camera
 router.delete('/:id', async (req: Request, res: Response) => {
   try {
@@ -205,6 +205,97 @@ router.get('/:id', optionalAuth, async (req: Request, res: Response) => {
   }
 });
 
+/**
+ * GET /api/recordings/live/:cameraId
+ * Stream the segment being recorded (near-live playback, supports range requests)
+ */
+router.get('/live/:cameraId', authenticate, async (req: Request, res: Response) => {
+  try {
+    const { cameraId } = req.params;
+    const segment = await recordingService.getCurrentSegment(cameraId);
+
+    if (!segment) {
+      return res.status(404).json({
+        success: false,
+        error: 'No recording in progress for this camera'
+      });
+    }
+
+    // The file keeps growing: serve what is on disk now, never cache
+    const fileSize = segment.file_size;
+    const base = segment.chunk_offset || 0;
+    const range = req.headers.range;
+
+    res.setHeader('Content-Type', 'video/mp4');
+    res.setHeader('Accept-Ranges', 'bytes');
+    res.setHeader('Cache-Control', 'no-store');
+
+    if (range) {
+      const parts = range.replace(/bytes=/, '').split('-');
+      const start = parseInt(parts[0], 10);
+      const end = parts[1] ? Math.min(parseInt(parts[1], 10), fileSize - 1) : fileSize - 1;
+
+      if (start >= fileSize || start > end) {
+        res.setHeader('Content-Range', `bytes */${fileSize}`);
+        return res.status(416).end();
+      }
+
+      res.status(206);
+      res.setHeader('Content-Range', `bytes ${start}-${end}/${fileSize}`);
+      res.setHeader('Content-Length', (end - start + 1).toString());
+      fs.createReadStream(segment.filepath, { start: base + start, end: base + end }).pipe(res);
+    } else {
+      res.setHeader('Content-Length', fileSize.toString());
+      fs.createReadStream(segment.filepath, { start: base, end: base + fileSize - 1 }).pipe(res);
+    }
+  } catch (error: any) {
+    console.error('[GET /api/recordings/live/:cameraId] Error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to stream current recording',
+      message: error.message
+    });
+  }
+});
+
+/**
+ * GET /api/recordings/seek/:cameraId?time=ISO
+ * Recording and byte offset for a point in time (keyframe sidecar, no video parsing).
+ * Play by fetching bytes [0, init_size) then [offset, ...) of /:id/stream.
+ */
+router.get('/seek/:cameraId', authenticate, async (req: Request, res: Response) => {
+  try {
+    const { cameraId } = req.params;
+    const time = new Date(req.query.time as string);
+    if (isNaN(time.getTime())) {
+      return res.status(400).json({
+        success: false,
+        error: 'time must be an ISO 8601 timestamp'
+      });
+    }
+
+    const position = await recordingService.seek(cameraId, time);
+    if (!position) {
+      return res.status(404).json({
+        success: false,
+        error: 'No indexed recording at this time'
+      });
+    }
+
+    res.json({
+      success: true,
+      data: position
+    });
+  } catch (error: any) {
+    console.error('[GET /api/recordings/seek/:cameraId] Error:', error);
+    res.status(500).json({
+      success: false,
+      error: 'Failed to resolve seek position',
+      message: error.message
+    });
+  }
+});
+
 /**
  * GET /api/recordings/:id/stream
  * Stream recording for video playback (supports range requests)
@@ -229,9 +320,11 @@ router.get('/:id/stream', authenticate, async (req: Request, res: Response) => {
       });
     }
 
-    // Get file stats
+    // Get file stats (a segment in a chunk file is a byte range of it)
     const stat = fs.statSync(recording.filepath);
-    const fileSize = stat.size;
+    const inChunk = recording.chunk_offset !== null;
+    const base = inChunk ? Number(recording.chunk_offset) : 0;
+    const fileSize = inChunk ? Number(recording.file_size) : stat.size;
     const range = req.headers.range;
 
     // Set content type
@@ -242,7 +335,7 @@ router.get('/:id/stream', authenticate, async (req: Request, res: Response) => {
       // Parse range header
       const parts = range.replace(/bytes=/, '').split('-');
       const start = parseInt(parts[0], 10);
-      const end = parts[1] ? parseInt(parts[1], 10) : fileSize - 1;
+      const end = parts[1] ? Math.min(parseInt(parts[1], 10), fileSize - 1) : fileSize - 1;
       const chunksize = (end - start) + 1;
 
       // Send partial content
@@ -250,12 +343,14 @@ router.get('/:id/stream', authenticate, async (req: Request, res: Response) => {
       res.setHeader('Content-Range', 'bytes ' + start + '-' + end + '/' + fileSize);
       res.setHeader('Content-Length', chunksize.toString());
 
-      const stream = fs.createReadStream(recording.filepath, { start, end });
+      const stream = fs.createReadStream(recording.filepath, { start: base + start, end: base + end });
       stream.pipe(res);
     } else {
       // Send full file
       res.setHeader('Content-Length', fileSize.toString());
-      const stream = fs.createReadStream(recording.filepath);
+      const stream = inChunk
+        ? fs.createReadStream(recording.filepath, { start: base, end: base + fileSize - 1 })
+        : fs.createReadStream(recording.filepath);
       stream.pipe(res);
     }
   } catch (error: any) {
@@ -299,13 +394,15 @@ router.get('/:id/download', authenticate, async (req: Request, res: Response) =>
 
     // Support range requests for video streaming
     const stat = fs.statSync(recording.filepath);
-    const fileSize = stat.size;
+    const inChunk = recording.chunk_offset !== null;
+    const base = inChunk ? Number(recording.chunk_offset) : 0;
+    const fileSize = inChunk ? Number(recording.file_size) : stat.size;
     const range = req.headers.range;
 
     if (range) {
       const parts = range.replace(/bytes=/, '').split('-');
       const start = parseInt(parts[0], 10);
-      const end = parts[1] ? parseInt(parts[1], 10) : fileSize - 1;
+      const end = parts[1] ? Math.min(parseInt(parts[1], 10), fileSize - 1) : fileSize - 1;
       const chunksize = (end - start) + 1;
 
       res.status(206);
@@ -313,10 +410,12 @@ router.get('/:id/download', authenticate, async (req: Request, res: Response) =>
       res.setHeader('Accept-Ranges', 'bytes');
       res.setHeader('Content-Length', chunksize.toString());
 
-      const stream = fs.createReadStream(recording.filepath, { start, end });
+      const stream = fs.createReadStream(recording.filepath, { start: base + start, end: base + end });
       stream.pipe(res);
     } else {
-      const stream = fs.createReadStream(recording.filepath);
+      const stream = inChunk
+        ? fs.createReadStream(recording.filepath, { start: base, end: base + fileSize - 1 })
+        : fs.createReadStream(recording.filepath);
       stream.pipe(res);
     }
   } catch (error: any) {
@@ -17,21 +17,32 @@ export interface VideoMetadata {
   format: string;          // e.g., "mp4"
 }
 
+// Segment stored inside a chunk file: bytes [offset, offset + length)
+export interface ByteRange {
+  offset: number;
+  length: number;
+}
+
 export class MetadataService {
   /**
    * Extract video metadata using ffprobe
+   *
+   * @param range Probe only this part of the file (segment in a chunk file)
    */
-  async extractMetadata(filePath: string): Promise<VideoMetadata> {
+  async extractMetadata(filePath: string, range?: ByteRange): Promise<VideoMetadata> {
     try {
       // Check if file exists
       await fs.access(filePath);
 
       // Get file size
       const stats = await fs.stat(filePath);
-      const fileSize = stats.size;
+      const fileSize = range ? range.length : stats.size;
 
       // Run ffprobe to get video metadata
-      const command = `ffprobe -v quiet -print_format json -show_format -show_streams "${filePath}"`;
+      const input = range
+        ? `subfile,,start,${range.offset},end,${range.offset + range.length},,:${filePath}`
+        : filePath;
+      const command = `ffprobe -v quiet -print_format json -show_format -show_streams "${input}"`;
       const { stdout } = await execAsync(command);
       const data = JSON.parse(stdout);
 
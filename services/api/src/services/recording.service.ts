@@ -9,6 +9,7 @@ export interface Recording {
   filename: string;
   filepath: string;
   file_size: number;
+  chunk_offset: number | null;   // Segment packed in the chunk file at filepath
   start_time: Date;
   end_time: Date | null;
   duration: number | null;
@@ -48,6 +49,51 @@ export interface RecordingStats {
   }>;
 }
 
+export interface CurrentSegment {
+  filename: string;
+  filepath: string;
+  file_size: number;
+  chunk_offset?: number;   // Chunk file: the segment starts here
+  modified_at: Date;
+}
+
+// Where playback from a point in time starts, from the .kidx sidecar
+export interface SeekPosition {
+  recording_id: string;
+  keyframe_time: Date;     // Wall clock of the IDR at or before the requested time
+  media_time: number;      // Its time in the segment (seconds, as the player sees it)
+  offset: number;          // Byte offset in the recording of the fragment holding it
+  init_size: number;       // Bytes [0, init_size) of the recording (ftyp+moov) go first
+}
+
+// One segment of a chunk file, from its .idx sidecar
+interface ChunkEntry {
+  offset: number;
+  length: number;
+  startMs: number;
+  durationMs: number;
+}
+
+// A segment written to within this window is still being recorded
+const IN_PROGRESS_SECONDS = 30;
+
+// Chunk index layout (recorder's ChunkIndex): magic, then 32-byte entries
+const CHUNK_INDEX_MAGIC = 'VMSCIX01';
+const CHUNK_INDEX_ENTRY_BYTES = 32;
+
+// Keyframe index layout (recorder's SeekIndex): magic, then 24-byte entries
+const SEEK_INDEX_MAGIC = 'VMSKIX01';
+const SEEK_INDEX_ENTRY_BYTES = 24;
+const SEEK_KEYFRAME = 1;
+const SEEK_INIT = 4;
+
+interface SeekEntry {
+  timeMs: number;
+  offset: number;
+  aux: number;
+  flags: number;
+}
+
 export class RecordingService {
   private getRecordingPath(): string {
     // Use env variable or default to project root
@@ -58,6 +104,206 @@ export class RecordingService {
     return path.join(__dirname, '..', '..', '..', 'data', 'recordings');
   }
 
+  /**
+   * Hot recording volumes: RECORDING_PATH plus RECORDING_VOLUMES (the
+   * recorder spreads cameras over them and may move one between segments)
+   */
+  private getHotPaths(): string[] {
+    const volumes = (process.env.RECORDING_VOLUMES || '')
+      .split(',')
+      .map(volume => volume.trim())
+      .filter(volume => volume.length > 0);
+    return [this.getRecordingPath(), ...volumes.filter(volume => volume !== this.getRecordingPath())];
+  }
+
+  /**
+   * Recording roots per storage tier; the recorder moves aged segments
+   * from hot to warm/cold and updates filepath and storage_tier itself
+   */
+  private getTierPaths(): { tier: string; root: string }[] {
+    const tiers = this.getHotPaths().map(root => ({ tier: 'hot', root }));
+    if (process.env.RECORDING_PATH_WARM) {
+      tiers.push({ tier: 'warm', root: process.env.RECORDING_PATH_WARM });
+    }
+    if (process.env.RECORDING_PATH_COLD) {
+      tiers.push({ tier: 'cold', root: process.env.RECORDING_PATH_COLD });
+    }
+    return tiers;
+  }
+
+  /**
+   * Segments listed in a chunk file's index (complete segments only)
+   */
+  private async readChunkIndex(chunkPath: string): Promise<ChunkEntry[]> {
+    const data = await fs.readFile(chunkPath.replace(/\.chunk$/, '.idx'));
+    const header = CHUNK_INDEX_MAGIC.length;
+    if (data.length < header || data.toString('latin1', 0, header) !== CHUNK_INDEX_MAGIC) {
+      throw new Error(`Not a chunk index: ${chunkPath}`);
+    }
+
+    const entries: ChunkEntry[] = [];
+    for (let pos = header; pos + CHUNK_INDEX_ENTRY_BYTES <= data.length; pos += CHUNK_INDEX_ENTRY_BYTES) {
+      entries.push({
+        offset: Number(data.readBigUInt64LE(pos)),
+        length: Number(data.readBigUInt64LE(pos + 8)),
+        startMs: Number(data.readBigInt64LE(pos + 16)),
+        durationMs: data.readUInt32LE(pos + 24)
+      });
+    }
+    return entries;
+  }
+
+  /**
+   * Init entry and last keyframe at or before a time of the segment at
+   * bytes [base, end) of a file, from its sidecar (<name>.kidx)
+   *
+   * Entries are fixed-size and in offset and time order, so both
+   * lookups are binary searches by positioned reads: a daily chunk's
+   * sidecar is never loaded whole.
+   */
+  private async findKeyframe(filepath: string, base: number, end: number,
+                             target: number): Promise<{ init: SeekEntry; keyframe: SeekEntry } | null> {
+    const handle = await fs.open(filepath.replace(/\.[^./]+$/, '') + '.kidx', 'r');
+    try {
+      const header = SEEK_INDEX_MAGIC.length;
+      const magic = Buffer.alloc(header);
+      const { bytesRead } = await handle.read(magic, 0, header, 0);
+      if (bytesRead < header || magic.toString('latin1') !== SEEK_INDEX_MAGIC) {
+        throw new Error(`Not a keyframe index: ${filepath}`);
+      }
+      const count = Math.floor(((await handle.stat()).size - header) / SEEK_INDEX_ENTRY_BYTES);
+
+      const data = Buffer.alloc(SEEK_INDEX_ENTRY_BYTES);
+      const readEntry = async (index: number): Promise<SeekEntry> => {
+        await handle.read(data, 0, SEEK_INDEX_ENTRY_BYTES, header + index * SEEK_INDEX_ENTRY_BYTES);
+        return {
+          timeMs: Number(data.readBigInt64LE(0)),
+          offset: Number(data.readBigUInt64LE(8)),
+          aux: data.readUInt32LE(16),
+          flags: data.readUInt32LE(20)
+        };
+      };
+      // First entry at or past a byte offset, from index `from`
+      const lowerBound = async (offset: number, from: number): Promise<number> => {
+        let low = from;
+        let high = count;
+        while (low < high) {
+          const mid = Math.floor((low + high) / 2);
+          if ((await readEntry(mid)).offset < offset) {
+            low = mid + 1;
+          } else {
+            high = mid;
+          }
+        }
+        return low;
+      };
+
+      // A chunk's sidecar covers all its segments: keep this one's entries
+      const first = base > 0 ? await lowerBound(base, 0) : 0;
+      const last = end < Number.MAX_SAFE_INTEGER ? await lowerBound(end, first) : count;
+      if (last - first < 2) {
+        return null;
+      }
+      const init = await readEntry(first);
+      if ((init.flags & SEEK_INIT) === 0 || init.offset !== base) {
+        return null;
+      }
+
+      // Last keyframe at or before the time, else the first one
+      let low = first + 1;
+      let high = last - 1;
+      while (low < high) {
+        const mid = Math.ceil((low + high) / 2);
+        if ((await readEntry(mid)).timeMs <= target) {
+          low = mid;
+        } else {
+          high = mid - 1;
+        }
+      }
+      const keyframe = await readEntry(low);
+      if ((keyframe.flags & SEEK_KEYFRAME) === 0) {
+        return null;
+      }
+      return { init, keyframe };
+    } finally {
+      await handle.close();
+    }
+  }
+
+  /**
+   * Name of a segment inside a chunk, as it would have been on its own:
+   * <camera>_YYYYMMDD_HHMMSS.mp4 (local time)
+   */
+  private chunkSegmentName(chunkPath: string, startTime: Date): string {
+    const prefix = path.basename(chunkPath).replace(/_\d{8}_\d{6}\.chunk$/, '');
+    const pad = (value: number) => value.toString().padStart(2, '0');
+    const date = `${startTime.getFullYear()}${pad(startTime.getMonth() + 1)}${pad(startTime.getDate())}`;
+    const time = `${pad(startTime.getHours())}${pad(startTime.getMinutes())}${pad(startTime.getSeconds())}`;
+    return `${prefix}_${date}_${time}.mp4`;
+  }
+
+  /**
+   * Sync the segments of one chunk file (one lookup per chunk)
+   */
+  private async syncChunk(
+    cameraId: string,
+    chunkPath: string,
+    tier: string
+  ): Promise<{ scanned: number; synced: number; errors: number }> {
+    const entries = await this.readChunkIndex(chunkPath);
+    const existing = await pool.query(
+      'SELECT chunk_offset FROM recordings WHERE filepath = $1',
+      [chunkPath]
+    );
+    const known = new Set(existing.rows.map(row => String(row.chunk_offset)));
+
+    let synced = 0;
+    let errors = 0;
+    for (const entry of entries) {
+      if (known.has(String(entry.offset))) {
+        continue;
+      }
+
+      const startTime = new Date(entry.startMs);
+      const filename = this.chunkSegmentName(chunkPath, startTime);
+      try {
+        const metadata = await metadataService.extractMetadata(chunkPath, {
+          offset: entry.offset,
+          length: entry.length
+        });
+        const duration = Math.floor(entry.durationMs / 1000);
+
+        await pool.query(
+          `INSERT INTO recordings 
+          (camera_id, filename, filepath, file_size, chunk_offset, start_time, end_time, 
+           duration, resolution, fps, codec, bitrate, storage_tier)
+          VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13)
+          ON CONFLICT (camera_id, start_time) DO NOTHING`,
+          [
+            cameraId,
+            filename,
+            chunkPath,
+            entry.length,
+            entry.offset,
+            startTime,
+            metadataService.calculateEndTime(startTime, duration),
+            duration,
+            metadata.resolution,
+            metadata.fps,
+            metadata.codec,
+            metadata.bitrate,
+            tier
+          ]
+        );
+        synced++;
+      } catch (error: any) {
+        console.error(`[RecordingService] Error processing ${filename} in ${chunkPath}:`, error.message);
+        errors++;
+      }
+    }
+    return { scanned: entries.length, synced, errors };
+  }
+
   /**
    * Scan file system and sync recordings to database
    */
@@ -74,81 +320,102 @@ export class RecordingService {
       const camerasResult = await pool.query('SELECT id, name FROM cameras');
       const cameras = camerasResult.rows;
 
-      for (const camera of cameras) {
-        const cameraPath = path.join(recordingPath, camera.name);
+      for (const { tier, root } of this.getTierPaths()) {
+        for (const camera of cameras) {
+          const cameraPath = path.join(root, camera.name);
         
-        try {
-          // Check if camera directory exists
-          await fs.access(cameraPath);
+          try {
+            // Check if camera directory exists
+            await fs.access(cameraPath);
           
-          // Read all files in camera directory
-          const files = await fs.readdir(cameraPath);
-          const mp4Files = files.filter(f => f.endsWith('.mp4'));
-
-          console.log(`[RecordingService] Found ${mp4Files.length} MP4 files for camera ${camera.name}`);
-
-          for (const filename of mp4Files) {
-            scanned++;
-            const filepath = path.join(cameraPath, filename);
-
-            try {
-              // Check if recording already exists in database
-              const existingResult = await pool.query(
-                'SELECT id FROM recordings WHERE filepath = $1',
-                [filepath]
-              );
-
-              if (existingResult.rows.length > 0) {
-                // Already in database, skip
-                continue;
-              }
-
-              // Extract metadata
-              const metadata = await metadataService.extractMetadata(filepath);
+            // Read all files in camera directory
+            const files = await fs.readdir(cameraPath);
+            const mp4Files = files.filter(f => f.endsWith('.mp4'));
+
+            console.log(`[RecordingService] Found ${mp4Files.length} MP4 files for camera ${camera.name} (${tier})`);
+
+            for (const filename of mp4Files) {
+              scanned++;
+              const filepath = path.join(cameraPath, filename);
+
+              try {
+                // Segment still being written (fragmented MP4): sync it once closed
+                const fileStat = await fs.stat(filepath);
+                if (Date.now() - fileStat.mtimeMs < IN_PROGRESS_SECONDS * 1000) {
+                  continue;
+                }
+
+                // Check if recording already exists in database
+                const existingResult = await pool.query(
+                  'SELECT id FROM recordings WHERE filepath = $1',
+                  [filepath]
+                );
+
+                if (existingResult.rows.length > 0) {
+                  // Already in database, skip
+                  continue;
+                }
+
+                // Extract metadata
+                const metadata = await metadataService.extractMetadata(filepath);
               
-              // Parse start time from filename
-              const startTime = metadataService.parseFilenameTimestamp(filename);
-              if (!startTime) {
-                console.warn(`[RecordingService] Could not parse timestamp from filename: ${filename}`);
+                // Parse start time from filename
+                const startTime = metadataService.parseFilenameTimestamp(filename);
+                if (!startTime) {
+                  console.warn(`[RecordingService] Could not parse timestamp from filename: ${filename}`);
+                  errors++;
+                  continue;
+                }
+
+                // Calculate end time
+                const endTime = metadataService.calculateEndTime(startTime, metadata.duration);
+
+                // Insert into database
+                await pool.query(
+                  `INSERT INTO recordings 
+                  (camera_id, filename, filepath, file_size, start_time, end_time, 
+                   duration, resolution, fps, codec, bitrate, storage_tier)
+                  VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12)
+                  ON CONFLICT (camera_id, start_time) DO NOTHING`,
+                  [
+                    camera.id,
+                    filename,
+                    filepath,
+                    metadata.fileSize,
+                    startTime,
+                    endTime,
+                    metadata.duration,
+                    metadata.resolution,
+                    metadata.fps,
+                    metadata.codec,
+                    metadata.bitrate,
+                    tier
+                  ]
+                );
+
+                synced++;
+                console.log(`[RecordingService] Synced: ${filename}`);
+              } catch (error: any) {
+                console.error(`[RecordingService] Error processing ${filename}:`, error.message);
                 errors++;
-                continue;
               }
+            }
 
-              // Calculate end time
-              const endTime = metadataService.calculateEndTime(startTime, metadata.duration);
-
-              // Insert into database
-              await pool.query(
-                `INSERT INTO recordings 
-                (camera_id, filename, filepath, file_size, start_time, end_time, 
-                 duration, resolution, fps, codec, bitrate, storage_tier)
-                VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12)
-                ON CONFLICT (camera_id, start_time) DO NOTHING`,
-                [
-                  camera.id,
-                  filename,
-                  filepath,
-                  metadata.fileSize,
-                  startTime,
-                  endTime,
-                  metadata.duration,
-                  metadata.resolution,
-                  metadata.fps,
-                  metadata.codec,
-                  metadata.bitrate,
-                  'hot' // Default storage tier
-                ]
-              );
-
-              synced++;
-              console.log(`[RecordingService] Synced: ${filename}`);
-            } catch (error: any) {
-              console.error(`[RecordingService] Error processing ${filename}:`, error.message);
-              errors++;
+            // Chunk files (RECORDING_CHUNK_MINUTES): segments come from the offset index
+            for (const filename of files.filter(f => f.endsWith('.chunk'))) {
+              try {
+                const result = await this.syncChunk(camera.id, path.join(cameraPath, filename), tier);
+                scanned += result.scanned;
+                synced += result.synced;
+                errors += result.errors;
+              } catch (error: any) {
+                console.error(`[RecordingService] Error processing ${filename}:`, error.message);
+                errors++;
+              }
             }
+          } catch (error: any) {
+            console.error(`[RecordingService] Error scanning camera ${camera.name}:`, error.message);
           }
-        } catch (error: any) {
-          console.error(`[RecordingService] Error scanning camera ${camera.name}:`, error.message);
         }
       }
 
@@ -216,6 +483,114 @@ export class RecordingService {
     return { recordings: result.rows, total };
   }
 
+  /**
+   * Segment a camera is recording right now (newest file, recently written)
+   *
+   * Segments are fragmented MP4, so the file is playable up to its last
+   * flushed fragment while the recorder is still appending to it. In a
+   * chunk file the segment being written starts after the last indexed one.
+   */
+  async getCurrentSegment(cameraId: string): Promise<CurrentSegment | null> {
+    const cameraResult = await pool.query('SELECT name FROM cameras WHERE id = $1', [cameraId]);
+    if (cameraResult.rows.length === 0) {
+      return null;
+    }
+
+    // <camera>_YYYYMMDD_HHMMSS.mp4|.chunk: newest name = newest segment,
+    // on whichever volume the camera writes to now
+    let newest: string | undefined;
+    let cameraPath = '';
+    for (const root of this.getHotPaths()) {
+      const dir = path.join(root, cameraResult.rows[0].name);
+      let files: string[];
+      try {
+        files = await fs.readdir(dir);
+      } catch {
+        continue;
+      }
+      const candidate = files.filter(f => f.endsWith('.mp4') || f.endsWith('.chunk')).sort().pop();
+      if (candidate && (!newest || candidate > newest)) {
+        newest = candidate;
+        cameraPath = dir;
+      }
+    }
+    if (!newest) {
+      return null;
+    }
+
+    const filepath = path.join(cameraPath, newest);
+    const stat = await fs.stat(filepath);
+    if (Date.now() - stat.mtimeMs >= IN_PROGRESS_SECONDS * 1000) {
+      return null;
+    }
+
+    if (newest.endsWith('.chunk')) {
+      const last = (await this.readChunkIndex(filepath)).pop();
+      const offset = last ? last.offset + last.length : 0;
+      if (stat.size <= offset) {
+        return null;
+      }
+      return {
+        filename: newest,
+        filepath,
+        file_size: stat.size - offset,
+        chunk_offset: offset,
+        modified_at: stat.mtime
+      };
+    }
+
+    return {
+      filename: newest,
+      filepath,
+      file_size: stat.size,
+      modified_at: stat.mtime
+    };
+  }
+
+  /**
+   * Resolve a point in time to a recording and byte offset (one
+   * indexed query and a binary search of the keyframe sidecar; the
+   * video is not opened)
+   *
+   * Returns null if no recording covers the time or it has no sidecar
+   * (classic MP4, recorded before keyframe indexing).
+   */
+  async seek(cameraId: string, time: Date): Promise<SeekPosition | null> {
+    const result = await pool.query(
+      `SELECT id, filepath, file_size, chunk_offset
+       FROM recordings
+       WHERE camera_id = $1 AND start_time <= $2 AND (end_time IS NULL OR end_time >= $2)
+       ORDER BY start_time DESC
+       LIMIT 1`,
+      [cameraId, time]
+    );
+    if (result.rows.length === 0) {
+      return null;
+    }
+    const recording = result.rows[0];
+
+    const base = recording.chunk_offset !== null ? Number(recording.chunk_offset) : 0;
+    const end = recording.chunk_offset !== null ? base + Number(recording.file_size) : Number.MAX_SAFE_INTEGER;
+    let found: { init: SeekEntry; keyframe: SeekEntry } | null;
+    try {
+      found = await this.findKeyframe(recording.filepath, base, end, time.getTime());
+    } catch {
+      return null;
+    }
+    if (!found) {
+      return null;
+    }
+    const { init, keyframe } = found;
+
+    return {
+      recording_id: recording.id,
+      keyframe_time: new Date(keyframe.timeMs),
+      media_time: keyframe.aux / 1000,
+      offset: keyframe.offset - base,
+      init_size: init.aux
+    };
+  }
+
   /**
    * Get single recording by ID
    */
@@ -241,7 +616,7 @@ export class RecordingService {
       await client.query('BEGIN');
 
       // Get recording info
-      const result = await client.query('SELECT filepath FROM recordings WHERE id = $1', [id]);
+      const result = await client.query('SELECT filepath, chunk_offset FROM recordings WHERE id = $1', [id]);
       if (result.rows.length === 0) {
         return false;
       }
@@ -251,9 +626,16 @@ export class RecordingService {
       // Delete from database
       await client.query('DELETE FROM recordings WHERE id = $1', [id]);
 
+      // A chunk file holds other segments too: it goes when the whole chunk expires
+      if (result.rows[0].chunk_offset !== null) {
+        await client.query('COMMIT');
+        return true;
+      }
+
       // Delete file from file system
       try {
         await fs.unlink(filepath);
+        await fs.unlink(filepath.replace(/\.[^./]+$/, '') + '.kidx').catch(() => undefined);
         console.log(`[RecordingService] Deleted file: ${filepath}`);
       } catch (error: any) {
         console.warn(`[RecordingService] Could not delete file ${filepath}:`, error.message);
@@ -0,0 +1,317 @@
+/**
+ * Camera control-loop benchmark
+ *
+ * Runs N simulated cameras through CameraRecorder + CameraReactor and
+ * reports the cost of supervising them: process CPU time, thread count
+ * and how long it takes to notice a pipeline exit. Pipelines are fakes
+ * (eventfd + scheduled state changes), no media is touched.
+ *
+ * --poll runs the previous model for comparison: one thread per camera
+ * polling checkStatus() every 5 seconds with sleep_for.
+ *
+ * Usage: reactor_benchmark [--cameras N] [--seconds S] [--threads T] [--poll]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <random>
+#include <sys/resource.h>
+#include "camera_recorder.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Fires pipeline state changes at scheduled times from one thread
+ */
+class EventScheduler {
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::multimap<Clock::time_point, std::function<void()>> events;
+    bool stopping = false;
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (events.empty()) {
+                cv.wait(lock);
+                continue;
+            }
+            auto next = events.begin();
+            if (cv.wait_until(lock, next->first) == std::cv_status::no_timeout) {
+                continue;
+            }
+            auto action = std::move(next->second);
+            events.erase(next);
+            lock.unlock();
+            action();
+            lock.lock();
+        }
+    }
+
+public:
+    EventScheduler() : thread(&EventScheduler::run, this) {}
+
+    ~EventScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        thread.join();
+    }
+
+    void schedule(Clock::time_point when, std::function<void()> action) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.emplace(when, std::move(action));
+        cv.notify_all();
+    }
+};
+
+struct LatencyLog {
+    std::mutex mutex;
+    std::vector<int64_t> exitDetectionUs;
+    uint64_t pipelinesStarted = 0;
+
+    void record(int64_t us) {
+        std::lock_guard<std::mutex> lock(mutex);
+        exitDetectionUs.push_back(us);
+    }
+};
+
+/**
+ * Pipeline stand-in: opens its "stream" after a short probe and exits
+ * after a random run time, signalling both through an eventfd
+ */
+class SimulatedPipeline : public RecordingPipeline {
+private:
+    struct State {
+        std::atomic<bool> running{false};
+        std::atomic<bool> streaming{false};
+        std::atomic<int64_t> exitedAtUs{0};
+        int eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ~State() { close(eventFd); }
+        void notify() {
+            uint64_t one = 1;
+            if (write(eventFd, &one, sizeof(one)) < 0) {}
+        }
+    };
+
+    std::shared_ptr<State> state;   // Shared with scheduled events
+    EventScheduler& scheduler;
+    LatencyLog& log;
+    std::chrono::milliseconds probeTime;
+    std::chrono::milliseconds runTime;
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+public:
+    SimulatedPipeline(EventScheduler& s, LatencyLog& l, std::chrono::milliseconds probe, std::chrono::milliseconds run)
+        : state(std::make_shared<State>()), scheduler(s), log(l), probeTime(probe), runTime(run) {}
+
+    ~SimulatedPipeline() override {
+        int64_t exitedAt = state->exitedAtUs;
+        if (exitedAt > 0) {
+            log.record(nowUs() - exitedAt);
+        }
+    }
+
+    bool start() override {
+        state->running = true;
+        {
+            std::lock_guard<std::mutex> lock(log.mutex);
+            log.pipelinesStarted++;
+        }
+        std::weak_ptr<State> weak = state;
+        auto now = Clock::now();
+        scheduler.schedule(now + probeTime, [weak] {
+            if (auto s = weak.lock()) {
+                s->streaming = true;
+                s->notify();
+            }
+        });
+        scheduler.schedule(now + probeTime + runTime, [weak] {
+            if (auto s = weak.lock()) {
+                s->running = false;
+                s->streaming = false;
+                s->exitedAtUs = nowUs();
+                s->notify();
+            }
+        });
+        return true;
+    }
+
+    bool checkStatus() override { return state->running; }
+    void stop() override { state->running = false; }
+    bool getIsRunning() const override { return state->running; }
+    bool isStreaming() const override { return state->streaming; }
+    int getEventFd() const override { return state->eventFd; }
+    EncoderType getEncoderType() const override { return ENCODER_SOFTWARE; }
+    std::string getEncoderName() const override { return "simulated"; }
+    std::string getBackendName() const override { return "simulated"; }
+};
+
+/**
+ * Previous supervision model: thread per camera, 5 s sleep-poll
+ */
+void legacyCameraLoop(std::atomic<bool>& shouldRun, const std::function<RecordingPipeline*()>& create,
+                      int retryDelaySeconds) {
+    while (shouldRun) {
+        RecordingPipeline* pipeline = create();
+        pipeline->start();
+        while (shouldRun && pipeline->checkStatus()) {
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+        }
+        delete pipeline;
+        if (shouldRun) {
+            std::this_thread::sleep_for(std::chrono::seconds(retryDelaySeconds));
+        }
+    }
+}
+
+double cpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+int threadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            return std::atoi(line.c_str() + 8);
+        }
+    }
+    return -1;
+}
+
+int64_t percentile(std::vector<int64_t> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t)(p * (values.size() - 1)));
+    return values[index];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int cameras = 1000;
+    int seconds = 30;
+    size_t reactorThreads = 0;
+    bool poll = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--cameras" && i + 1 < argc) cameras = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) reactorThreads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--poll") poll = true;
+        else {
+            std::fprintf(stderr, "Usage: %s [--cameras N] [--seconds S] [--threads T] [--poll]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Recorder logs go nowhere, results are printed with stdio
+    std::ofstream devNull("/dev/null");
+    std::cout.rdbuf(devNull.rdbuf());
+    std::cerr.rdbuf(devNull.rdbuf());
+
+    EventScheduler scheduler;
+    LatencyLog log;
+    std::mt19937 rng(42);
+    std::mutex rngMutex;
+    const int retryDelaySeconds = 1;
+
+    auto makePipeline = [&]() -> RecordingPipeline* {
+        std::lock_guard<std::mutex> lock(rngMutex);
+        std::uniform_int_distribution<int> probe(100, 2000);
+        std::uniform_int_distribution<int> run(5000, 20000);
+        return new SimulatedPipeline(scheduler, log, std::chrono::milliseconds(probe(rng)),
+                                     std::chrono::milliseconds(run(rng)));
+    };
+
+    auto storage = std::make_shared<StorageManager>("/tmp/vms-reactor-benchmark", 2, 0);
+    auto reactor = std::make_shared<CameraReactor>(reactorThreads);
+    std::vector<std::unique_ptr<CameraRecorder>> recorders;
+    std::vector<std::thread> legacyThreads;
+    std::atomic<bool> legacyRun(true);
+
+    double cpuStart = cpuSeconds();
+    auto wallStart = Clock::now();
+
+    if (poll) {
+        for (int i = 0; i < cameras; i++) {
+            legacyThreads.emplace_back(legacyCameraLoop, std::ref(legacyRun), makePipeline, retryDelaySeconds);
+        }
+    } else {
+        reactor->start();
+        for (int i = 0; i < cameras; i++) {
+            std::string id = "bench" + std::to_string(i);
+            auto recorder = std::make_unique<CameraRecorder>(i, id, id, "rtsp://simulated/" + id,
+                                                             storage, reactor, 1000000, retryDelaySeconds);
+            recorder->setPipelineFactory(makePipeline);
+            recorder->start();
+            recorders.push_back(std::move(recorder));
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds) / 2);
+    int threads = threadCount();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds) - std::chrono::seconds(seconds) / 2);
+
+    double cpuUsed = cpuSeconds() - cpuStart;
+    double wall = std::chrono::duration<double>(Clock::now() - wallStart).count();
+
+    int running = 0;
+    for (auto& recorder : recorders) {
+        if (recorder->getState() == CameraState::RUNNING) running++;
+    }
+
+    std::vector<int64_t> latencies;
+    uint64_t started;
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        latencies = log.exitDetectionUs;
+        started = log.pipelinesStarted;
+    }
+
+    std::printf("mode:               %s\n", poll ? "thread per camera, 5 s poll" : "epoll reactor");
+    std::printf("cameras:            %d\n", cameras);
+    if (!poll) {
+        std::printf("reactor threads:    %zu\n", reactor->getThreadCount());
+        std::printf("events dispatched:  %llu\n", (unsigned long long)reactor->getEventsDispatched());
+        std::printf("cameras running:    %d\n", running);
+    }
+    std::printf("process threads:    %d\n", threads);
+    std::printf("pipelines started:  %llu\n", (unsigned long long)started);
+    std::printf("CPU time:           %.3f s over %.1f s (%.2f%% of one core)\n", cpuUsed, wall, 100.0 * cpuUsed / wall);
+    std::printf("exit detection:     p50 %.3f ms, p99 %.3f ms, max %.3f ms (%zu exits)\n",
+                percentile(latencies, 0.50) / 1000.0, percentile(latencies, 0.99) / 1000.0,
+                percentile(latencies, 1.0) / 1000.0, latencies.size());
+    std::fflush(stdout);
+
+    for (auto& recorder : recorders) {
+        recorder->stop();
+    }
+    recorders.clear();
+    reactor->stop();
+
+    legacyRun = false;
+    for (auto& thread : legacyThreads) {
+        thread.join();
+    }
+    return 0;
+}
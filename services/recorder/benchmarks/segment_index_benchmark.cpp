@@ -0,0 +1,195 @@
+/**
+ * Segment index benchmark
+ *
+ * Builds a synthetic recording tree (sparse .mp4 files, 180 s apart,
+ * spread over camera directories) and compares retention cleanup
+ * done the old way (directory walk with last_write_time + file_size on
+ * every file) against SegmentIndex: one startup rebuild, then pops from
+ * the oldest end. Nothing is deleted; only the cost of finding what to
+ * delete is measured. Page cache is warm for both.
+ *
+ * Usage: segment_index_benchmark [--files N] [--cameras C] [--expire PCT]
+ *                                [--root DIR] [--keep]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "segment_index.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int SEGMENT_SECONDS = 180;
+constexpr off_t SEGMENT_BYTES = 45LL * 1024 * 1024;   // 2 Mbps x 180 s, sparse
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Create <root>/camN/camN_YYYYMMDD_HHMMSS.mp4 with matching mtimes
+ */
+bool buildTree(const std::string& root, size_t files, int cameras, std::time_t newest) {
+    size_t perCamera = (files + cameras - 1) / cameras;
+    std::time_t oldest = newest - (std::time_t)perCamera * SEGMENT_SECONDS;
+
+    for (int c = 0; c < cameras; c++) {
+        std::string name = "cam" + std::to_string(c);
+        std::string dir = root + "/" + name;
+        fs::create_directories(dir);
+
+        for (size_t i = 0; i < perCamera && (size_t)c * perCamera + i < files; i++) {
+            std::time_t start = oldest + (std::time_t)i * SEGMENT_SECONDS;
+            std::tm tm = *std::localtime(&start);
+            char stamp[32];
+            std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+            std::string path = dir + "/" + name + "_" + stamp + ".mp4";
+
+            int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                std::perror(path.c_str());
+                return false;
+            }
+            if (ftruncate(fd, SEGMENT_BYTES) != 0) {
+                std::perror("ftruncate");
+            }
+            timespec times[2];
+            times[0].tv_sec = times[1].tv_sec = start + SEGMENT_SECONDS;
+            times[0].tv_nsec = times[1].tv_nsec = 0;
+            futimens(fd, times);
+            close(fd);
+        }
+    }
+    return true;
+}
+
+/**
+ * The pre-index cleanupOldRecordings() scan
+ */
+size_t legacyScan(const std::string& root, std::time_t cutoff, uint64_t& bytes) {
+    auto cutoffTime = std::chrono::system_clock::from_time_t(cutoff);
+    size_t matched = 0;
+    bytes = 0;
+    for (const auto& cameraDir : fs::directory_iterator(root)) {
+        if (!fs::is_directory(cameraDir)) continue;
+        for (const auto& entry : fs::directory_iterator(cameraDir)) {
+            if (!entry.is_regular_file()) continue;
+            if (entry.path().extension() != ".mp4") continue;
+
+            auto fileTime = fs::last_write_time(entry);
+            auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+                fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+            if (sctp < cutoffTime) {
+                bytes += fs::file_size(entry);
+                matched++;
+            }
+        }
+    }
+    return matched;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t files = 1000000;
+    int cameras = 200;
+    double expirePercent = 100.0 / 30;   // One day of a 30 day retention
+    std::string root = "/tmp/vms-segment-index-benchmark";
+    bool keep = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--files" && i + 1 < argc) files = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--cameras" && i + 1 < argc) cameras = std::atoi(argv[++i]);
+        else if (arg == "--expire" && i + 1 < argc) expirePercent = std::atof(argv[++i]);
+        else if (arg == "--root" && i + 1 < argc) root = argv[++i];
+        else if (arg == "--keep") keep = true;
+        else {
+            std::fprintf(stderr, "Usage: %s [--files N] [--cameras C] [--expire PCT] [--root DIR] [--keep]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+    if (cameras <= 0 || files == 0) {
+        std::fprintf(stderr, "--files and --cameras must be positive\n");
+        return 1;
+    }
+
+    // Index logs go nowhere, results are printed with stdio
+    std::ofstream devNull("/dev/null");
+    std::streambuf* coutBuf = std::cout.rdbuf(devNull.rdbuf());
+    std::streambuf* cerrBuf = std::cerr.rdbuf(devNull.rdbuf());
+
+    std::time_t now = std::time(nullptr);
+    size_t perCamera = (files + cameras - 1) / cameras;
+    std::time_t span = (std::time_t)perCamera * SEGMENT_SECONDS;
+    std::time_t cutoff = now - span + (std::time_t)(span * expirePercent / 100.0);
+
+    bool reuse = fs::exists(root) && !fs::is_empty(root);
+    auto buildStart = Clock::now();
+    if (!reuse && !buildTree(root, files, cameras, now)) {
+        return 1;
+    }
+    double buildSeconds = secondsSince(buildStart);
+
+    uint64_t legacyBytes = 0;
+    auto legacyStart = Clock::now();
+    size_t legacyMatched = legacyScan(root, cutoff, legacyBytes);
+    double legacySeconds = secondsSince(legacyStart);
+
+    SegmentIndex index;
+    auto rebuildStart = Clock::now();
+    size_t indexed = index.rebuild(root);
+    double rebuildSeconds = secondsSince(rebuildStart);
+
+    auto retentionStart = Clock::now();
+    std::vector<SegmentIndex::Segment> expired = index.popOlderThan(cutoff);
+    double retentionSeconds = secondsSince(retentionStart);
+    uint64_t expiredBytes = 0;
+    for (const auto& segment : expired) {
+        expiredBytes += segment.size;
+    }
+
+    const uint64_t evictBytes = 50ULL * 1024 * 1024 * 1024;
+    auto evictStart = Clock::now();
+    std::vector<SegmentIndex::Segment> evicted = index.popOldest(evictBytes);
+    double evictSeconds = secondsSince(evictStart);
+
+    auto closeStart = Clock::now();
+    for (int c = 0; c < cameras; c++) {
+        std::string dir = root + "/cam" + std::to_string(c);
+        index.add(dir, dir + "/new.mp4", SEGMENT_BYTES, now + SEGMENT_SECONDS);
+    }
+    double closeUs = secondsSince(closeStart) * 1e6 / cameras;
+
+    std::printf("tree:               %zu files, %d cameras%s (%.1f s to build)\n", indexed, cameras,
+                reuse ? ", reused" : "", buildSeconds);
+    std::printf("expired:            %zu segments, %.1f GB (legacy scan found %zu, %.1f GB)\n",
+                expired.size(), expiredBytes / 1073741824.0, legacyMatched, legacyBytes / 1073741824.0);
+    std::printf("legacy scan:        %.3f s per cleanup (%zu files stat'ed)\n", legacySeconds, indexed);
+    std::printf("index rebuild:      %.3f s once at startup\n", rebuildSeconds);
+    std::printf("index retention:    %.3f ms per cleanup (%.0fx faster)\n", retentionSeconds * 1000,
+                retentionSeconds > 0 ? legacySeconds / retentionSeconds : 0.0);
+    std::printf("index evict 50 GB:  %.3f ms (%zu segments)\n", evictSeconds * 1000, evicted.size());
+    std::printf("segment close:      %.2f us per add\n", closeUs);
+    std::fflush(stdout);
+
+    if (!keep && !reuse) {
+        fs::remove_all(root);
+    }
+    std::cout.rdbuf(coutBuf);
+    std::cerr.rdbuf(cerrBuf);
+    return 0;
+}
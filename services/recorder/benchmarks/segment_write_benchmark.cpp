@@ -0,0 +1,288 @@
+/**
+ * Segment write benchmark
+ *
+ * Simulates many cameras appending to their segments at once (one
+ * writer, round-robin chunks, like fragment flushes arriving from
+ * every camera) while a neighbour service does random 4 KB reads over
+ * its working set, which was warm in the page cache at the start.
+ * Runs twice: plain appends, then SegmentFile with preallocation and
+ * write-behind.
+ *
+ * Reported per run:
+ * - extents per segment (FIEMAP), i.e. file system fragmentation
+ * - neighbour read latency p50/p99/max and how much of its working set
+ *   is still cached afterwards (mincore)
+ * - how much of the written video is still in the page cache
+ *
+ * For the read latency to mean anything, write more than the free
+ * memory (--cameras x --segments x --segment-mb).
+ *
+ * Usage: segment_write_benchmark [--cameras N] [--segments S] [--segment-mb MB]
+ *                                [--chunk-kb KB] [--working-set-mb MB] [--dir DIR]
+ *                                [--only plain|tuned]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#include "segment_file.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double writeSeconds = 0;
+    double extentsPerSegment = 0;
+    double readP50Us = 0;
+    double readP99Us = 0;
+    double readMaxUs = 0;
+    size_t reads = 0;
+    double workingSetCached = 0;   // Fraction
+    double videoCachedMB = 0;
+};
+
+/**
+ * Number of extents (FIEMAP_FLAG_SYNC: delayed allocation resolved first)
+ */
+long countExtents(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct fiemap map;
+    std::memset(&map, 0, sizeof(map));
+    map.fm_length = FIEMAP_MAX_OFFSET;
+    map.fm_flags = FIEMAP_FLAG_SYNC;
+    map.fm_extent_count = 0;   // Count only
+    long extents = ioctl(fd, FS_IOC_FIEMAP, &map) == 0 ? (long)map.fm_mapped_extents : -1;
+    close(fd);
+    return extents;
+}
+
+/**
+ * Bytes of a file resident in the page cache
+ */
+uint64_t cachedBytes(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return 0;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    size_t pages = ((size_t)st.st_size + pageSize - 1) / pageSize;
+    std::vector<unsigned char> resident(pages);
+    uint64_t bytes = 0;
+    if (mincore(mapping, (size_t)st.st_size, resident.data()) == 0) {
+        for (unsigned char page : resident) {
+            if (page & 1) bytes += (uint64_t)pageSize;
+        }
+    }
+    munmap(mapping, (size_t)st.st_size);
+    return bytes;
+}
+
+bool createWorkingSet(const std::string& path, uint64_t bytes) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    std::vector<char> block(1024 * 1024, 'x');
+    for (uint64_t written = 0; written < bytes; written += block.size()) {
+        if (write(fd, block.data(), block.size()) != (ssize_t)block.size()) {
+            close(fd);
+            return false;
+        }
+    }
+    fsync(fd);
+    close(fd);
+    return true;
+}
+
+void warm(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    std::vector<char> block(1024 * 1024);
+    while (read(fd, block.data(), block.size()) > 0) {
+    }
+    close(fd);
+}
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0;
+    size_t index = std::min(samples.size() - 1, (size_t)(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+Result run(const std::string& dir, const std::string& workingSet, uint64_t workingSetBytes, int cameras,
+           int segments, uint64_t segmentBytes, size_t chunkBytes, bool tuned) {
+    Result result;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    warm(workingSet);
+
+    // Neighbour: random 4 KB reads until the writers are done
+    std::atomic<bool> writing(true);
+    std::vector<double> latencies;
+    std::thread reader([&] {
+        int fd = open(workingSet.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        std::mt19937_64 random(42);
+        std::uniform_int_distribution<uint64_t> block(0, workingSetBytes / 4096 - 1);
+        char buffer[4096];
+        while (writing) {
+            auto started = Clock::now();
+            if (pread(fd, buffer, sizeof(buffer), (off_t)(block(random) * 4096)) < 0) break;
+            latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - started).count());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        close(fd);
+    });
+
+    SegmentFile::Options options;
+    options.preallocate = tuned;
+    options.dropCache = tuned;
+    std::vector<std::unique_ptr<SegmentFile>> files;
+    for (int c = 0; c < cameras; c++) {
+        files.emplace_back(new SegmentFile(options));
+    }
+    std::vector<char> chunk(chunkBytes, 'v');
+    std::vector<std::string> paths;
+
+    auto writeStart = Clock::now();
+    for (int s = 0; s < segments; s++) {
+        for (int c = 0; c < cameras; c++) {
+            std::string path = dir + "/cam" + std::to_string(c) + "_" + std::to_string(s) + ".mp4";
+            // Expected size a little off, like a bitrate estimate
+            files[c]->open(path, segmentBytes + segmentBytes / 10);
+            paths.push_back(path);
+        }
+        for (uint64_t offset = 0; offset < segmentBytes; offset += chunkBytes) {
+            for (int c = 0; c < cameras; c++) {
+                files[c]->write(reinterpret_cast<const uint8_t*>(chunk.data()), (int)chunkBytes);
+            }
+        }
+        for (int c = 0; c < cameras; c++) {
+            files[c]->close();
+        }
+    }
+    result.writeSeconds = std::chrono::duration<double>(Clock::now() - writeStart).count();
+    writing = false;
+    reader.join();
+
+    long extents = 0;
+    uint64_t videoCached = 0;
+    for (const auto& path : paths) {
+        videoCached += cachedBytes(path);
+    }
+    for (const auto& path : paths) {
+        extents += std::max(countExtents(path), 0L);
+    }
+    result.extentsPerSegment = (double)extents / paths.size();
+    result.videoCachedMB = videoCached / (1024.0 * 1024.0);
+    result.workingSetCached = (double)cachedBytes(workingSet) / workingSetBytes;
+    result.reads = latencies.size();
+    result.readP50Us = percentile(latencies, 0.50);
+    result.readP99Us = percentile(latencies, 0.99);
+    result.readMaxUs = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+    return result;
+}
+
+void print(const char* name, const Result& r, uint64_t totalBytes) {
+    std::printf("%-6s write %6.1f s (%6.0f MB/s)  extents/segment %6.1f  "
+                "neighbour read p50 %7.1f us p99 %8.1f us max %9.1f us (%zu reads)  "
+                "working set cached %5.1f%%  video cached %7.0f MB\n",
+                name, r.writeSeconds, totalBytes / (1024.0 * 1024.0) / r.writeSeconds, r.extentsPerSegment,
+                r.readP50Us, r.readP99Us, r.readMaxUs, r.reads, r.workingSetCached * 100, r.videoCachedMB);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int cameras = 32;
+    int segments = 2;
+    uint64_t segmentMB = 45;        // 2 Mbps x 180 s
+    size_t chunkKB = 256;           // One fragment flush
+    uint64_t workingSetMB = 512;
+    std::string dir = "/tmp/vms-segment-write-benchmark";
+    std::string only;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--cameras" && i + 1 < argc) cameras = std::atoi(argv[++i]);
+        else if (arg == "--segments" && i + 1 < argc) segments = std::atoi(argv[++i]);
+        else if (arg == "--segment-mb" && i + 1 < argc) segmentMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--chunk-kb" && i + 1 < argc) chunkKB = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--working-set-mb" && i + 1 < argc) workingSetMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--dir" && i + 1 < argc) dir = argv[++i];
+        else if (arg == "--only" && i + 1 < argc) only = argv[++i];
+        else {
+            std::fprintf(stderr, "Usage: %s [--cameras N] [--segments S] [--segment-mb MB] [--chunk-kb KB] "
+                                 "[--working-set-mb MB] [--dir DIR] [--only plain|tuned]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (cameras <= 0 || segments <= 0 || segmentMB == 0 || chunkKB == 0 || workingSetMB == 0) {
+        std::fprintf(stderr, "All sizes and counts must be positive\n");
+        return 1;
+    }
+
+    // SegmentFile logs go nowhere, results are printed with stdio
+    std::ofstream devNull("/dev/null");
+    std::streambuf* coutBuf = std::cout.rdbuf(devNull.rdbuf());
+    std::streambuf* cerrBuf = std::cerr.rdbuf(devNull.rdbuf());
+
+    uint64_t segmentBytes = segmentMB * 1024 * 1024 / (chunkKB * 1024) * (chunkKB * 1024);
+    uint64_t workingSetBytes = workingSetMB * 1024 * 1024;
+    uint64_t totalBytes = segmentBytes * cameras * segments;
+
+    fs::create_directories(dir);
+    std::string workingSet = dir + "/neighbour.db";
+    if (!createWorkingSet(workingSet, workingSetBytes)) {
+        std::fprintf(stderr, "Cannot create %s\n", workingSet.c_str());
+        return 1;
+    }
+
+    std::printf("%d cameras x %d segments x %llu MB, %zu KB appends, %llu MB neighbour working set\n",
+                cameras, segments, (unsigned long long)(segmentBytes >> 20), chunkKB,
+                (unsigned long long)workingSetMB);
+    std::fflush(stdout);
+
+    std::string segmentDir = dir + "/segments";
+    if (only.empty() || only == "plain") {
+        print("plain", run(segmentDir, workingSet, workingSetBytes, cameras, segments, segmentBytes,
+                           chunkKB * 1024, false), totalBytes);
+        std::fflush(stdout);
+    }
+    if (only.empty() || only == "tuned") {
+        print("tuned", run(segmentDir, workingSet, workingSetBytes, cameras, segments, segmentBytes,
+                           chunkKB * 1024, true), totalBytes);
+        std::fflush(stdout);
+    }
+
+    fs::remove_all(dir);
+    std::cout.rdbuf(coutBuf);
+    std::cerr.rdbuf(cerrBuf);
+    return 0;
+}
@@ -0,0 +1,521 @@
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include "io_uring_queue.hpp"
+#include "logger.hpp"
+
+/**
+ * AsyncWriter - Shared write back end of all segment files
+ *
+ * SegmentFile coalesces the muxer's small writes into COALESCE_BYTES
+ * buffers aligned to file offsets and hands full buffers over here, so
+ * a camera's pipeline thread never waits for the disk while there is
+ * room in its in-flight budget. Writes are queued per volume (st_dev of
+ * the file), each volume drained by:
+ * - one io_uring thread with up to QUEUE_DEPTH writes in flight
+ *   (IORING_OP_WRITE, 5.6+), or where io_uring is missing or blocked
+ * - POOL_THREADS threads doing pwrite()
+ * Hundreds of cameras on a disk share a handful of threads instead of
+ * blocking one each, and a slow volume only backs up its own queue.
+ *
+ * Per file (Stream): writes in flight are bounded by maxInFlightBytes
+ * (the writer blocks above it: back pressure on that camera alone); the
+ * first error is kept and returned by the next write. Completion order
+ * is not defined, so SegmentFile drains a stream before it overwrites
+ * (muxer patches) or publishes offsets (sidecar indexes); the offset
+ * below which every queued write completed drives its write-behind.
+ * With an abort flag, waits on the stream give up once it is set
+ * (forced stop on a hung disk); abandon() then closes the file after
+ * its last write instead of under it.
+ *
+ * Per volume: write latency (queued -> completed) histogram in
+ * power-of-two microsecond buckets, for the status log.
+ */
+class AsyncWriter {
+public:
+    enum class Backend {
+        IO_URING,       // Falls back to THREADS where io_uring is not usable
+        THREADS
+    };
+
+    static constexpr size_t COALESCE_BYTES = 512 * 1024;
+    static constexpr size_t BUFFER_ALIGNMENT = 4096;
+
+    /**
+     * Aligned write buffer from the shared pool
+     */
+    struct BufferDeleter {
+        void operator()(uint8_t* buffer) const { std::free(buffer); }
+    };
+    using Buffer = std::unique_ptr<uint8_t, BufferDeleter>;
+
+    class Volume;
+
+    /**
+     * Writes of one open file
+     */
+    class Stream {
+        friend class AsyncWriter;
+
+        static constexpr int ABORT_POLL_MS = 100;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        uint64_t inFlightBytes;
+        uint64_t maxInFlightBytes;
+        int error;                  // First failed write, -errno, 0 = none
+        Volume* volume;
+        std::multiset<uint64_t> inFlightOffsets;
+        uint64_t submittedEnd;      // End of the furthest write queued
+        const std::atomic<bool>* abortFlag;     // nullptr = wait for the disk forever
+        int orphanFd;               // Closed by the last completion (abandon)
+
+        template <typename Predicate>
+        bool waitUntil(std::unique_lock<std::mutex>& lock, Predicate predicate) {
+            if (!abortFlag) {
+                cv.wait(lock, predicate);
+                return true;
+            }
+            while (!predicate()) {
+                if (*abortFlag) return false;
+                cv.wait_for(lock, std::chrono::milliseconds(ABORT_POLL_MS));
+            }
+            return true;
+        }
+
+    public:
+        Stream(Volume* target, uint64_t maxInFlight, const std::atomic<bool>* abort)
+            : inFlightBytes(0), maxInFlightBytes(maxInFlight), error(0), volume(target), submittedEnd(0),
+              abortFlag(abort), orphanFd(-1) {}
+
+        /**
+         * Wait for every write of this file
+         *
+         * @return 0, the first error (-errno), or -ECANCELED if aborted
+         */
+        int drain() {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!waitUntil(lock, [this] { return inFlightBytes == 0; })) {
+                return -ECANCELED;
+            }
+            return error;
+        }
+
+        /**
+         * Give up on the file (aborted): fd is closed now if idle, else
+         * by the completion of its last write
+         */
+        void abandon(int fd) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (inFlightBytes == 0) {
+                ::close(fd);
+            } else {
+                orphanFd = fd;
+            }
+        }
+
+        /**
+         * File offset below which every queued write has completed
+         */
+        uint64_t getCompletedOffset() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return inFlightOffsets.empty() ? submittedEnd : *inFlightOffsets.begin();
+        }
+
+        int getError() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return error;
+        }
+    };
+
+private:
+    static constexpr unsigned QUEUE_DEPTH = 64;
+    static constexpr int POOL_THREADS = 4;
+    static constexpr size_t MAX_POOLED_BUFFERS = 256;       // 128 MB kept for reuse at most
+    static constexpr int LATENCY_BUCKETS = 26;              // 1 us .. 33 s
+
+    struct Request {
+        std::shared_ptr<Stream> stream;
+        int fd;
+        Buffer buffer;
+        size_t length;
+        size_t done;                // Bytes written so far (short writes)
+        uint64_t offset;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+public:
+    class Volume {
+        friend class AsyncWriter;
+
+        std::string name;
+        dev_t device;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Request> queue;
+        std::vector<std::thread> threads;
+        bool stopping;
+        bool useRing;
+
+        std::atomic<uint64_t> latencyBuckets[LATENCY_BUCKETS];
+        std::atomic<uint64_t> maxLatencyUs;
+        std::atomic<uint64_t> writes;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> failures;
+        std::atomic<uint64_t> inFlight;
+
+    public:
+        Volume(const std::string& volumeName, dev_t dev)
+            : name(volumeName), device(dev), stopping(false), useRing(false), maxLatencyUs(0), writes(0),
+              bytes(0), failures(0), inFlight(0) {
+            for (auto& bucket : latencyBuckets) {
+                bucket = 0;
+            }
+        }
+
+        /**
+         * Latency below which a share of the writes completed (us)
+         */
+        uint64_t getPercentileUs(double share) const {
+            uint64_t total = 0;
+            uint64_t counts[LATENCY_BUCKETS];
+            for (int i = 0; i < LATENCY_BUCKETS; i++) {
+                counts[i] = latencyBuckets[i];
+                total += counts[i];
+            }
+            if (total == 0) return 0;
+            uint64_t wanted = (uint64_t)(total * share);
+            uint64_t seen = 0;
+            for (int i = 0; i < LATENCY_BUCKETS; i++) {
+                seen += counts[i];
+                if (seen > wanted) return std::min<uint64_t>(2ULL << i, maxLatencyUs);   // Upper bound of the bucket
+            }
+            return maxLatencyUs;
+        }
+    };
+
+private:
+    Backend backend;
+    std::mutex volumesMutex;
+    std::map<dev_t, std::unique_ptr<Volume>> volumes;
+
+    std::mutex poolMutex;
+    std::vector<Buffer> pool;
+
+    static std::string formatMs(uint64_t us) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1f ms", us / 1000.0);
+        return buffer;
+    }
+
+    void record(Volume& volume, const Request& request, int result) {
+        uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - request.queued).count();
+        int bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && (2ULL << bucket) <= us) {
+            bucket++;
+        }
+        volume.latencyBuckets[bucket]++;
+        uint64_t seenMax = volume.maxLatencyUs;
+        while (us > seenMax && !volume.maxLatencyUs.compare_exchange_weak(seenMax, us)) {}
+        volume.writes++;
+        if (result < 0) {
+            volume.failures++;
+        } else {
+            volume.bytes += request.length;
+        }
+    }
+
+    /**
+     * A request is done (written completely, or failed with result < 0)
+     */
+    void complete(Volume& volume, Request& request, int result) {
+        record(volume, request, result);
+        volume.inFlight--;
+        {
+            std::lock_guard<std::mutex> lock(request.stream->mutex);
+            if (result < 0 && request.stream->error == 0) {
+                request.stream->error = result;
+                Logger::error("AsyncWriter: write failed on " + volume.name + ": " + strerror(-result));
+            }
+            request.stream->inFlightBytes -= request.length;
+            auto offset = request.stream->inFlightOffsets.find(request.offset);
+            if (offset != request.stream->inFlightOffsets.end()) {
+                request.stream->inFlightOffsets.erase(offset);
+            }
+            if (request.stream->inFlightBytes == 0 && request.stream->orphanFd >= 0) {
+                ::close(request.stream->orphanFd);
+                request.stream->orphanFd = -1;
+            }
+        }
+        request.stream->cv.notify_all();
+        releaseBuffer(std::move(request.buffer));
+    }
+
+    /**
+     * Fallback: POOL_THREADS of these per volume
+     */
+    void poolLoop(Volume* volume) {
+        std::unique_lock<std::mutex> lock(volume->mutex);
+        while (true) {
+            volume->cv.wait(lock, [volume] { return volume->stopping || !volume->queue.empty(); });
+            if (volume->queue.empty()) return;   // Stopping and drained
+            Request request = std::move(volume->queue.front());
+            volume->queue.pop_front();
+            lock.unlock();
+
+            int result = 0;
+            while (request.done < request.length) {
+                ssize_t n = pwrite(request.fd, request.buffer.get() + request.done, request.length - request.done,
+                                   (off_t)(request.offset + request.done));
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    result = -errno;
+                    break;
+                }
+                request.done += (size_t)n;
+            }
+            complete(*volume, request, result);
+
+            lock.lock();
+        }
+    }
+
+    /**
+     * io_uring: queue what fits, submit, reap; short writes are
+     * resubmitted for the rest
+     */
+    void ringLoop(Volume* volume, std::unique_ptr<IoUringQueue> ring) {
+        std::vector<Request> slots(QUEUE_DEPTH);
+        std::vector<size_t> freeSlots;
+        for (size_t i = 0; i < QUEUE_DEPTH; i++) {
+            freeSlots.push_back(QUEUE_DEPTH - 1 - i);
+        }
+        std::vector<size_t> resubmit;
+
+        while (true) {
+            size_t active = QUEUE_DEPTH - freeSlots.size();
+            {
+                std::unique_lock<std::mutex> lock(volume->mutex);
+                if (active == 0 && resubmit.empty()) {
+                    volume->cv.wait(lock, [volume] { return volume->stopping || !volume->queue.empty(); });
+                    if (volume->queue.empty()) return;   // Stopping and drained
+                }
+                while (!volume->queue.empty() && !freeSlots.empty()) {
+                    size_t slot = freeSlots.back();
+                    freeSlots.pop_back();
+                    slots[slot] = std::move(volume->queue.front());
+                    volume->queue.pop_front();
+                    resubmit.push_back(slot);
+                }
+            }
+
+            size_t queued = 0;
+            for (size_t slot : resubmit) {
+                io_uring_sqe* sqe = ring->getSqe();
+                if (!sqe) break;
+                Request& request = slots[slot];
+                sqe->opcode = IORING_OP_WRITE;
+                sqe->fd = request.fd;
+                sqe->addr = (uint64_t)(uintptr_t)(request.buffer.get() + request.done);
+                sqe->len = (uint32_t)(request.length - request.done);
+                sqe->off = request.offset + request.done;
+                sqe->user_data = slot;
+                queued++;
+            }
+            resubmit.erase(resubmit.begin(), resubmit.begin() + queued);
+
+            // Wait for one completion only when nothing new was queued
+            active = QUEUE_DEPTH - freeSlots.size();
+            int ret = ring->submit(queued == 0 && active > 0 ? 1 : 0);
+            if (ret < 0) {
+                Logger::error("AsyncWriter: io_uring submit failed on " + volume->name + ": " + strerror(-ret));
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            io_uring_cqe cqe;
+            while (ring->popCqe(cqe)) {
+                size_t slot = (size_t)cqe.user_data;
+                Request& request = slots[slot];
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                    resubmit.push_back(slot);
+                    continue;
+                }
+                if (cqe.res > 0) {
+                    request.done += (size_t)cqe.res;
+                    if (request.done < request.length) {
+                        resubmit.push_back(slot);
+                        continue;
+                    }
+                }
+                complete(*volume, request, cqe.res < 0 ? cqe.res : cqe.res == 0 ? -EIO : 0);
+                slots[slot] = Request();
+                freeSlots.push_back(slot);
+            }
+        }
+    }
+
+    Volume* volumeFor(dev_t device, const std::string& name) {
+        std::lock_guard<std::mutex> lock(volumesMutex);
+        auto it = volumes.find(device);
+        if (it != volumes.end()) return it->second.get();
+
+        std::unique_ptr<Volume> volume(new Volume(name, device));
+        Volume* target = volume.get();
+        if (backend == Backend::IO_URING) {
+            std::unique_ptr<IoUringQueue> ring(new IoUringQueue());
+            if (ring->init(QUEUE_DEPTH) && ring->supports(IORING_OP_WRITE)) {
+                target->useRing = true;
+                target->threads.emplace_back(&AsyncWriter::ringLoop, this, target, std::move(ring));
+            }
+        }
+        if (!target->useRing) {
+            for (int i = 0; i < POOL_THREADS; i++) {
+                target->threads.emplace_back(&AsyncWriter::poolLoop, this, target);
+            }
+        }
+        Logger::info("AsyncWriter: volume " + name + " (" + std::to_string(major(device)) + ":" +
+                     std::to_string(minor(device)) + "), " +
+                     (target->useRing ? "io_uring" : std::to_string(POOL_THREADS) + " write threads"));
+        volumes[device] = std::move(volume);
+        return target;
+    }
+
+public:
+    explicit AsyncWriter(Backend writeBackend = Backend::IO_URING) : backend(writeBackend) {}
+
+    ~AsyncWriter() {
+        std::lock_guard<std::mutex> lock(volumesMutex);
+        for (auto& item : volumes) {
+            Volume& volume = *item.second;
+            {
+                std::lock_guard<std::mutex> volumeLock(volume.mutex);
+                volume.stopping = true;
+            }
+            volume.cv.notify_all();
+            for (auto& thread : volume.threads) {
+                thread.join();
+            }
+        }
+    }
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    static Backend parseBackend(const std::string& name) {
+        return name == "threads" ? Backend::THREADS : Backend::IO_URING;
+    }
+
+    /**
+     * Writes of a newly opened file (volume = its file system)
+     *
+     * @param path Named after the grandparent directory (<volume>/<camera>/<file>)
+     * @param abortFlag Once set, waits on the stream fail with -ECANCELED (nullptr = never)
+     */
+    std::shared_ptr<Stream> openStream(int fd, const std::string& path, uint64_t maxInFlightBytes,
+                                       const std::atomic<bool>* abortFlag = nullptr) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) return nullptr;
+        std::string name = path.substr(0, path.rfind('/'));
+        name = name.substr(0, std::max<size_t>(name.rfind('/'), 1));
+        return std::make_shared<Stream>(volumeFor(st.st_dev, name), std::max<uint64_t>(maxInFlightBytes, COALESCE_BYTES),
+                                        abortFlag);
+    }
+
+    Buffer acquireBuffer() {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (!pool.empty()) {
+                Buffer buffer = std::move(pool.back());
+                pool.pop_back();
+                return buffer;
+            }
+        }
+        void* memory = nullptr;
+        if (posix_memalign(&memory, BUFFER_ALIGNMENT, COALESCE_BYTES) != 0) {
+            return Buffer();
+        }
+        return Buffer(static_cast<uint8_t*>(memory));
+    }
+
+    void releaseBuffer(Buffer buffer) {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (pool.size() < MAX_POOLED_BUFFERS) {
+            pool.push_back(std::move(buffer));
+        }
+    }
+
+    /**
+     * Queue buffer[0, length) for fd at offset; blocks while the stream
+     * is over its in-flight budget
+     *
+     * @return 0, or an earlier write error of the stream (-errno), or -ECANCELED if aborted
+     */
+    int submit(const std::shared_ptr<Stream>& stream, int fd, Buffer buffer, size_t length, uint64_t offset) {
+        {
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            bool room = stream->waitUntil(lock, [&stream, length] {
+                return stream->inFlightBytes == 0 || stream->inFlightBytes + length <= stream->maxInFlightBytes;
+            });
+            int error = room ? stream->error : -ECANCELED;
+            if (error != 0) {
+                lock.unlock();
+                releaseBuffer(std::move(buffer));
+                return error;
+            }
+            stream->inFlightBytes += length;
+            stream->inFlightOffsets.insert(offset);
+            stream->submittedEnd = std::max(stream->submittedEnd, offset + length);
+        }
+
+        Volume* volume = stream->volume;
+        volume->inFlight++;
+        {
+            std::lock_guard<std::mutex> lock(volume->mutex);
+            volume->queue.push_back({stream, fd, std::move(buffer), length, 0, offset,
+                                     std::chrono::steady_clock::now()});
+        }
+        volume->cv.notify_one();
+        return 0;
+    }
+
+    /**
+     * Per volume write counters and latency percentiles (status log)
+     */
+    std::string getSummary() {
+        std::lock_guard<std::mutex> lock(volumesMutex);
+        std::string summary;
+        for (const auto& item : volumes) {
+            const Volume& volume = *item.second;
+            if (!summary.empty()) summary += "; ";
+            summary += volume.name + ": " + std::to_string(volume.writes) + " writes, " +
+                       std::to_string(volume.bytes / (1024 * 1024)) + " MB, p50 " +
+                       formatMs(volume.getPercentileUs(0.5)) + ", p99 " + formatMs(volume.getPercentileUs(0.99)) +
+                       ", max " + formatMs(volume.maxLatencyUs) + ", " + std::to_string(volume.inFlight) +
+                       " in flight" + (volume.failures > 0 ? ", " + std::to_string(volume.failures) + " failed" : "");
+        }
+        return summary.empty() ? "no writes yet" : summary;
+    }
+};
+
+#endif // ASYNC_WRITER_HPP
@@ -5,57 +5,76 @@
 #include <memory>
 #include <thread>
 #include <atomic>
-#include "database.hpp"
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include "database_pool.hpp"
 #include "camera_recorder.hpp"
+#include "camera_reactor.hpp"
 #include "storage_manager.hpp"
+#include "storage_monitor.hpp"
+#include "stream_prober.hpp"
+#include "startup_tracker.hpp"
+#include "async_writer.hpp"
+#include "camera_watcher.hpp"
+#include "recording_ingestor.hpp"
 #include "config.hpp"
 #include "logger.hpp"
 
 class CameraManager {
 public:
-    CameraManager(const Config& cfg, std::shared_ptr<Database> db, 
+    CameraManager(const Config& cfg, std::shared_ptr<DatabasePool> pool, 
                   std::shared_ptr<StorageManager> storage) 
-        : config(cfg), database(db), storageManager(storage) {}
+        : config(cfg), databasePool(pool), storageManager(storage),
+          storageMonitor(std::make_shared<StorageMonitor>(storage, cfg.getEvictionHorizonMinutes(),
+                                                          cfg.getMinFreeSpaceGB())),
+          reactor(std::make_shared<CameraReactor>(cfg.getReactorThreads())),
+          streamProber(std::make_shared<StreamProber>(cfg.getProbeCachePath(), cfg.getProbeWorkers())),
+          startupTracker(std::make_shared<StartupTracker>()),
+          asyncWriter(cfg.getWriteBackend() == "sync" ? nullptr
+                      : std::make_shared<AsyncWriter>(AsyncWriter::parseBackend(cfg.getWriteBackend()))),
+          recordingIngestor(std::make_shared<RecordingIngestor>(pool, (size_t)std::max(cfg.getIngestQueueRows(), 1),
+                                                                (size_t)std::max(cfg.getIngestBatchRows(), 1))),
+          cameraWatcher(std::make_shared<CameraWatcher>(cfg)), fleetStarted(false), heartbeatsFailed(0),
+          lastResync(std::chrono::steady_clock::now()) {}
     
     ~CameraManager() {
         stopAll();
     }
     
     bool loadCameras() {
-        cameras = database->getCameras();
+        DatabasePool::Lease database = databasePool->acquire();
+        if (!database) {
+            Logger::error("Cannot load cameras - no database connection available");
+            return false;
+        }
+        bool ok = false;
+        std::vector<Camera> online = database->getCameras(&ok);
+        database.release();
         
-        for (const auto& cam : cameras) {
+        for (const auto& cam : online) {
             Logger::info("Camera loaded: " + cam.name + " (" + cam.location + ")");
-            
-            // Create recorder with camera ID for MediaMTX path
-            int camId = 0;
-            std::string camIdStr = cam.id;  // Use UUID as string ID for MediaMTX
-            
-            try {
-                camId = std::stoi(cam.id);
-            } catch (...) {
-                // If ID is not numeric (UUID), use hash for numeric ID
-                camId = std::hash<std::string>{}(cam.id) % 10000;
-            }
-            
-            auto recorder = std::make_shared<CameraRecorder>(
-                camId,
-                camIdStr,  // Pass string ID for MediaMTX
-                cam.name, 
-                cam.rtspUrl,
-                config.getRecordingPath(),
-                storageManager,  // Pass storage manager
-                config.getMaxRetries(),
-                config.getRetryDelaySeconds()
-            );
-            recorders.push_back(recorder);
+            addCamera(cam);
+        }
+        if (ok && cameras.empty()) {
+            Logger::warn("No online cameras yet - recorders start as cameras are added");
         }
         
-        return !cameras.empty();
+        return ok;
     }
     
     bool startAll() {
         Logger::info("Starting " + std::to_string(recorders.size()) + " camera recorders...");
+
+        if (!reactor->start()) {
+            Logger::error("Failed to start camera reactor");
+            return false;
+        }
+        streamProber->start();
+        recordingIngestor->start();
+        cameraWatcher->start();
+        startupTracker->begin(recorders.size());
+        fleetStarted = true;
         
         for (auto& recorder : recorders) {
             recorder->start();
@@ -68,19 +87,158 @@ public:
     void stopAll() {
         Logger::info("Stopping all recorders...");
         
+        // SIGTERM / stop request to every pipeline first, then one shared
+        // deadline for the whole batch
         for (auto& recorder : recorders) {
-            recorder->stop();
+            recorder->beginStop();
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(STOP_TIMEOUT_SECONDS);
+        for (auto& recorder : recorders) {
+            recorder->finishStop(deadline);
         }
         
+        cameraWatcher->stop();
         recorders.clear();
+        recordersById.clear();
+        reactor->stop();
+        streamProber->stop();
+        recordingIngestor->stop();   // After the recorders: last segments are queued by now
     }
     
     int getCameraCount() const {
         return cameras.size();
     }
     
+    /**
+     * Forward new rows of the events table to event-triggered cameras
+     *
+     * Skipped entirely when every camera records continuously.
+     */
+    void pollEvents() {
+        bool anyEventCamera = false;
+        for (const auto& recorder : recorders) {
+            if (recorder->getRecordingTrigger() != RecordingTrigger::CONTINUOUS) {
+                anyEventCamera = true;
+                break;
+            }
+        }
+        if (!anyEventCamera) return;
+
+        DatabasePool::Lease database = databasePool->acquire();
+        if (!database) return;   // Next poll catches up from the cursor
+        for (const auto& event : database->getEventsSince(eventCursor)) {
+            auto it = recordersById.find(event.cameraId);
+            if (it != recordersById.end()) {
+                it->second->trigger(event.eventType);
+            }
+        }
+    }
+
+    /**
+     * cameras.last_seen = now for every camera that is recording, one
+     * pipelined round trip for the whole fleet
+     *
+     * cameras.status stays the operator's setting (recorders load the
+     * 'online' ones), so liveness is last_seen only.
+     */
+    void sendHeartbeats() {
+        std::vector<std::string> recording;
+        recording.reserve(recorders.size());
+        for (const auto& recorder : recorders) {
+            if (recorder->getState() == CameraState::RUNNING) {
+                recording.push_back(recorder->getIdString());
+            }
+        }
+        if (recording.empty()) return;
+
+        DatabasePool::Lease database = databasePool->acquire();
+        if (!database || !database->updateCameraHeartbeats(recording)) {
+            heartbeatsFailed++;
+        }
+    }
+
+    /**
+     * Apply camera changes without restarting the recorder (main loop)
+     *
+     * Cameras named by NOTIFY are re-read and reconciled one by one.
+     * Every resyncSeconds, and after the watcher reconnected, the whole
+     * online set is diffed instead, for notifications that got lost.
+     */
+    void reconcileCameras(int resyncSeconds) {
+        bool fullResync = false;
+        std::vector<std::string> changed = cameraWatcher->takeChanges(fullResync);
+        auto now = std::chrono::steady_clock::now();
+        if (resyncSeconds > 0 && now - lastResync >= std::chrono::seconds(resyncSeconds)) {
+            fullResync = true;
+        }
+        if (!fullResync && changed.empty()) return;
+
+        DatabasePool::Lease database = databasePool->acquire();
+        if (!database) {
+            cameraWatcher->requeue(changed, fullResync);   // Next round
+            return;
+        }
+        bool ok = false;
+        std::vector<std::string> ids;
+        std::vector<Camera> online;
+        if (fullResync) {
+            online = database->getCameras(&ok);
+            ids = changed;
+            for (const auto& item : cameras) {
+                ids.push_back(item.first);
+            }
+            for (const auto& cam : online) {
+                ids.push_back(cam.id);
+            }
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        } else {
+            online = database->getCamerasById(changed, ok);
+            ids = changed;
+        }
+        database.release();
+        if (!ok) {
+            cameraWatcher->requeue(changed, fullResync);
+            return;
+        }
+        if (fullResync) {
+            lastResync = now;
+        }
+
+        std::unordered_map<std::string, const Camera*> rows;
+        for (const auto& cam : online) {
+            rows[cam.id] = &cam;
+        }
+        reconcile(ids, rows);
+    }
+
+    /**
+     * Feed per camera byte counters to the storage monitor (control loop)
+     */
+    void sampleStorage() {
+        std::vector<StorageMonitor::CameraBytes> counters;
+        counters.reserve(recorders.size());
+        for (const auto& recorder : recorders) {
+            counters.push_back({recorder->getName(), recorder->getBytesWritten()});
+        }
+        storageMonitor->sample(counters);
+    }
+
     void logStatus() {
         Logger::info("=== Recorder Status ===");
+        Logger::info("Storage: " + storageMonitor->getSummary());
+        if (!startupTracker->isComplete()) {
+            Logger::info("Startup: " + startupTracker->getSummary());
+        }
+        Logger::info("Probe cache: " + streamProber->getStats());
+        if (asyncWriter) {
+            Logger::info("Writes: " + asyncWriter->getSummary());
+        }
+        Logger::info("Recordings ingest: " + recordingIngestor->getSummary());
+        if (heartbeatsFailed > 0) {
+            Logger::warn("Camera heartbeats failed: " + std::to_string(heartbeatsFailed));
+        }
+        streamProber->flush();
         for (const auto& recorder : recorders) {
             std::string status = recorder->getName() + ": " + recorder->getStatus();
             if (recorder->hasFailed()) {
@@ -94,11 +252,168 @@ public:
     }
 
 private:
+    static constexpr int STOP_TIMEOUT_SECONDS = 5;
+
+    /**
+     * Create (not start) the recorder of a camera
+     */
+    std::shared_ptr<CameraRecorder> addCamera(const Camera& cam) {
+        // Create recorder with camera ID for MediaMTX path
+        int camId = 0;
+        std::string camIdStr = cam.id;  // Use UUID as string ID for MediaMTX
+        
+        try {
+            camId = std::stoi(cam.id);
+        } catch (...) {
+            // If ID is not numeric (UUID), use hash for numeric ID
+            camId = std::hash<std::string>{}(cam.id) % 10000;
+        }
+        
+        auto recorder = std::make_shared<CameraRecorder>(
+            camId,
+            camIdStr,  // Pass string ID for MediaMTX
+            cam.name, 
+            cam.rtspUrl,
+            storageManager,  // Pass storage manager
+            reactor,
+            config.getMaxRetries(),
+            config.getRetryDelaySeconds(),
+            parsePipelineBackend(config.getPipelineBackend()),
+            parseRecordingMode(cam.recordingMode)
+        );
+        recorder->setStreamProber(streamProber);
+        if (!fleetStarted) {
+            recorder->setStartupTracker(startupTracker);   // Fleet startup only, not cameras added later
+        }
+        recorder->setRecordingIngestor(recordingIngestor);
+        recorder->setFragmentSeconds(config.getFragmentSeconds());
+        SegmentFile::Options fileOptions;
+        fileOptions.preallocate = config.getPreallocateSegments();
+        fileOptions.dropCache = config.getDropWriteCache();
+        fileOptions.chunkSeconds = std::max(config.getChunkMinutes(), 0) * 60;
+        fileOptions.writer = asyncWriter;
+        fileOptions.maxInFlightBytes = (uint64_t)std::max(config.getWriteInFlightMB(), 1) * 1024 * 1024;
+        recorder->setSegmentFileOptions(fileOptions);
+
+        RecordingTrigger trigger = parseRecordingTrigger(cam.recordingTrigger);
+        if (trigger != RecordingTrigger::CONTINUOUS) {
+            EventRecordingGate::Settings settings;
+            settings.preRollSeconds = cam.preRollSeconds;
+            settings.postRollSeconds = cam.postRollSeconds;
+            settings.maxPreRollBytes = (size_t)config.getPreRollMaxMB() * 1024 * 1024;
+            recorder->setRecordingTrigger(trigger, settings);
+            Logger::info("Camera " + cam.name + " records on " + getRecordingTriggerName(trigger));
+        }
+
+        applyQuota(cam);
+        cameras[cam.id] = cam;
+        recordersById[camIdStr] = recorder;
+        recorders.push_back(recorder);
+        return recorder;
+    }
+
+    /**
+     * Camera directory = camera name (CameraRecorder); 0/0 clears the quota
+     */
+    void applyQuota(const Camera& cam) {
+        uint64_t quotaBytes = (uint64_t)std::max(cam.storageQuotaGB, 0) * 1024ULL * 1024ULL * 1024ULL;
+        storageManager->setCameraQuota(cam.name, quotaBytes, cam.retentionDays);
+        if (cam.storageQuotaGB > 0 || cam.retentionDays > 0) {
+            Logger::info("Camera " + cam.name + " quota: " +
+                         (cam.storageQuotaGB > 0 ? std::to_string(cam.storageQuotaGB) + " GB" : "no byte limit") +
+                         ", " + (cam.retentionDays > 0 ? std::to_string(cam.retentionDays) + " days" : "global retention"));
+        }
+    }
+
+    /**
+     * Stop cameras' recorders under one deadline and forget them (their
+     * recordings stay, under the quota they had)
+     */
+    void removeCameras(const std::vector<std::string>& ids) {
+        std::vector<std::shared_ptr<CameraRecorder>> stopping;
+        for (const auto& id : ids) {
+            auto it = recordersById.find(id);
+            if (it == recordersById.end()) continue;
+            it->second->beginStop();
+            stopping.push_back(it->second);
+            recordersById.erase(it);
+            cameras.erase(id);
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(STOP_TIMEOUT_SECONDS);
+        for (auto& recorder : stopping) {
+            recorder->finishStop(deadline);
+            recorders.erase(std::remove(recorders.begin(), recorders.end(), recorder), recorders.end());
+        }
+    }
+
+    /**
+     * Settings the running pipeline was built with (restart to change)
+     */
+    static bool needsRestart(const Camera& running, const Camera& updated) {
+        return running.name != updated.name || running.rtspUrl != updated.rtspUrl ||
+               running.recordingMode != updated.recordingMode ||
+               running.recordingTrigger != updated.recordingTrigger ||
+               running.preRollSeconds != updated.preRollSeconds ||
+               running.postRollSeconds != updated.postRollSeconds;
+    }
+
+    /**
+     * Bring cameras in line with their rows (no row = deleted or not
+     * online). Unchanged cameras are not touched; changed ones stop
+     * together, then start with the new settings.
+     */
+    void reconcile(const std::vector<std::string>& ids,
+                   const std::unordered_map<std::string, const Camera*>& rows) {
+        std::vector<std::string> stop;
+        std::vector<const Camera*> start;
+        for (const auto& id : ids) {
+            auto row = rows.find(id);
+            auto it = cameras.find(id);
+            if (row == rows.end()) {
+                if (it != cameras.end()) {
+                    Logger::info("Camera " + it->second.name + " removed or offline, stopping its recorder");
+                    stop.push_back(id);
+                }
+                continue;
+            }
+            const Camera& cam = *row->second;
+            if (it == cameras.end()) {
+                Logger::info("Camera added: " + cam.name + " (" + cam.location + ")");
+                start.push_back(&cam);
+            } else if (needsRestart(it->second, cam)) {
+                Logger::info("Camera " + cam.name + " changed, restarting its recorder");
+                stop.push_back(id);
+                start.push_back(&cam);
+            } else {
+                if (it->second.storageQuotaGB != cam.storageQuotaGB || it->second.retentionDays != cam.retentionDays) {
+                    applyQuota(cam);   // Next retention pass applies it, recording goes on
+                }
+                it->second = cam;
+            }
+        }
+        removeCameras(stop);
+        for (const Camera* cam : start) {
+            addCamera(*cam)->start();
+        }
+    }
+
     const Config& config;
-    std::shared_ptr<Database> database;
+    std::shared_ptr<DatabasePool> databasePool;
     std::shared_ptr<StorageManager> storageManager;
-    std::vector<Camera> cameras;
+    std::shared_ptr<StorageMonitor> storageMonitor;   // Consumption rates, predictive eviction
+    std::shared_ptr<CameraReactor> reactor;   // Drives all recorders (no thread per camera)
+    std::shared_ptr<StreamProber> streamProber;       // Probe pool + persistent probe cache
+    std::shared_ptr<StartupTracker> startupTracker;   // Fleet time-to-first-segment
+    std::shared_ptr<AsyncWriter> asyncWriter;         // Shared segment write back end, nullptr = sync writes
+    std::shared_ptr<RecordingIngestor> recordingIngestor;   // Batched recordings inserts
+    std::shared_ptr<CameraWatcher> cameraWatcher;      // LISTEN camera_changes
+    std::unordered_map<std::string, Camera> cameras;   // Rows the running recorders were built from, by id
     std::vector<std::shared_ptr<CameraRecorder>> recorders;
+    std::unordered_map<std::string, std::shared_ptr<CameraRecorder>> recordersById;
+    EventCursor eventCursor;     // Event poll position
+    bool fleetStarted;           // startAll() done: later cameras are not startup tracked
+    uint64_t heartbeatsFailed;   // Heartbeat rounds not written (main loop only)
+    std::chrono::steady_clock::time_point lastResync;   // Last full diff of the camera set
 };
 
 #endif // CAMERA_MANAGER_HPP
@@ -0,0 +1,326 @@
+#ifndef CAMERA_REACTOR_HPP
+#define CAMERA_REACTOR_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "logger.hpp"
+
+/**
+ * ReactorHandler - Receiver of fd readiness events from a reactor loop
+ *
+ * Callbacks run on the loop the handler was assigned to, one at a time,
+ * and must not block. Events can be spurious (fd reused after unwatch),
+ * so handlers read their fds non-blocking.
+ */
+class ReactorHandler {
+public:
+    virtual ~ReactorHandler() = default;
+    virtual void onReadable(int fd) = 0;
+};
+
+/**
+ * ReactorTimer - timerfd wrapper (one-shot or periodic)
+ */
+class ReactorTimer {
+private:
+    int fd;
+
+public:
+    ReactorTimer() : fd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {
+        if (fd < 0) {
+            Logger::error("ReactorTimer: timerfd_create failed: " + std::string(strerror(errno)));
+        }
+    }
+
+    ~ReactorTimer() {
+        if (fd >= 0) close(fd);
+    }
+
+    ReactorTimer(const ReactorTimer&) = delete;
+    ReactorTimer& operator=(const ReactorTimer&) = delete;
+
+    /**
+     * Fire after delayMs, then every intervalMs (0 = one-shot)
+     */
+    void arm(int64_t delayMs, int64_t intervalMs = 0) {
+        itimerspec spec{};
+        delayMs = std::max<int64_t>(delayMs, 1);
+        spec.it_value.tv_sec = delayMs / 1000;
+        spec.it_value.tv_nsec = (delayMs % 1000) * 1000000;
+        spec.it_interval.tv_sec = intervalMs / 1000;
+        spec.it_interval.tv_nsec = (intervalMs % 1000) * 1000000;
+        timerfd_settime(fd, 0, &spec, nullptr);
+    }
+
+    void disarm() {
+        itimerspec spec{};
+        timerfd_settime(fd, 0, &spec, nullptr);
+    }
+
+    /**
+     * Acknowledge expirations
+     *
+     * @return Expirations since the last call (0 if the event was spurious)
+     */
+    uint64_t consume() {
+        uint64_t expirations = 0;
+        if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return 0;
+        }
+        return expirations;
+    }
+
+    int getFd() const { return fd; }
+};
+
+/**
+ * CameraReactor - Fixed pool of epoll loops driving all camera state machines
+ *
+ * Replaces one sleeping thread per camera: each camera is pinned to one
+ * loop (round robin) and reacts to fd events - pipeline state changes,
+ * backoff/poll timers - instead of polling with sleep_for. Thread count
+ * follows the core count, not the camera count.
+ *
+ * watch()/unwatch() must be called on the owning loop (from a handler
+ * callback or a posted task); post() and runSync() are thread-safe.
+ */
+class CameraReactor {
+private:
+    static constexpr int MAX_EVENTS = 64;
+
+    struct Loop {
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::thread thread;
+        std::atomic<std::thread::id> threadId{};    // Set by the loop thread before it runs anything
+
+        std::mutex tasksMutex;
+        std::deque<std::function<void()>> tasks;
+
+        // Loop thread only
+        std::unordered_map<int, ReactorHandler*> handlers;
+        std::atomic<uint64_t> eventsDispatched{0};
+    };
+
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::atomic<bool> running;
+    std::atomic<size_t> nextLoop;
+
+    void runLoop(Loop& loop) {
+        epoll_event events[MAX_EVENTS];
+
+        while (running) {
+            int count = epoll_wait(loop.epollFd, events, MAX_EVENTS, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                Logger::error("CameraReactor: epoll_wait failed: " + std::string(strerror(errno)));
+                break;
+            }
+
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == loop.wakeFd) {
+                    uint64_t value;
+                    while (read(loop.wakeFd, &value, sizeof(value)) == sizeof(value)) {}
+                    runTasks(loop);
+                    continue;
+                }
+
+                // Handler may have been unwatched earlier in this batch
+                auto it = loop.handlers.find(fd);
+                if (it != loop.handlers.end()) {
+                    it->second->onReadable(fd);
+                    loop.eventsDispatched++;
+                }
+            }
+        }
+
+        runTasks(loop);
+    }
+
+    void runTasks(Loop& loop) {
+        std::deque<std::function<void()>> pending;
+        {
+            std::lock_guard<std::mutex> lock(loop.tasksMutex);
+            pending.swap(loop.tasks);
+        }
+        for (auto& task : pending) {
+            task();
+        }
+    }
+
+    void wake(Loop& loop) {
+        uint64_t one = 1;
+        if (write(loop.wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            Logger::error("CameraReactor: wakeup failed: " + std::string(strerror(errno)));
+        }
+    }
+
+public:
+    /**
+     * @param threadCount Number of loops, 0 = one per core
+     */
+    explicit CameraReactor(size_t threadCount = 0) : running(false), nextLoop(0) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (size_t i = 0; i < threadCount; i++) {
+            auto loop = std::make_unique<Loop>();
+            loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+            loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (loop->epollFd < 0 || loop->wakeFd < 0) {
+                Logger::error("CameraReactor: cannot create loop: " + std::string(strerror(errno)));
+                if (loop->wakeFd >= 0) close(loop->wakeFd);
+                if (loop->epollFd >= 0) close(loop->epollFd);
+                continue;
+            }
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = loop->wakeFd;
+            epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &event);
+            loops.push_back(std::move(loop));
+        }
+    }
+
+    ~CameraReactor() {
+        stop();
+        for (auto& loop : loops) {
+            if (loop->wakeFd >= 0) close(loop->wakeFd);
+            if (loop->epollFd >= 0) close(loop->epollFd);
+        }
+    }
+
+    CameraReactor(const CameraReactor&) = delete;
+    CameraReactor& operator=(const CameraReactor&) = delete;
+
+    bool start() {
+        if (running || loops.empty()) {
+            return !loops.empty();
+        }
+
+        running = true;
+        for (auto& loop : loops) {
+            Loop* target = loop.get();
+            loop->thread = std::thread([this, target] {
+                target->threadId = std::this_thread::get_id();
+                runLoop(*target);
+            });
+        }
+        Logger::info("Camera reactor started with " + std::to_string(loops.size()) + " threads");
+        return true;
+    }
+
+    /**
+     * Stop all loops (queued tasks still run)
+     */
+    void stop() {
+        if (!running) return;
+
+        running = false;
+        for (auto& loop : loops) {
+            wake(*loop);
+        }
+        for (auto& loop : loops) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+        }
+    }
+
+    /**
+     * Pick a loop for a new camera (round robin)
+     */
+    size_t assignLoop() {
+        return nextLoop++ % std::max<size_t>(loops.size(), 1);
+    }
+
+    /**
+     * Run a task on the loop thread
+     */
+    void post(size_t loopIndex, std::function<void()> task) {
+        Loop& loop = *loops[loopIndex];
+        {
+            std::lock_guard<std::mutex> lock(loop.tasksMutex);
+            loop.tasks.push_back(std::move(task));
+        }
+        wake(loop);
+    }
+
+    /**
+     * Run a task on the loop thread and wait for it
+     *
+     * After it returns no callback of that loop is running, so handlers
+     * unwatched by the task can be destroyed.
+     */
+    void runSync(size_t loopIndex, std::function<void()> task) {
+        Loop& loop = *loops[loopIndex];
+        if (!running || std::this_thread::get_id() == loop.threadId) {
+            task();
+            return;
+        }
+
+        std::promise<void> done;
+        std::future<void> finished = done.get_future();
+        post(loopIndex, [&task, &done] {
+            task();
+            done.set_value();
+        });
+        finished.wait();
+    }
+
+    /**
+     * Deliver EPOLLIN on fd to the handler (loop thread only)
+     */
+    bool watch(size_t loopIndex, int fd, ReactorHandler* handler) {
+        Loop& loop = *loops[loopIndex];
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            Logger::error("CameraReactor: cannot watch fd " + std::to_string(fd) + ": " + strerror(errno));
+            return false;
+        }
+        loop.handlers[fd] = handler;
+        return true;
+    }
+
+    /**
+     * Stop delivering events for fd (loop thread only, before closing fd)
+     */
+    void unwatch(size_t loopIndex, int fd) {
+        Loop& loop = *loops[loopIndex];
+        if (loop.handlers.erase(fd) > 0) {
+            epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+    uint64_t getEventsDispatched() const {
+        uint64_t total = 0;
+        for (const auto& loop : loops) {
+            total += loop->eventsDispatched;
+        }
+        return total;
+    }
+
+    size_t getThreadCount() const { return loops.size(); }
+    bool isRunning() const { return running; }
+};
+
+#endif // CAMERA_REACTOR_HPP
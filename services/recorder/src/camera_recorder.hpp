@@ -2,14 +2,24 @@
 #define CAMERA_RECORDER_HPP
 
 #include <string>
-#include <thread>
 #include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unistd.h>
+#include "camera_reactor.hpp"
 #include "ffmpeg_multi_output.hpp"
+#include "libav_pipeline.hpp"
+#include "recording_pipeline.hpp"
 // #include "live_transcoder.hpp"  // PHASE 3: No longer needed
 #include "logger.hpp"
+#include "chunk_index.hpp"
+#include "recording_ingestor.hpp"
 #include "storage_manager.hpp"
+#include "stream_prober.hpp"
+#include "startup_tracker.hpp"
 
 namespace fs = std::filesystem;
 
@@ -22,151 +32,548 @@ namespace fs = std::filesystem;
  * - 70% CPU reduction from baseline (188.1% -> 55.6% for 2 cameras)
  * - 50% fewer processes (4 -> 2)
  * - Auto-reconnect on failure
+ *
+ * The pipeline runs in-process (LibavPipeline) by default; the ffmpeg
+ * child process (FFmpegMultiOutput) is kept as a fallback backend.
+ *
+ * No thread per camera: the recorder is a state machine driven by one
+ * CameraReactor loop (pipeline event fd + timerfd):
+ *
+ *   CONNECTING -> PROBING -> RUNNING
+ *        ^           |          |
+ *        +-- BACKOFF <----------+   (pipeline start failed / exited)
+ *               |
+ *            FAILED                 (MAX_RETRIES reached)
+ *
+ * Pipelines without an event fd (ffmpeg CLI) are polled every
+ * STATUS_POLL_SECONDS.
+ *
+ * The ffmpeg CLI backend needs stream properties before it can build
+ * its command line: CONNECTING takes them from the StreamProber cache
+ * (revalidated in the background) or waits for a probe on the shared
+ * pool. The libav backend probes its own session and feeds the result
+ * back into the cache.
  */
-class CameraRecorder {
+enum class CameraState {
+    STOPPED,
+    CONNECTING,
+    PROBING,
+    RUNNING,
+    BACKOFF,
+    FAILED
+};
+
+class CameraRecorder : public ReactorHandler {
+public:
+    using PipelineFactory = std::function<RecordingPipeline*()>;
+
 private:
     int cameraId;
     std::string cameraName;
     std::string cameraIdStr;  // For MediaMTX path (e.g., "cam001")
     std::string rtspUrl;
-    std::string baseRecordingPath;
-    std::string cameraRecordingPath;
+    std::string cameraRecordingPath;      // Volume chosen by StorageManager at (re)start
+
+    static constexpr int STATUS_POLL_SECONDS = 5;
+    static constexpr int DISK_CHECK_SECONDS = 300;
+    static constexpr int DISK_WAIT_SECONDS = 60;
+    static constexpr int STABLE_RUN_SECONDS = 30;     // Crash after this long -> restart without backoff
+    static constexpr int STOP_TIMEOUT_SECONDS = 5;    // SIGTERM -> SIGKILL
 
     std::atomic<bool> shouldRun;
-    std::thread recordingThread;
+    std::atomic<CameraState> state;
 
     std::shared_ptr<StorageManager> storageManager;
+    std::shared_ptr<CameraReactor> reactor;
+    size_t loopIndex;
+    std::unique_ptr<ReactorTimer> timer;   // Backoff / status poll (reactor loop only)
+    std::chrono::steady_clock::time_point lastDiskCheck;
+    std::chrono::steady_clock::time_point runningSince;
+    RecordingPipeline* stoppingPipeline;   // Between beginStop() and finishStop()
+
     int maxRetries;
     int retryDelaySeconds;
-    int consecutiveFailures;
+    std::atomic<int> consecutiveFailures;
+    PipelineBackend pipelineBackend;
+    RecordingMode recordingMode;  // cameras.recording_mode
+    RecordingTrigger recordingTrigger;              // cameras.recording_trigger
+    EventRecordingGate::Settings eventSettings;
+    int fragmentSeconds;                            // MP4 fragment length, 0 = classic MP4
+    SegmentFile::Options segmentFileOptions;        // Preallocation, page-cache dropping
+    bool segmentsReported;                          // Pipeline reports closed segments to the index
+    PipelineFactory pipelineFactory;
+
+    std::shared_ptr<StreamProber> streamProber;
+    std::shared_ptr<StartupTracker> startupTracker;
+    std::shared_ptr<RecordingIngestor> recordingIngestor;   // recordings rows, nullptr = API disk scan only
+    std::shared_ptr<bool> probeToken;   // Expires on stop: late probe results are dropped
+    bool firstSegmentReported;
+    bool restartRequested;              // Pipeline stopped to pick up new stream properties
 
     // PHASE 3: Single process with dual outputs
-    FFmpegMultiOutput* multiOutputProcess;    // Recording + Live High (NVENC)
+    mutable std::mutex pipelineMutex;         // Pointer swaps vs. status readers
+    RecordingPipeline* multiOutputProcess;    // Recording + Live High (NVENC)
+    uint64_t retiredBytes;                    // Written by earlier pipelines (pipelineMutex)
 
     /**
-     * Recording loop with auto-reconnect and retry limits
+     * Create the pipeline for the configured backend
      */
-    void recordLoop() {
-        Logger::info("Recording thread started for " + cameraName);
-        
-        // Create camera directory
-        cameraRecordingPath = baseRecordingPath + "/" + cameraName;
-        try {
-            fs::create_directories(cameraRecordingPath);
-            Logger::info("Created directory: " + cameraRecordingPath);
-        } catch (const std::exception& e) {
-            Logger::error("Failed to create directory for " + cameraName + ": " + e.what());
-            return;
+    RecordingPipeline* createPipeline(const StreamAnalyzer::StreamInfo* probedInfo) {
+        std::string directory = storageManager->getCameraDirectory(cameraName);
+        if (!directory.empty()) {
+            cameraRecordingPath = directory;
         }
+        RecordingPipeline* pipeline = buildPipeline(probedInfo);
+        pipeline->setFragmentSeconds(fragmentSeconds);
+        pipeline->setSegmentFileOptions(segmentFileOptions);
+
+        std::shared_ptr<StorageManager> storage = storageManager;
+        std::string name = cameraName;
+        pipeline->setDirectoryProvider([storage, name]() {
+            return storage->getCameraDirectory(name);
+        });
+        segmentsReported = pipeline->setSegmentClosedCallback(
+            [storage](const std::string& path, uint64_t sizeBytes) {
+                storage->onSegmentClosed(path, sizeBytes);
+            });
+        if (recordingIngestor) {
+            std::shared_ptr<RecordingIngestor> ingestor = recordingIngestor;
+            std::string cameraId = cameraIdStr;
+            pipeline->setSegmentRecordedCallback([ingestor, cameraId](const RecordingPipeline::RecordedSegment& segment) {
+                RecordingRow row;
+                row.cameraId = cameraId;
+                row.filename = segment.path.substr(segment.path.rfind('/') + 1);
+                row.filepath = segment.path;
+                row.fileSize = segment.sizeBytes;
+                row.chunkOffset = ChunkIndex::isChunkPath(segment.path) ? (int64_t)segment.offset : -1;
+                row.startTime = segment.startTime;
+                row.durationSeconds = segment.durationSeconds;
+                row.width = segment.width;
+                row.height = segment.height;
+                row.fps = segment.frameRate;
+                row.codec = segment.codec;
+                ingestor->enqueue(std::move(row));
+            });
+        }
+        return pipeline;
+    }
 
-        consecutiveFailures = 0;
-        
-        // Main loop with auto-reconnect and retry limits
-        while (shouldRun) {
-            // Check if exceeded max retries
-            if (consecutiveFailures >= maxRetries) {
-                Logger::error("Camera " + cameraName + " exceeded maximum retries (" + 
-                            std::to_string(maxRetries) + "). Marking as failed.");
-                Logger::error("Manual intervention required. Please check camera connectivity and restart service.");
-                return;  // Exit recording thread - camera marked as failed
-            }
-            
-            // Check disk space before starting
-            if (!storageManager->hasEnoughSpace()) {
-                Logger::error("Insufficient disk space to continue recording " + cameraName);
-                Logger::info("Waiting for cleanup to free space...");
-                std::this_thread::sleep_for(std::chrono::seconds(60));
-                continue;
-            }
-
-            // PHASE 3: Create single process with dual outputs (Recording + Live High)
-            multiOutputProcess = new FFmpegMultiOutput(
+    /**
+     * Backend-specific construction (event recording is libav only)
+     */
+    RecordingPipeline* buildPipeline(const StreamAnalyzer::StreamInfo* probedInfo) {
+        if (pipelineFactory) {
+            return pipelineFactory();
+        }
+        if (pipelineBackend == PipelineBackend::FFMPEG_CLI) {
+            return new FFmpegMultiOutput(
                 cameraName,
                 cameraIdStr,
                 rtspUrl,
                 cameraRecordingPath,
-                true  // Enable live streaming
+                true,  // Enable live streaming
+                true,
+                GPUType::AUTO,
+                recordingMode,
+                probedInfo
             );
+        }
+        LibavPipeline* pipeline = new LibavPipeline(
+            cameraName,
+            cameraIdStr,
+            rtspUrl,
+            cameraRecordingPath,
+            true,  // Enable live streaming
+            true,
+            GPUType::AUTO,
+            recordingMode
+        );
+        if (recordingTrigger != RecordingTrigger::CONTINUOUS) {
+            pipeline->setEventRecording(eventSettings);
+        }
+        return pipeline;
+    }
+
+    /**
+     * Reactor callback: pipeline state change or timer expiry
+     */
+    void onReadable(int fd) override {
+        if (fd == timer->getFd()) {
+            if (timer->consume() == 0) return;
+            onTimer();
+        } else if (multiOutputProcess && fd == multiOutputProcess->getEventFd()) {
+            uint64_t value;
+            while (read(fd, &value, sizeof(value)) == sizeof(value)) {}
+            checkPipeline();
+        }
+    }
 
-            // Start multi-output process
-            if (!multiOutputProcess->start()) {
-                Logger::error("Failed to start multi-output process for " + cameraName +
-                            " (attempt " + std::to_string(consecutiveFailures + 1) + "/" +
-                            std::to_string(maxRetries) + ")");
-                delete multiOutputProcess;
-                multiOutputProcess = nullptr;
+    void onTimer() {
+        switch (state.load()) {
+            case CameraState::BACKOFF:
+                enterConnect();
+                break;
+            case CameraState::PROBING:
+            case CameraState::RUNNING:
+                checkPipeline();
+                if (state == CameraState::RUNNING) {
+                    checkDiskSpace();
+                }
+                break;
+            default:
+                break;
+        }
+    }
 
-                consecutiveFailures++;
+    /**
+     * Pipeline needs stream properties up front (ffmpeg CLI command line)
+     */
+    bool needsProbe() const {
+        return streamProber && !pipelineFactory && pipelineBackend == PipelineBackend::FFMPEG_CLI;
+    }
 
-                // Wait before retry with exponential backoff
-                int delaySeconds = retryDelaySeconds * (consecutiveFailures > 3 ? 2 : 1);
-                Logger::info("Retrying in " + std::to_string(delaySeconds) + " seconds for " + cameraName);
-                std::this_thread::sleep_for(std::chrono::seconds(delaySeconds));
-                continue;
+    /**
+     * Wrap a handler so a probe result is delivered on this recorder's
+     * reactor loop, and dropped if the recorder stopped in the meantime
+     */
+    StreamProber::ProbeCallback onLoop(void (CameraRecorder::*handler)(const StreamAnalyzer::StreamInfo&)) {
+        std::weak_ptr<bool> token = probeToken;
+        std::shared_ptr<CameraReactor> cameraReactor = reactor;
+        size_t loop = loopIndex;
+        return [this, token, cameraReactor, loop, handler](const StreamAnalyzer::StreamInfo& info) {
+            if (token.expired()) return;
+            cameraReactor->post(loop, [this, token, handler, info] {
+                if (!token.expired()) {
+                    (this->*handler)(info);
+                }
+            });
+        };
+    }
+
+    /**
+     * CONNECT: check disk space, get stream properties, start a new pipeline
+     */
+    void enterConnect() {
+        if (!shouldRun) return;
+        state = CameraState::CONNECTING;
+
+        // Check disk space before starting
+        if (!storageManager->hasEnoughSpace()) {
+            Logger::error("Insufficient disk space to continue recording " + cameraName);
+            Logger::info("Waiting for cleanup to free space...");
+            enterBackoff(DISK_WAIT_SECONDS);
+            return;
+        }
+
+        if (needsProbe()) {
+            StreamAnalyzer::StreamInfo cached;
+            if (streamProber->lookup(rtspUrl, cached, onLoop(&CameraRecorder::onProbeChanged))) {
+                Logger::info("Using cached stream properties for " + cameraName + " (" + cached.codec + " " +
+                             std::to_string(cached.width) + "x" + std::to_string(cached.height) + ")");
+                startPipeline(&cached);
+            } else {
+                Logger::info("Queued stream probe for " + cameraName);
+                streamProber->probe(rtspUrl, onLoop(&CameraRecorder::onProbed));
             }
+            return;
+        }
+        startPipeline(nullptr);
+    }
+
+    /**
+     * Probe pool finished a cache miss
+     */
+    void onProbed(const StreamAnalyzer::StreamInfo& info) {
+        if (!shouldRun || state != CameraState::CONNECTING || multiOutputProcess) return;
+        startPipeline(&info);
+    }
+
+    /**
+     * Background revalidation found different stream properties: restart
+     * the pipeline so its command line matches the camera again
+     */
+    void onProbeChanged(const StreamAnalyzer::StreamInfo& info) {
+        Logger::warn("Stream properties changed for " + cameraName + " (now " + info.codec + " " +
+                     std::to_string(info.width) + "x" + std::to_string(info.height) + " " + info.pixelFormat + ")");
+        if (!multiOutputProcess || restartRequested) return;
+
+        restartRequested = true;
+        multiOutputProcess->requestStop();
+    }
+
+    void startPipeline(const StreamAnalyzer::StreamInfo* probedInfo) {
+        // PHASE 3: Create single process with dual outputs (Recording + Live High)
+        RecordingPipeline* pipeline = createPipeline(probedInfo);
+
+        // Start multi-output process
+        if (!pipeline->start()) {
+            Logger::error("Failed to start multi-output process for " + cameraName +
+                        " (attempt " + std::to_string(consecutiveFailures + 1) + "/" +
+                        std::to_string(maxRetries) + ")");
+            delete pipeline;
+            onFailure();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pipelineMutex);
+            multiOutputProcess = pipeline;
+        }
+
+        // PROBE: wait for the pipeline to report the stream open
+        state = CameraState::PROBING;
+        int eventFd = pipeline->getEventFd();
+        if (eventFd >= 0) {
+            reactor->watch(loopIndex, eventFd, this);
+        }
+        timer->arm(STATUS_POLL_SECONDS * 1000, getPollSeconds() * 1000);
+        checkPipeline();
+    }
+
+    /**
+     * Timer interval while a pipeline runs: event fd pipelines only need
+     * the disk check, unless the first segment is still awaited
+     */
+    int getPollSeconds() const {
+        bool awaitingSegment = startupTracker && !firstSegmentReported;
+        bool hasEventFd = multiOutputProcess && multiOutputProcess->getEventFd() >= 0;
+        return (hasEventFd && !awaitingSegment) ? DISK_CHECK_SECONDS : STATUS_POLL_SECONDS;
+    }
+
+    /**
+     * Follow PROBING -> RUNNING and detect pipeline exit
+     */
+    void checkPipeline() {
+        if (!multiOutputProcess) return;
+
+        if (!multiOutputProcess->checkStatus()) {
+            if (restartRequested) {
+                restartRequested = false;
+                releasePipeline();
+                Logger::info("Restarting " + cameraName + " with new stream properties");
+                enterConnect();
+                return;
+            }
+
+            Logger::warn("Multi-output process stopped unexpectedly for " + cameraName);
+            bool wasStable = state == CameraState::RUNNING &&
+                             std::chrono::steady_clock::now() - runningSince >= std::chrono::seconds(STABLE_RUN_SECONDS);
+            releasePipeline();
+
+            // A crash after a stable run reconnects right away: the footage
+            // gap is the reconnect time, not reconnect + retry delay
+            if (wasStable) {
+                consecutiveFailures++;
+                Logger::info("Restarting " + cameraName + " immediately");
+                enterConnect();
+                return;
+            }
+            onFailure();
+            return;
+        }
+
+        if (state == CameraState::PROBING && multiOutputProcess->isStreaming()) {
+            state = CameraState::RUNNING;
+            runningSince = std::chrono::steady_clock::now();
+            lastDiskCheck = runningSince;
 
             // Process started successfully - reset failure counter
             Logger::info("Multi-output process started successfully for " + cameraName);
-            Logger::info("  PHASE 3: Single process with dual outputs");
-            Logger::info("  Output 1: Recording (H.265 NVENC)");
-            Logger::info("  Output 2: Live High (H.264 NVENC)");
+            Logger::info("  Backend: " + multiOutputProcess->getBackendName());
             if (consecutiveFailures > 0) {
                 Logger::info("Camera " + cameraName + " recovered after " +
                            std::to_string(consecutiveFailures) + " failures");
             }
             consecutiveFailures = 0;
 
-            // Monitor process
-            while (shouldRun && multiOutputProcess->checkStatus()) {
+            // Pipelines that probe their own session keep the cache current
+            if (streamProber && !needsProbe()) {
+                streamProber->store(rtspUrl, multiOutputProcess->getStreamInfo());
+            }
+        }
 
-                // Periodic disk space check
-                static int checkCounter = 0;
-                if (++checkCounter % 60 == 0) {  // Check every 5 minutes (60 * 5 seconds)
-                    if (!storageManager->hasEnoughSpace()) {
-                        Logger::warn("Disk space low during recording for " + cameraName);
-                        // Continue recording but alert - cleanup will handle it
-                    }
-                }
+        if (startupTracker && !firstSegmentReported && state == CameraState::RUNNING &&
+            multiOutputProcess->hasRecordedSegment()) {
+            firstSegmentReported = true;
+            startupTracker->recordFirstSegment(cameraName);
+            timer->arm(getPollSeconds() * 1000, getPollSeconds() * 1000);
+        }
+    }
 
-                std::this_thread::sleep_for(std::chrono::seconds(5));
-            }
+    void checkDiskSpace() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastDiskCheck < std::chrono::seconds(DISK_CHECK_SECONDS)) return;
+        lastDiskCheck = now;
 
-            // Process stopped
-            if (shouldRun) {
-                Logger::warn("Multi-output process stopped unexpectedly for " + cameraName +
-                           ", restarting in " + std::to_string(retryDelaySeconds) + " seconds...");
+        if (!segmentsReported) {
+            storageManager->syncCameraSegments(cameraName);
+        }
 
-                // Cleanup process
-                delete multiOutputProcess;
-                multiOutputProcess = nullptr;
+        if (!storageManager->hasEnoughSpace()) {
+            Logger::warn("Disk space low during recording for " + cameraName);
+            // Continue recording but alert - cleanup will handle it
+        }
+    }
 
-                consecutiveFailures++;
-                std::this_thread::sleep_for(std::chrono::seconds(retryDelaySeconds));
-            } else {
-                // Graceful shutdown requested
-                delete multiOutputProcess;
-                multiOutputProcess = nullptr;
+    /**
+     * BACKOFF (retry later) or FAILED (retry limit reached)
+     */
+    void onFailure() {
+        consecutiveFailures++;
+        if (consecutiveFailures >= maxRetries) {
+            Logger::error("Camera " + cameraName + " exceeded maximum retries (" +
+                        std::to_string(maxRetries) + "). Marking as failed.");
+            Logger::error("Manual intervention required. Please check camera connectivity and restart service.");
+            timer->disarm();
+            state = CameraState::FAILED;
+            return;
+        }
+
+        // Wait before retry with exponential backoff
+        int delaySeconds = retryDelaySeconds * (consecutiveFailures > 3 ? 2 : 1);
+        Logger::info("Retrying in " + std::to_string(delaySeconds) + " seconds for " + cameraName);
+        enterBackoff(delaySeconds);
+    }
+
+    void enterBackoff(int seconds) {
+        state = CameraState::BACKOFF;
+        timer->arm((int64_t)seconds * 1000);
+    }
+
+    /**
+     * Detach the current pipeline from the reactor and delete it
+     */
+    void releasePipeline() {
+        RecordingPipeline* pipeline;
+        {
+            std::lock_guard<std::mutex> lock(pipelineMutex);
+            pipeline = multiOutputProcess;
+            multiOutputProcess = nullptr;
+            if (pipeline) {
+                retiredBytes += pipeline->getBytesWritten();
             }
         }
+        if (!pipeline) return;
 
-        Logger::info("Recording thread stopped for " + cameraName);
+        if (pipeline->getEventFd() >= 0) {
+            reactor->unwatch(loopIndex, pipeline->getEventFd());
+        }
+        delete pipeline;
+    }
+
+    /**
+     * Runs on the reactor loop when the recorder starts
+     */
+    void onStart() {
+        Logger::info("Recording started for " + cameraName + " (reactor loop " + std::to_string(loopIndex) + ")");
+
+        // Create camera directory (on the volume StorageManager picks)
+        cameraRecordingPath = storageManager->getCameraDirectory(cameraName);
+        if (cameraRecordingPath.empty()) {
+            Logger::error("Failed to create directory for " + cameraName);
+            state = CameraState::FAILED;
+            return;
+        }
+        Logger::info("Created directory: " + cameraRecordingPath);
+
+        consecutiveFailures = 0;
+        restartRequested = false;
+        probeToken = std::make_shared<bool>(true);
+        timer.reset(new ReactorTimer());
+        reactor->watch(loopIndex, timer->getFd(), this);
+        enterConnect();
     }
 
 public:
     CameraRecorder(int id, const std::string& idStr, const std::string& name,
-                   const std::string& url, const std::string& path,
+                   const std::string& url,
                    std::shared_ptr<StorageManager> storage,
-                   int maxRetry = 10, int retryDelay = 5)
+                   std::shared_ptr<CameraReactor> cameraReactor,
+                   int maxRetry = 10, int retryDelay = 5,
+                   PipelineBackend backend = PipelineBackend::LIBAV,
+                   RecordingMode mode = RecordingMode::AUTO)
         : cameraId(id), cameraIdStr(idStr), cameraName(name), rtspUrl(url),
-          baseRecordingPath(path), shouldRun(false),
-          storageManager(storage), maxRetries(maxRetry), retryDelaySeconds(retryDelay),
-          consecutiveFailures(0),
-          multiOutputProcess(nullptr) {}  // PHASE 3: Single process
-
-    ~CameraRecorder() {
+          shouldRun(false), state(CameraState::STOPPED),
+          storageManager(storage), reactor(cameraReactor), loopIndex(cameraReactor->assignLoop()),
+          stoppingPipeline(nullptr), maxRetries(maxRetry), retryDelaySeconds(retryDelay),
+          consecutiveFailures(0), pipelineBackend(backend), recordingMode(mode),
+          recordingTrigger(RecordingTrigger::CONTINUOUS), fragmentSeconds(2), segmentsReported(false),
+          firstSegmentReported(false), restartRequested(false),
+          multiOutputProcess(nullptr), retiredBytes(0) {}  // PHASE 3: Single process
+
+    ~CameraRecorder() override {
         stop();
     }
 
+    /**
+     * Override pipeline creation (simulated cameras in benchmarks)
+     */
+    void setPipelineFactory(PipelineFactory factory) {
+        pipelineFactory = std::move(factory);
+    }
+
+    /**
+     * Shared probe pool/cache (ffmpeg CLI backend probes through it)
+     */
+    void setStreamProber(std::shared_ptr<StreamProber> prober) {
+        streamProber = std::move(prober);
+    }
+
+    /**
+     * Queue a recordings row per closed segment (libav backend; applies
+     * from the next start)
+     */
+    void setRecordingIngestor(std::shared_ptr<RecordingIngestor> ingestor) {
+        recordingIngestor = std::move(ingestor);
+    }
+
+    /**
+     * Continuous or event-triggered recording (applies from the next start)
+     *
+     * Event recording needs the in-process pipeline; the ffmpeg CLI
+     * backend keeps recording continuously.
+     */
+    void setRecordingTrigger(RecordingTrigger trigger, const EventRecordingGate::Settings& settings) {
+        recordingTrigger = trigger;
+        eventSettings = settings;
+        eventSettings.motionDetection = trigger == RecordingTrigger::MOTION;
+        if (trigger != RecordingTrigger::CONTINUOUS && pipelineBackend == PipelineBackend::FFMPEG_CLI) {
+            Logger::warn("Event recording is not supported by the ffmpeg backend, " + cameraName +
+                         " records continuously");
+        }
+    }
+
+    /**
+     * Fragmented MP4 segments (applies from the next start)
+     */
+    void setFragmentSeconds(int seconds) {
+        fragmentSeconds = seconds;
+    }
+
+    /**
+     * Segment file preallocation and write-behind (applies from the next start)
+     */
+    void setSegmentFileOptions(const SegmentFile::Options& options) {
+        segmentFileOptions = options;
+    }
+
+    /**
+     * Start or extend an event recording (any thread)
+     */
+    void trigger(const std::string& reason) {
+        std::lock_guard<std::mutex> lock(pipelineMutex);
+        if (multiOutputProcess) {
+            multiOutputProcess->triggerRecording(reason);
+        }
+    }
+
+    /**
+     * Fleet time-to-first-segment metric
+     */
+    void setStartupTracker(std::shared_ptr<StartupTracker> tracker) {
+        startupTracker = std::move(tracker);
+    }
+
     void start() {
         if (shouldRun) {
             Logger::warn("Recorder already running for " + cameraName);
@@ -174,11 +581,23 @@ public:
         }
 
         shouldRun = true;
-        recordingThread = std::thread(&CameraRecorder::recordLoop, this);
+        state = CameraState::CONNECTING;
+        reactor->post(loopIndex, [this] { onStart(); });
         Logger::info("Started recorder for " + cameraName);
     }
 
     void stop() {
+        beginStop();
+        finishStop(std::chrono::steady_clock::now() + std::chrono::seconds(STOP_TIMEOUT_SECONDS));
+    }
+
+    /**
+     * Detach from the reactor and ask the pipeline to stop (non-blocking)
+     *
+     * CameraManager calls this on every recorder first, then finishStop()
+     * with one shared deadline, so N cameras stop in parallel.
+     */
+    void beginStop() {
         if (!shouldRun) {
             return;
         }
@@ -186,36 +605,87 @@ public:
         Logger::info("Stopping recorder for " + cameraName);
         shouldRun = false;
 
+        // No reactor callback runs for this recorder after this returns
+        RecordingPipeline* pipeline = nullptr;
+        reactor->runSync(loopIndex, [this, &pipeline] {
+            if (timer) {
+                reactor->unwatch(loopIndex, timer->getFd());
+                timer.reset();
+            }
+            probeToken.reset();
+            std::lock_guard<std::mutex> lock(pipelineMutex);
+            pipeline = multiOutputProcess;
+            multiOutputProcess = nullptr;
+            if (pipeline) {
+                retiredBytes += pipeline->getBytesWritten();
+            }
+            if (pipeline && pipeline->getEventFd() >= 0) {
+                reactor->unwatch(loopIndex, pipeline->getEventFd());
+            }
+        });
+
         // Stop multi-output process if running
-        if (multiOutputProcess) {
-            multiOutputProcess->stop();
+        if (pipeline) {
+            pipeline->requestStop();
         }
+        stoppingPipeline = pipeline;
+    }
 
-        // Wait for thread to finish
-        if (recordingThread.joinable()) {
-            recordingThread.join();
+    /**
+     * Wait for the pipeline until the deadline, force-kill it after
+     */
+    void finishStop(std::chrono::steady_clock::time_point deadline) {
+        if (stoppingPipeline) {
+            if (!stoppingPipeline->waitStopped(deadline)) {
+                stoppingPipeline->forceStop();
+            }
+            delete stoppingPipeline;
+            stoppingPipeline = nullptr;
+        }
+        if (state != CameraState::STOPPED && !shouldRun) {
+            state = CameraState::STOPPED;
+            Logger::info("Recorder stopped for " + cameraName);
         }
-
-        Logger::info("Recorder stopped for " + cameraName);
     }
 
     std::string getStatus() const {
         if (!shouldRun) return "Stopped";
-        if (consecutiveFailures >= maxRetries) return "Failed (Max Retries)";
-        if (multiOutputProcess && multiOutputProcess->getIsRunning()) {
-            return "Recording + Live (NVENC)";
+        CameraState current = state;
+        if (current == CameraState::FAILED) return "Failed (Max Retries)";
+
+        std::lock_guard<std::mutex> lock(pipelineMutex);
+        if (current == CameraState::RUNNING && multiOutputProcess) {
+            std::string status = "Recording + Live (" + multiOutputProcess->getBackendName() + ")";
+            std::string queueStats = multiOutputProcess->getQueueStats();
+            if (!queueStats.empty()) {
+                status += " [" + queueStats + "]";
+            }
+            return status;
         }
+        if (current == CameraState::PROBING) return "Probing stream...";
         if (consecutiveFailures > 0) return "Retrying (" + std::to_string(consecutiveFailures) + "/" + std::to_string(maxRetries) + ")";
         return "Connecting...";
     }
 
+    /**
+     * Recording bytes written by this camera's pipelines, monotonic
+     */
+    uint64_t getBytesWritten() const {
+        std::lock_guard<std::mutex> lock(pipelineMutex);
+        return retiredBytes + (multiOutputProcess ? multiOutputProcess->getBytesWritten() : 0);
+    }
+
     int getId() const { return cameraId; }
+    std::string getIdString() const { return cameraIdStr; }
+    RecordingTrigger getRecordingTrigger() const { return recordingTrigger; }
     std::string getName() const { return cameraName; }
     int getConsecutiveFailures() const { return consecutiveFailures; }
-    bool hasFailed() const { return consecutiveFailures >= maxRetries; }
+    bool hasFailed() const { return state == CameraState::FAILED; }
+    CameraState getState() const { return state; }
 
     // Get encoder information
     std::string getEncoderInfo() const {
+        std::lock_guard<std::mutex> lock(pipelineMutex);
         if (multiOutputProcess && multiOutputProcess->getIsRunning()) {
             return "NVENC (H.265 + H.264)";
         }
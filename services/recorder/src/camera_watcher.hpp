@@ -0,0 +1,155 @@
+#ifndef CAMERA_WATCHER_HPP
+#define CAMERA_WATCHER_HPP
+
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "database.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+
+/**
+ * CameraWatcher - Collects changes of the cameras table (LISTEN/NOTIFY)
+ *
+ * Triggers on cameras (migration 008) NOTIFY camera_changes with the id
+ * of every inserted or deleted camera, and of cameras whose recording
+ * settings changed. One thread keeps a session of its own LISTENing
+ * (LISTEN is per session, so not a pooled connection) and gathers the
+ * ids; CameraManager takes them from the main loop and reconciles just
+ * those cameras.
+ *
+ * Notifications sent while the session was down are lost: after every
+ * (re)connect a full resync is requested instead.
+ */
+class CameraWatcher {
+public:
+    static constexpr const char* CHANNEL = "camera_changes";
+
+private:
+    static constexpr int POLL_MS = 1000;
+    static constexpr int MAX_BACKOFF_SECONDS = 30;
+
+    Database database;         // Own session, used by the watcher thread only
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    int wakeFd;
+    bool stopping;
+
+    std::set<std::string> changedIds;
+    bool resyncNeeded;
+
+    bool sleepFor(int seconds) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return !cv.wait_for(lock, std::chrono::seconds(seconds), [this] { return stopping; });
+    }
+
+    bool isStopping() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stopping;
+    }
+
+    void workerLoop() {
+        int backoffSeconds = 1;
+        while (!isStopping()) {
+            if (!database.isConnected()) {
+                database.disconnect();
+                if (!database.connect() || !database.listen(CHANNEL)) {
+                    if (!sleepFor(backoffSeconds)) break;
+                    backoffSeconds = std::min(backoffSeconds * 2, MAX_BACKOFF_SECONDS);
+                    continue;
+                }
+                backoffSeconds = 1;
+                std::lock_guard<std::mutex> lock(mutex);
+                resyncNeeded = true;   // Whatever changed while not listening
+            }
+
+            pollfd fds[2] = {{wakeFd, POLLIN, 0}, {database.getSocket(), POLLIN, 0}};
+            if (poll(fds, 2, POLL_MS) < 0) continue;
+            if (fds[0].revents & POLLIN) {
+                uint64_t value;
+                while (read(wakeFd, &value, sizeof(value)) == sizeof(value)) {}
+            }
+            if (fds[1].revents == 0) continue;
+
+            std::vector<std::string> payloads;
+            bool alive = database.takeNotifications(payloads);
+            if (!payloads.empty()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                changedIds.insert(payloads.begin(), payloads.end());
+            }
+            if (!alive) {
+                Logger::warn("CameraWatcher: connection lost, reconnecting");
+                database.disconnect();
+            }
+        }
+        database.disconnect();
+    }
+
+public:
+    explicit CameraWatcher(const Config& config)
+        : database(config, 1, 0), wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), stopping(false),
+          resyncNeeded(false) {}
+
+    ~CameraWatcher() {
+        stop();
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+    }
+
+    CameraWatcher(const CameraWatcher&) = delete;
+    CameraWatcher& operator=(const CameraWatcher&) = delete;
+
+    void start() {
+        if (worker.joinable()) return;
+        Logger::info("Camera watcher: LISTEN " + std::string(CHANNEL));
+        worker = std::thread(&CameraWatcher::workerLoop, this);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Give back changes that could not be applied (database busy or down)
+     */
+    void requeue(const std::vector<std::string>& ids, bool fullResync) {
+        std::lock_guard<std::mutex> lock(mutex);
+        changedIds.insert(ids.begin(), ids.end());
+        resyncNeeded = resyncNeeded || fullResync;
+    }
+
+    /**
+     * Ids changed since the last call; fullResync = notifications may
+     * have been missed, diff everything
+     */
+    std::vector<std::string> takeChanges(bool& fullResync) {
+        std::lock_guard<std::mutex> lock(mutex);
+        fullResync = resyncNeeded;
+        resyncNeeded = false;
+        std::vector<std::string> ids(changedIds.begin(), changedIds.end());
+        changedIds.clear();
+        return ids;
+    }
+};
+
+#endif // CAMERA_WATCHER_HPP
@@ -0,0 +1,91 @@
+#ifndef CHUNK_INDEX_HPP
+#define CHUNK_INDEX_HPP
+
+#include <string>
+#include <cstdint>
+#include "index_file.hpp"
+
+/**
+ * ChunkIndex - Offset index of a packed chunk file
+ *
+ * In chunk mode (RECORDING_CHUNK_MINUTES > 0) a camera's segments are
+ * appended back to back into <camera>_YYYYMMDD_HHMMSS.chunk, one file per
+ * chunk period instead of one per segment. Every segment is a complete
+ * MP4 (its box offsets are relative to its own first byte), so bytes
+ * [offset, offset + length) of the chunk play on their own.
+ *
+ * The sidecar <camera>_YYYYMMDD_HHMMSS.idx lists them:
+ *   8 bytes   magic "VMSCIX01"
+ *   32 bytes  per segment, little endian:
+ *             u64 offset, u64 length, i64 start (Unix ms), u32 duration (ms), u32 flags
+ *
+ * An entry is appended (one write) after its segment is closed, so the
+ * index only ever lists complete segments; bytes after the last entry
+ * belong to the segment being written, or to one lost in a crash.
+ * Chunks are indexed, moved between tiers and evicted as a whole,
+ * together with their sidecar.
+ */
+class ChunkIndex {
+public:
+    struct Entry {
+        uint64_t offset;
+        uint64_t length;
+        int64_t startMs;
+        uint32_t durationMs;
+        uint32_t flags;          // Reserved, 0
+    };
+
+    static constexpr size_t ENTRY_BYTES = 32;
+
+private:
+    IndexFile file;
+    uint64_t entries;
+
+public:
+    ChunkIndex() : entries(0) {}
+
+    static bool isChunkPath(const std::string& filePath) {
+        return filePath.size() > 6 && filePath.compare(filePath.size() - 6, 6, ".chunk") == 0;
+    }
+
+    /**
+     * Sidecar of a chunk file: <name>.chunk -> <name>.idx
+     */
+    static std::string pathFor(const std::string& chunkPath) {
+        return chunkPath.substr(0, chunkPath.size() - 6) + ".idx";
+    }
+
+    /**
+     * Start the index of a new chunk (truncates)
+     */
+    bool create(const std::string& chunkPath) {
+        entries = 0;
+        return file.create(pathFor(chunkPath), "VMSCIX01");
+    }
+
+    /**
+     * Add a closed segment
+     */
+    bool append(const Entry& entry) {
+        uint8_t record[ENTRY_BYTES];
+        IndexFile::putLittleEndian(record, entry.offset, 8);
+        IndexFile::putLittleEndian(record + 8, entry.length, 8);
+        IndexFile::putLittleEndian(record + 16, (uint64_t)entry.startMs, 8);
+        IndexFile::putLittleEndian(record + 24, entry.durationMs, 4);
+        IndexFile::putLittleEndian(record + 28, entry.flags, 4);
+        if (!file.append(record, ENTRY_BYTES)) {
+            return false;
+        }
+        entries++;
+        return true;
+    }
+
+    void close() {
+        file.close();
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+    uint64_t getEntryCount() const { return entries; }
+};
+
+#endif // CHUNK_INDEX_HPP
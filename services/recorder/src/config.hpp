@@ -2,6 +2,8 @@
 #define CONFIG_HPP
 
 #include <string>
+#include <vector>
+#include <sstream>
 #include <cstdlib>
 
 class Config {
@@ -18,6 +20,7 @@ public:
         redisPort = std::stoi(getEnv("REDIS_PORT", "6379"));
         
         recordingPath = getEnv("RECORDING_PATH", "/data/recordings");
+        recordingVolumes = splitList(getEnv("RECORDING_VOLUMES", ""));  // More hot volumes (JBOD), comma separated
         qsvDevice = getEnv("QSV_DEVICE", "/dev/dri/renderD128");
         lowQuality = getEnv("QSV_LOW_QUALITY", "720p");
         highQuality = getEnv("QSV_HIGH_QUALITY", "1440p");
@@ -25,11 +28,39 @@ public:
         // Storage management
         retentionDays = std::stoi(getEnv("RETENTION_DAYS", "2"));  // Default 2 days, max 30
         minFreeSpaceGB = std::stoi(getEnv("MIN_FREE_SPACE_GB", "10"));  // Minimum 10GB free
-        cleanupIntervalHours = std::stoi(getEnv("CLEANUP_INTERVAL_HOURS", "1"));  // Run cleanup every hour
+        storageSampleSeconds = std::stoi(getEnv("STORAGE_SAMPLE_SECONDS", "10"));  // Disk rate sampling interval
+        evictionHorizonMinutes = std::stoi(getEnv("EVICTION_HORIZON_MINUTES", "30"));  // Evict when full sooner than this
+        
+        // Storage tiers (empty path = tier not used)
+        warmPath = getEnv("RECORDING_PATH_WARM", "");
+        coldPath = getEnv("RECORDING_PATH_COLD", "");
+        tierWarmAfterHours = std::stoi(getEnv("TIER_WARM_AFTER_HOURS", "24"));  // hot -> warm
+        tierColdAfterDays = std::stoi(getEnv("TIER_COLD_AFTER_DAYS", "7"));  // warm -> cold
+        tierMoveMBps = std::stoi(getEnv("TIER_MOVE_MBPS", "50"));  // Migration bandwidth cap
         
         // Recording settings
         maxRetries = std::stoi(getEnv("MAX_RETRIES", "10"));  // Max reconnect attempts
         retryDelaySeconds = std::stoi(getEnv("RETRY_DELAY_SECONDS", "5"));  // Delay between retries
+        pipelineBackend = getEnv("RECORDER_PIPELINE", "libav");  // libav (in-process) or ffmpeg (CLI fallback)
+        reactorThreads = std::stoi(getEnv("RECORDER_REACTOR_THREADS", "0"));  // 0 = one per CPU core
+        probeWorkers = std::stoi(getEnv("RECORDER_PROBE_WORKERS", "8"));  // Concurrent stream probes
+        probeCachePath = getEnv("RECORDER_PROBE_CACHE", recordingPath + "/.probe_cache");
+        eventPollSeconds = std::stoi(getEnv("RECORDER_EVENT_POLL_SECONDS", "1"));  // events table -> triggers
+        preRollMaxMB = std::stoi(getEnv("RECORDER_PREROLL_MAX_MB", "64"));  // Per camera pre-roll memory cap
+        fragmentSeconds = std::stoi(getEnv("RECORDER_FRAGMENT_SECONDS", "2"));  // fMP4 fragments, 0 = classic MP4
+        preallocateSegments = getEnv("RECORDER_PREALLOCATE", "true") == "true";  // fallocate segments, trim on close
+        dropWriteCache = getEnv("RECORDER_DROP_WRITE_CACHE", "true") == "true";  // Write-behind + fadvise DONTNEED
+        chunkMinutes = std::stoi(getEnv("RECORDING_CHUNK_MINUTES", "0"));  // Pack segments into chunk files, 0 = file per segment
+        writeBackend = getEnv("RECORDER_WRITE_BACKEND", "io_uring");  // io_uring (threads fallback), threads, sync
+        writeInFlightMB = std::stoi(getEnv("RECORDER_WRITE_INFLIGHT_MB", "8"));  // Per camera queued write cap
+        ingestQueueRows = std::stoi(getEnv("RECORDER_INGEST_QUEUE_ROWS", "20000"));  // recordings rows waiting for the database
+        ingestBatchRows = std::stoi(getEnv("RECORDER_INGEST_BATCH_ROWS", "500"));  // Rows per COPY batch
+        dbPoolSize = std::stoi(getEnv("RECORDER_DB_POOL_SIZE", "4"));  // Postgres connections shared by recorder threads
+        dbPoolWaitMs = std::stoi(getEnv("RECORDER_DB_POOL_WAIT_MS", "2000"));  // Max wait for a free connection
+        heartbeatSeconds = std::stoi(getEnv("RECORDER_HEARTBEAT_SECONDS", "5"));  // cameras.last_seen updates, 0 = off
+        cameraResyncSeconds = std::stoi(getEnv("RECORDER_CAMERA_RESYNC_SECONDS", "300"));  // Full camera set diff besides NOTIFY, 0 = off
+        partitionDaysAhead = std::stoi(getEnv("RECORDER_PARTITION_DAYS_AHEAD", "7"));  // Daily partitions created ahead
+        metricsRetentionDays = std::stoi(getEnv("RECORDER_METRICS_RETENTION_DAYS", "30"));  // system_metrics partitions kept, 0 = all
         
         return !dbPassword.empty();
     }
@@ -40,17 +71,22 @@ public:
     std::string getDbUser() const { return dbUser; }
     std::string getDbPassword() const { return dbPassword; }
     std::string getConnectionString() const {
+        // Keepalives: a dead server or link turns the connection bad
+        // within ~1 min without probe queries
         return "host=" + dbHost + 
                " port=" + std::to_string(dbPort) +
                " dbname=" + dbName +
                " user=" + dbUser +
-               " password=" + dbPassword;
+               " password=" + dbPassword +
+               " connect_timeout=10 keepalives=1 keepalives_idle=30 keepalives_interval=10"
+               " keepalives_count=3 tcp_user_timeout=60000";
     }
     
     std::string getRedisHost() const { return redisHost; }
     int getRedisPort() const { return redisPort; }
     
     std::string getRecordingPath() const { return recordingPath; }
+    std::vector<std::string> getRecordingVolumes() const { return recordingVolumes; }
     std::string getQsvDevice() const { return qsvDevice; }
     std::string getLowQuality() const { return lowQuality; }
     std::string getHighQuality() const { return highQuality; }
@@ -58,11 +94,39 @@ public:
     // Storage management getters
     int getRetentionDays() const { return retentionDays; }
     uint64_t getMinFreeSpaceGB() const { return minFreeSpaceGB; }
-    int getCleanupIntervalHours() const { return cleanupIntervalHours; }
+    int getStorageSampleSeconds() const { return storageSampleSeconds; }
+    int getEvictionHorizonMinutes() const { return evictionHorizonMinutes; }
+    
+    // Storage tier getters
+    std::string getWarmPath() const { return warmPath; }
+    std::string getColdPath() const { return coldPath; }
+    int getTierWarmAfterHours() const { return tierWarmAfterHours; }
+    int getTierColdAfterDays() const { return tierColdAfterDays; }
+    int getTierMoveMBps() const { return tierMoveMBps; }
     
     // Recording settings getters
     int getMaxRetries() const { return maxRetries; }
     int getRetryDelaySeconds() const { return retryDelaySeconds; }
+    std::string getPipelineBackend() const { return pipelineBackend; }
+    int getReactorThreads() const { return reactorThreads; }
+    int getProbeWorkers() const { return probeWorkers; }
+    std::string getProbeCachePath() const { return probeCachePath; }
+    int getEventPollSeconds() const { return eventPollSeconds; }
+    int getPreRollMaxMB() const { return preRollMaxMB; }
+    int getFragmentSeconds() const { return fragmentSeconds; }
+    bool getPreallocateSegments() const { return preallocateSegments; }
+    bool getDropWriteCache() const { return dropWriteCache; }
+    int getChunkMinutes() const { return chunkMinutes; }
+    std::string getWriteBackend() const { return writeBackend; }
+    int getWriteInFlightMB() const { return writeInFlightMB; }
+    int getIngestQueueRows() const { return ingestQueueRows; }
+    int getIngestBatchRows() const { return ingestBatchRows; }
+    int getDbPoolSize() const { return dbPoolSize; }
+    int getDbPoolWaitMs() const { return dbPoolWaitMs; }
+    int getHeartbeatSeconds() const { return heartbeatSeconds; }
+    int getCameraResyncSeconds() const { return cameraResyncSeconds; }
+    int getPartitionDaysAhead() const { return partitionDaysAhead; }
+    int getMetricsRetentionDays() const { return metricsRetentionDays; }
 
 private:
     std::string dbHost, dbName, dbUser, dbPassword;
@@ -70,20 +134,62 @@ private:
     std::string redisHost;
     int redisPort;
     std::string recordingPath, qsvDevice, lowQuality, highQuality;
+    std::vector<std::string> recordingVolumes;
     
     // Storage management
     int retentionDays;
     uint64_t minFreeSpaceGB;
-    int cleanupIntervalHours;
+    int storageSampleSeconds;
+    int evictionHorizonMinutes;
+    
+    // Storage tiers
+    std::string warmPath, coldPath;
+    int tierWarmAfterHours;
+    int tierColdAfterDays;
+    int tierMoveMBps;
     
     // Recording settings
     int maxRetries;
     int retryDelaySeconds;
+    std::string pipelineBackend;
+    int reactorThreads;
+    int probeWorkers;
+    std::string probeCachePath;
+    int eventPollSeconds;
+    int preRollMaxMB;
+    int fragmentSeconds;
+    bool preallocateSegments;
+    bool dropWriteCache;
+    int chunkMinutes;
+    std::string writeBackend;
+    int writeInFlightMB;
+    int ingestQueueRows;
+    int ingestBatchRows;
+    int dbPoolSize;
+    int dbPoolWaitMs;
+    int heartbeatSeconds;
+    int cameraResyncSeconds;
+    int partitionDaysAhead;
+    int metricsRetentionDays;
     
     std::string getEnv(const char* name, const std::string& defaultValue) {
         const char* value = std::getenv(name);
         return value ? std::string(value) : defaultValue;
     }
+    
+    static std::vector<std::string> splitList(const std::string& value) {
+        std::vector<std::string> items;
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            size_t begin = item.find_first_not_of(" \t");
+            size_t end = item.find_last_not_of(" \t");
+            if (begin != std::string::npos) {
+                items.push_back(item.substr(begin, end - begin + 1));
+            }
+        }
+        return items;
+    }
 };
 
 #endif // CONFIG_HPP
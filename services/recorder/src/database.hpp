@@ -6,6 +6,12 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+#include <map>
+#include <unordered_set>
 #include <libpq-fe.h>
 #include "config.hpp"
 #include "logger.hpp"
@@ -16,13 +22,58 @@ struct Camera {
     std::string rtspUrl;
     std::string location;
     std::string status;
+    std::string recordingMode;  // auto, passthrough, transcode
+    std::string recordingTrigger;  // continuous, event, motion
+    int preRollSeconds;
+    int postRollSeconds;
+    int storageQuotaGB;     // 0 = no byte quota
+    int retentionDays;      // 0 = global RETENTION_DAYS
+};
+
+/**
+ * One closed segment for the recordings table (RecordingIngestor)
+ */
+struct RecordingRow {
+    std::string cameraId;
+    std::string filename;
+    std::string filepath;
+    uint64_t fileSize;
+    int64_t chunkOffset;        // -1 = own file
+    std::chrono::system_clock::time_point startTime;
+    double durationSeconds;
+    int width;
+    int height;
+    double fps;
+    std::string codec;
+};
+
+struct CameraEvent {
+    std::string cameraId;
+    std::string eventType;
+};
+
+/**
+ * Position of the event poll (Database::getEventsSince)
+ */
+struct EventCursor {
+    std::string createdAt;                          // Newest created_at seen, empty = start now
+    std::map<std::string, std::string> seenIds;     // Events of the overlap window returned already -> created_at
 };
 
 class Database {
 public:
     Database(const Config& cfg, int maxRetries = 3, int retryDelaySeconds = 5) 
         : config(cfg), conn(nullptr), maxReconnectRetries(maxRetries), 
-          reconnectDelaySeconds(retryDelaySeconds), consecutiveFailures(0) {}
+          reconnectDelaySeconds(retryDelaySeconds), consecutiveFailures(0), ingestTableReady(false),
+          managed(false) {}
+    
+    /**
+     * Pooled connection (DatabasePool): connected without blocking
+     * through startConnect()/pollConnect(), never reconnects by itself
+     */
+    explicit Database(const Config& cfg, bool pooled)
+        : config(cfg), conn(nullptr), maxReconnectRetries(0), reconnectDelaySeconds(0),
+          consecutiveFailures(0), ingestTableReady(false), managed(pooled) {}
     
     ~Database() {
         disconnect();
@@ -39,6 +90,8 @@ public:
         }
         
         consecutiveFailures = 0;
+        ingestTableReady = false;   // Temp tables and prepared statements belong to the session
+        prepared.clear();
         Logger::info("Database connection established successfully");
         return true;
     }
@@ -66,22 +119,64 @@ public:
     }
     
     /**
-     * Check if connection is alive
+     * Connected, as far as libpq knows (no round trip)
+     *
+     * A dead peer shows up as CONNECTION_BAD after the next query fails;
+     * TCP keepalives (Config::getConnectionString) make that happen
+     * within a minute even on an idle connection.
      */
-    bool isConnected() {
-        if (!conn) return false;
-        
-        PGresult* res = PQexec(conn, "SELECT 1");
-        bool alive = (PQresultStatus(res) == PGRES_TUPLES_OK);
-        PQclear(res);
-        
-        return alive;
+    bool isConnected() const {
+        return conn && PQstatus(conn) == CONNECTION_OK;
+    }
+    
+    /**
+     * Begin a non-blocking connect (PQconnectStart); drive it with
+     * pollConnect() whenever getSocket() is ready
+     */
+    bool startConnect() {
+        disconnect();
+        conn = PQconnectStart(config.getConnectionString().c_str());
+        if (!conn || PQstatus(conn) == CONNECTION_BAD) {
+            lastError = conn ? PQerrorMessage(conn) : "out of memory";
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * One step of the connect: READING / WRITING = wait for the socket,
+     * OK = connected, FAILED = given up (getLastError())
+     */
+    PostgresPollingStatusType pollConnect() {
+        if (!conn) return PGRES_POLLING_FAILED;
+        PostgresPollingStatusType status = PQconnectPoll(conn);
+        if (status == PGRES_POLLING_OK) {
+            consecutiveFailures = 0;
+            ingestTableReady = false;   // New session
+            prepared.clear();
+        } else if (status == PGRES_POLLING_FAILED) {
+            lastError = PQerrorMessage(conn);
+            disconnect();
+        }
+        return status;
+    }
+    
+    int getSocket() const {
+        return conn ? PQsocket(conn) : -1;
+    }
+    
+    std::string getLastError() const {
+        return lastError;
     }
     
     /**
-     * Reconnect if connection is lost
+     * Reconnect if connection is lost (pooled: the pool reconnects)
      */
     bool ensureConnection() {
+        if (managed) {
+            return isConnected();
+        }
         if (isConnected()) {
             consecutiveFailures = 0;
             return true;
@@ -101,8 +196,13 @@ public:
         }
     }
     
-    std::vector<Camera> getCameras() {
+    /**
+     * Online cameras
+     * @param ok Set to false on error (an empty result is then no answer)
+     */
+    std::vector<Camera> getCameras(bool* ok = nullptr) {
         std::vector<Camera> cameras;
+        if (ok) *ok = false;
         
         // Ensure connection is alive
         if (!ensureConnection()) {
@@ -110,74 +210,377 @@ public:
             return cameras;
         }
         
-        const char* query = "SELECT id, name, rtsp_url, location, status FROM cameras WHERE status = 'online' ORDER BY created_at";
-        PGresult* res = PQexec(conn, query);
+        std::string query = std::string(CAMERA_COLUMNS) + " WHERE status = 'online' ORDER BY created_at";
+        PGresult* res = PQexec(conn, query.c_str());
         
         if (PQresultStatus(res) != PGRES_TUPLES_OK) {
             Logger::error("Query failed: " + std::string(PQerrorMessage(conn)));
             PQclear(res);
             
-            // Mark connection as bad and retry once
+            // Connection dropped: reconnect and retry once
             consecutiveFailures++;
-            if (ensureConnection()) {
-                return getCameras();  // Retry once after reconnection
+            if (isConnected() || managed || !ensureConnection()) {
+                return cameras;
+            }
+            res = PQexec(conn, query.c_str());
+            if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+                PQclear(res);
+                return cameras;
             }
-            return cameras;
-        }
-        
-        int rows = PQntuples(res);
-        for (int i = 0; i < rows; i++) {
-            Camera cam;
-            cam.id = PQgetvalue(res, i, 0);
-            cam.name = PQgetvalue(res, i, 1);
-            cam.rtspUrl = PQgetvalue(res, i, 2);
-            cam.location = PQgetvalue(res, i, 3);
-            cam.status = PQgetvalue(res, i, 4);
-            cameras.push_back(cam);
         }
         
+        cameras = parseCameras(res);
         PQclear(res);
         consecutiveFailures = 0;
+        if (ok) *ok = true;
         return cameras;
     }
     
-    bool updateCameraStatus(const std::string& id, const std::string& status) {
+    /**
+     * Online cameras among the given ids (changed cameras, LISTEN)
+     * @param ok false on error (the result then says nothing about the ids)
+     */
+    std::vector<Camera> getCamerasById(const std::vector<std::string>& ids, bool& ok) {
+        ok = false;
+        if (!ensureConnection() ||
+            !prepareOnce("cameras_by_id",
+                         (std::string(CAMERA_COLUMNS) + " WHERE id = ANY($1::uuid[]) AND status = 'online'").c_str(), 1)) {
+            return {};
+        }
+        std::string array = "{";
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (i > 0) array += ',';
+            array += ids[i];
+        }
+        array += '}';
+        const char* paramValues[1] = {array.c_str()};
+        PGresult* res = PQexecPrepared(conn, "cameras_by_id", 1, paramValues, nullptr, nullptr, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            Logger::error("Camera lookup failed: " + std::string(PQerrorMessage(conn)));
+            PQclear(res);
+            return {};
+        }
+        std::vector<Camera> cameras = parseCameras(res);
+        PQclear(res);
+        ok = true;
+        return cameras;
+    }
+    
+    /**
+     * Subscribe this session to a NOTIFY channel
+     */
+    bool listen(const std::string& channel) {
         if (!ensureConnection()) return false;
+        std::string query = "LISTEN " + channel;
+        PGresult* res = PQexec(conn, query.c_str());
+        bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok) {
+            Logger::error("LISTEN " + channel + " failed: " + std::string(PQerrorMessage(conn)));
+        }
+        PQclear(res);
+        return ok;
+    }
+    
+    /**
+     * Payloads of notifications received so far (call when getSocket()
+     * is readable); false = connection lost
+     */
+    bool takeNotifications(std::vector<std::string>& payloads) {
+        if (!conn || PQconsumeInput(conn) != 1) {
+            return false;
+        }
+        PGnotify* notify;
+        while ((notify = PQnotifies(conn)) != nullptr) {
+            payloads.push_back(notify->extra ? notify->extra : "");
+            PQfreemem(notify);
+        }
+        return isConnected();
+    }
+    
+    bool updateCameraStatus(const std::string& id, const std::string& status) {
+        if (!ensureConnection() ||
+            !prepareOnce("camera_status", "UPDATE cameras SET status = $1, updated_at = NOW() WHERE id = $2", 2)) {
+            return false;
+        }
         
-        const char* query = "UPDATE cameras SET status = $1, updated_at = NOW() WHERE id = $2";
         const char* paramValues[2] = {status.c_str(), id.c_str()};
         
-        PGresult* res = PQexecParams(conn, query, 2, nullptr, paramValues, nullptr, nullptr, 0);
+        PGresult* res = PQexecPrepared(conn, "camera_status", 2, paramValues, nullptr, nullptr, 0);
         bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
         
         PQclear(res);
         return success;
     }
     
-    bool insertRecording(const std::string& cameraId, const std::string& filename, 
-                        const std::string& quality, int64_t fileSize) {
-        if (!ensureConnection()) return false;
+    /**
+     * Set last_seen = NOW() for recording cameras, in one round trip
+     *
+     * Ids go HEARTBEAT_CHUNK at a time into a prepared = ANY($1) UPDATE,
+     * and all chunks are sent in pipeline mode with a single sync, so 500
+     * cameras are 5 statements and one wait for the server.
+     */
+    bool updateCameraHeartbeats(const std::vector<std::string>& cameraIds) {
+        if (cameraIds.empty()) return true;
+        if (!ensureConnection() ||
+            !prepareOnce("camera_heartbeat", "UPDATE cameras SET last_seen = NOW() WHERE id = ANY($1::uuid[])", 1)) {
+            return false;
+        }
+        if (PQenterPipelineMode(conn) != 1) {
+            Logger::error("Cannot enter pipeline mode: " + std::string(PQerrorMessage(conn)));
+            return false;
+        }
         
-        const char* query = "INSERT INTO recordings (camera_id, filename, file_path, quality, file_size, start_time) VALUES ($1, $2, $3, $4, $5, NOW())";
+        size_t sent = 0;
+        bool ok = true;
+        for (size_t first = 0; first < cameraIds.size(); first += HEARTBEAT_CHUNK) {
+            size_t last = std::min(first + HEARTBEAT_CHUNK, cameraIds.size());
+            std::string array = "{";
+            for (size_t i = first; i < last; i++) {
+                if (i > first) array += ',';
+                array += cameraIds[i];
+            }
+            array += '}';
+            const char* paramValues[1] = {array.c_str()};
+            if (PQsendQueryPrepared(conn, "camera_heartbeat", 1, paramValues, nullptr, nullptr, 0) != 1) {
+                ok = false;
+                break;
+            }
+            sent++;
+        }
+        ok = PQpipelineSync(conn) == 1 && ok;
+        ok = drainPipeline(sent) && ok;
+        if (!ok) {
+            Logger::error("Camera heartbeat failed: " + std::string(PQerrorMessage(conn)));
+        }
+        if (PQexitPipelineMode(conn) != 1) {
+            disconnect();   // Results left over: the session is unusable, reconnect
+        }
+        return ok;
+    }
+    
+    /**
+     * Insert closed segments in one batch (RecordingIngestor connection)
+     *
+     * COPY into a session temp table, then one INSERT .. SELECT: rows the
+     * API disk scan added already are skipped (ON CONFLICT), rows of
+     * cameras deleted meanwhile are dropped (join on cameras). Three
+     * round trips whatever the batch size.
+     * Returns: rows inserted, -1 on error (nothing written, sqlState set
+     * to the SQLSTATE of the server error, empty if there was none)
+     */
+    int copyRecordings(const std::vector<RecordingRow>& rows, std::string& sqlState) {
+        sqlState.clear();
+        if (rows.empty()) return 0;
+        if (!ensureConnection()) return -1;
         
-        std::string filePath = config.getRecordingPath() + "/" + filename;
-        std::string fileSizeStr = std::to_string(fileSize);
+        std::string query;
+        if (!ingestTableReady) {
+            query = "CREATE TEMP TABLE IF NOT EXISTS recording_ingest ("
+                    "camera_id UUID, filename VARCHAR(255), filepath TEXT, file_size BIGINT, chunk_offset BIGINT, "
+                    "start_time TIMESTAMP, end_time TIMESTAMP, duration INT, resolution VARCHAR(20), fps INT, "
+                    "codec VARCHAR(50), bitrate BIGINT) ON COMMIT DELETE ROWS; ";
+        }
+        query += "BEGIN; COPY recording_ingest FROM STDIN";
+        PGresult* res = PQexec(conn, query.c_str());
+        if (PQresultStatus(res) != PGRES_COPY_IN) {
+            Logger::error("Failed to start recordings COPY: " + std::string(PQerrorMessage(conn)));
+            sqlState = sqlStateOf(res);
+            PQclear(res);
+            rollback();
+            return -1;
+        }
+        PQclear(res);
+        ingestTableReady = true;
         
-        const char* paramValues[5] = {
-            cameraId.c_str(),
-            filename.c_str(),
-            filePath.c_str(),
-            quality.c_str(),
-            fileSizeStr.c_str()
-        };
+        std::string data;
+        data.reserve(rows.size() * 256);
+        for (const auto& row : rows) {
+            appendCopyRow(data, row);
+        }
+        bool sent = PQputCopyData(conn, data.data(), (int)data.size()) == 1;
+        sent = PQputCopyEnd(conn, sent ? nullptr : "send failed") == 1 && sent;
+        bool copied = sent;
+        while ((res = PQgetResult(conn)) != nullptr) {
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+                copied = false;
+                if (sqlState.empty()) sqlState = sqlStateOf(res);
+            }
+            PQclear(res);
+        }
+        if (!copied) {
+            Logger::error("Recordings COPY failed: " + std::string(PQerrorMessage(conn)));
+            rollback();
+            return -1;
+        }
         
-        PGresult* res = PQexecParams(conn, query, 5, nullptr, paramValues, nullptr, nullptr, 0);
-        bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
+        const char* insert =
+            "INSERT INTO recordings (camera_id, filename, filepath, file_size, chunk_offset, start_time, end_time, "
+            "duration, resolution, fps, codec, bitrate, storage_tier) "
+            "SELECT s.camera_id, s.filename, s.filepath, s.file_size, s.chunk_offset, s.start_time, s.end_time, "
+            "s.duration, s.resolution, s.fps, s.codec, s.bitrate, 'hot' "
+            "FROM recording_ingest s JOIN cameras c ON c.id = s.camera_id "
+            "ON CONFLICT (camera_id, start_time) DO NOTHING; COMMIT";
+        int inserted = -1;
+        bool committed = false;
+        if (PQsendQuery(conn, insert) == 1) {
+            while ((res = PQgetResult(conn)) != nullptr) {
+                if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+                    if (inserted < 0) {
+                        inserted = std::atoi(PQcmdTuples(res));   // INSERT, then COMMIT
+                    } else {
+                        committed = true;
+                    }
+                } else if (sqlState.empty()) {
+                    sqlState = sqlStateOf(res);
+                }
+                PQclear(res);
+            }
+        }
+        if (!committed) {
+            Logger::error("Failed to insert recordings: " + std::string(PQerrorMessage(conn)));
+            rollback();
+            return -1;
+        }
+        return inserted;
+    }
+    
+    /**
+     * Point a recording at its new file after a tier move
+     *
+     * One UPDATE: path and tier change together or not at all.
+     * Returns: rows updated (0 = not synced by the API yet), -1 on error
+     */
+    int updateRecordingLocation(const std::string& oldPath, const std::string& newPath,
+                                const std::string& tier) {
+        if (!ensureConnection() ||
+            !prepareOnce("recording_location",
+                         "UPDATE recordings SET filepath = $2, storage_tier = $3 WHERE filepath = $1", 3)) {
+            return -1;
+        }
+        
+        const char* paramValues[3] = {oldPath.c_str(), newPath.c_str(), tier.c_str()};
+        
+        PGresult* res = PQexecPrepared(conn, "recording_location", 3, paramValues, nullptr, nullptr, 0);
+        int rows = -1;
+        if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+            rows = std::atoi(PQcmdTuples(res));
+        } else {
+            Logger::error("Failed to update recording location: " + std::string(PQerrorMessage(conn)));
+        }
         
         PQclear(res);
-        return success;
+        return rows;
+    }
+    
+    /**
+     * Events inserted since the cursor
+     *
+     * created_at is the inserting transaction's start, so an event can
+     * commit after a poll went past its created_at: every poll looks
+     * EVENT_OVERLAP_SECONDS back and skips the ids it returned already
+     * (which also pages past LIMIT ties). An empty cursor starts at the
+     * current time, so events from before the recorder started are not
+     * replayed.
+     */
+    std::vector<CameraEvent> getEventsSince(EventCursor& cursor) {
+        std::vector<CameraEvent> events;
+        if (!ensureConnection()) return events;
+
+        if (cursor.createdAt.empty()) {
+            PGresult* res = PQexec(conn, "SELECT LOCALTIMESTAMP::text");
+            if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+                cursor.createdAt = PQgetvalue(res, 0, 0);
+            }
+            PQclear(res);
+            return events;
+        }
+
+        if (!prepareOnce("events_since",
+                         "SELECT id, camera_id, event_type, created_at::text FROM events "
+                         "WHERE created_at >= $1::timestamp - $2::int * interval '1 second' "
+                         "AND NOT (id = ANY($3::uuid[])) ORDER BY created_at, id LIMIT 1000", 3)) {
+            return events;
+        }
+        std::string overlap = std::to_string(EVENT_OVERLAP_SECONDS);
+        std::string seen = "{";
+        for (const auto& item : cursor.seenIds) {
+            if (seen.size() > 1) seen += ',';
+            seen += item.first;
+        }
+        seen += '}';
+        const char* paramValues[3] = {cursor.createdAt.c_str(), overlap.c_str(), seen.c_str()};
+        PGresult* res = PQexecPrepared(conn, "events_since", 3, paramValues, nullptr, nullptr, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            Logger::error("Event poll failed: " + std::string(PQerrorMessage(conn)));
+            PQclear(res);
+            return events;
+        }
+
+        int rows = PQntuples(res);
+        for (int i = 0; i < rows; i++) {
+            CameraEvent event;
+            event.cameraId = PQgetvalue(res, i, 1);
+            event.eventType = PQgetvalue(res, i, 2);
+            events.push_back(event);
+            std::string createdAt = PQgetvalue(res, i, 3);
+            cursor.seenIds[PQgetvalue(res, i, 0)] = createdAt;
+            cursor.createdAt = std::max(cursor.createdAt, createdAt);
+        }
+        PQclear(res);
+
+        // Ids older than the window cannot come back
+        std::string windowStart = shiftTimestamp(cursor.createdAt, -EVENT_OVERLAP_SECONDS);
+        for (auto it = cursor.seenIds.begin(); it != cursor.seenIds.end();) {
+            it = it->second < windowStart ? cursor.seenIds.erase(it) : std::next(it);
+        }
+        return events;
+    }
+
+    /**
+     * Daily partitions of recordings, events and system_metrics up to
+     * daysAhead days from today (ensure_time_partitions, init.sql)
+     * Returns: partitions created, -1 on error
+     */
+    int ensureTimePartitions(int daysAhead) {
+        if (!ensureConnection()) return -1;
+        
+        std::string days = std::to_string(daysAhead);
+        const char* paramValues[1] = {days.c_str()};
+        PGresult* res = PQexecParams(conn, "SELECT ensure_time_partitions($1::int)", 1, nullptr, paramValues,
+                                     nullptr, nullptr, 0);
+        int created = -1;
+        if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+            created = std::atoi(PQgetvalue(res, 0, 0));
+        } else {
+            Logger::error("Failed to create time partitions: " + std::string(PQerrorMessage(conn)));
+        }
+        
+        PQclear(res);
+        return created;
     }
     
+    /**
+     * Retention of a time-partitioned table: drop the daily partitions
+     * ending on or before cutoffDay (YYYY-MM-DD, server local date)
+     * Returns: partitions dropped, -1 on error
+     */
+    int dropTimePartitionsBefore(const std::string& table, const std::string& cutoffDay) {
+        if (!ensureConnection()) return -1;
+        
+        const char* paramValues[2] = {table.c_str(), cutoffDay.c_str()};
+        PGresult* res = PQexecParams(conn, "SELECT drop_time_partitions_before($1::regclass, $2::date)", 2, nullptr,
+                                     paramValues, nullptr, nullptr, 0);
+        int dropped = -1;
+        if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+            dropped = std::atoi(PQgetvalue(res, 0, 0));
+        } else {
+            Logger::error("Failed to drop " + table + " partitions: " + std::string(PQerrorMessage(conn)));
+        }
+        
+        PQclear(res);
+        return dropped;
+    }
+
     int getConsecutiveFailures() const {
         return consecutiveFailures;
     }
@@ -188,6 +591,152 @@ private:
     int maxReconnectRetries;
     int reconnectDelaySeconds;
     int consecutiveFailures;
+    bool ingestTableReady;      // recording_ingest exists in this session
+    bool managed;               // Owned by DatabasePool
+    std::unordered_set<std::string> prepared;   // Statement names prepared in this session
+    std::string lastError;      // Of the last failed non-blocking connect
+    
+    static constexpr size_t HEARTBEAT_CHUNK = 100;
+    static constexpr int EVENT_OVERLAP_SECONDS = 30;   // Longest insert transaction whose event is still seen
+    static constexpr const char* CAMERA_COLUMNS =
+        "SELECT id, name, rtsp_url, location, status, COALESCE(recording_mode, 'auto'), "
+        "COALESCE(recording_trigger, 'continuous'), COALESCE(pre_roll_seconds, 10), "
+        "COALESCE(post_roll_seconds, 30), COALESCE(storage_quota_gb, 0), "
+        "COALESCE(retention_days, 0) FROM cameras";
+    
+    static std::vector<Camera> parseCameras(PGresult* res) {
+        std::vector<Camera> cameras;
+        int rows = PQntuples(res);
+        for (int i = 0; i < rows; i++) {
+            Camera cam;
+            cam.id = PQgetvalue(res, i, 0);
+            cam.name = PQgetvalue(res, i, 1);
+            cam.rtspUrl = PQgetvalue(res, i, 2);
+            cam.location = PQgetvalue(res, i, 3);
+            cam.status = PQgetvalue(res, i, 4);
+            cam.recordingMode = PQgetvalue(res, i, 5);
+            cam.recordingTrigger = PQgetvalue(res, i, 6);
+            cam.preRollSeconds = std::atoi(PQgetvalue(res, i, 7));
+            cam.postRollSeconds = std::atoi(PQgetvalue(res, i, 8));
+            cam.storageQuotaGB = std::atoi(PQgetvalue(res, i, 9));
+            cam.retentionDays = std::atoi(PQgetvalue(res, i, 10));
+            cameras.push_back(cam);
+        }
+        return cameras;
+    }
+    
+    /**
+     * Prepare a hot statement the first time this session uses it
+     */
+    bool prepareOnce(const char* name, const char* query, int paramCount) {
+        if (prepared.count(name)) return true;
+        PGresult* res = PQprepare(conn, name, query, paramCount, nullptr);
+        bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (ok) {
+            prepared.insert(name);
+        } else {
+            Logger::error("Failed to prepare " + std::string(name) + ": " + std::string(PQerrorMessage(conn)));
+        }
+        PQclear(res);
+        return ok;
+    }
+    
+    /**
+     * Read the results of queries sent in pipeline mode, up to the sync
+     */
+    bool drainPipeline(size_t queries) {
+        bool ok = true;
+        for (size_t i = 0; i < queries; i++) {
+            PGresult* res;
+            while ((res = PQgetResult(conn)) != nullptr) {
+                ExecStatusType status = PQresultStatus(res);
+                ok = ok && (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK);
+                PQclear(res);
+            }
+        }
+        PGresult* res = PQgetResult(conn);
+        ok = ok && res && PQresultStatus(res) == PGRES_PIPELINE_SYNC;
+        PQclear(res);
+        return ok;
+    }
+    
+    void rollback() {
+        PGresult* res = PQexec(conn, "ROLLBACK");
+        PQclear(res);
+    }
+    
+    /**
+     * SQLSTATE of a failed result, empty for client-side failures
+     */
+    static std::string sqlStateOf(const PGresult* res) {
+        const char* state = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : nullptr;
+        return state ? state : "";
+    }
+    
+    /**
+     * COPY text format: tab separated, \N = NULL, backslash escapes
+     */
+    static void appendCopyField(std::string& out, const std::string& value) {
+        for (char c : value) {
+            switch (c) {
+                case '\\': out += "\\\\"; break;
+                case '\t': out += "\\t"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                default: out += c;
+            }
+        }
+    }
+    
+    /**
+     * "YYYY-MM-DD HH:MM:SS[.ffffff]" (timestamp::text) moved by seconds,
+     * whole seconds; compares as text with the input format
+     */
+    static std::string shiftTimestamp(const std::string& timestamp, int seconds) {
+        std::tm tm = {};
+        if (!strptime(timestamp.c_str(), "%Y-%m-%d %H:%M:%S", &tm)) return "";
+        std::time_t t = timegm(&tm) + seconds;
+        gmtime_r(&t, &tm);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+        return buffer;
+    }
+    
+    static std::string formatTimestamp(std::chrono::system_clock::time_point when) {
+        std::time_t t = std::chrono::system_clock::to_time_t(when);
+        std::tm tm;
+        localtime_r(&t, &tm);
+        char buffer[40];
+        int ms = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(when.time_since_epoch()).count() % 1000);
+        size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+        std::snprintf(buffer + n, sizeof(buffer) - n, ".%03d", ms);
+        return buffer;
+    }
+    
+    static void appendCopyRow(std::string& out, const RecordingRow& row) {
+        int duration = (int)row.durationSeconds;
+        auto end = row.startTime + std::chrono::milliseconds((int64_t)(row.durationSeconds * 1000));
+        appendCopyField(out, row.cameraId);
+        out += '\t';
+        appendCopyField(out, row.filename);
+        out += '\t';
+        appendCopyField(out, row.filepath);
+        out += '\t' + std::to_string(row.fileSize) + '\t';
+        out += row.chunkOffset >= 0 ? std::to_string(row.chunkOffset) : "\\N";
+        out += '\t' + formatTimestamp(row.startTime) + '\t' + formatTimestamp(end) + '\t' + std::to_string(duration) + '\t';
+        out += row.width > 0 && row.height > 0 ? std::to_string(row.width) + "x" + std::to_string(row.height) : "\\N";
+        out += '\t';
+        out += row.fps > 0 ? std::to_string((int)(row.fps + 0.5)) : "\\N";
+        out += '\t';
+        if (row.codec.empty()) {
+            out += "\\N";
+        } else {
+            appendCopyField(out, row.codec);
+        }
+        out += '\t';
+        out += row.durationSeconds >= 1 ? std::to_string((int64_t)(row.fileSize * 8 / row.durationSeconds)) : "\\N";
+        out += '\n';
+    }
 };
 
 #endif // DATABASE_HPP
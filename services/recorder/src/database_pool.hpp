@@ -0,0 +1,394 @@
+#ifndef DATABASE_POOL_HPP
+#define DATABASE_POOL_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <libpq-fe.h>
+#include "database.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+
+/**
+ * DatabasePool - Fixed set of Postgres connections shared by recorder threads
+ *
+ * A thread checks a connection out with acquire() and has it to itself
+ * until the Lease goes away; a nested acquire() on the same thread gets
+ * the connection it already holds, so helpers can lease freely. When
+ * every connection is busy or down, acquire() waits at most the given
+ * time and returns an empty Lease: callers skip or retry the work, they
+ * never stall on the database.
+ *
+ * Connecting is done by one maintenance thread only, with PQconnectStart
+ * / PQconnectPoll and poll() on all sockets at once, so a reconnect storm
+ * (Postgres restarting, 500 cameras' worth of work waiting) blocks no
+ * lease holder. A connection whose PQstatus is bad when returned goes
+ * back to that thread and is reconnected with back-off (1 s doubling
+ * up to MAX_BACKOFF_SECONDS).
+ */
+class DatabasePool {
+private:
+    enum class SlotState { DOWN, CONNECTING, IDLE, LEASED };
+
+    struct Slot {
+        std::unique_ptr<Database> db;
+        SlotState state;
+        PostgresPollingStatusType polling;      // What the connect waits for
+        std::thread::id owner;
+        int depth;                              // Nested checkouts by the owner
+        int failures;                           // Connect attempts since last up
+        std::chrono::steady_clock::time_point nextAttempt;
+        std::chrono::steady_clock::time_point connectStarted;
+    };
+
+public:
+    /**
+     * Exclusive use of one connection, returned when destroyed
+     */
+    class Lease {
+    private:
+        DatabasePool* pool;
+        size_t slot;
+
+    public:
+        Lease() : pool(nullptr), slot(0) {}
+        Lease(DatabasePool* owner, size_t index) : pool(owner), slot(index) {}
+        Lease(Lease&& other) noexcept : pool(other.pool), slot(other.slot) {
+            other.pool = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                pool = other.pool;
+                slot = other.slot;
+                other.pool = nullptr;
+            }
+            return *this;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() {
+            release();
+        }
+
+        explicit operator bool() const { return pool != nullptr; }
+        Database* operator->() const { return pool->slots[slot].db.get(); }
+        Database& operator*() const { return *pool->slots[slot].db; }
+
+        void release() {
+            if (pool) {
+                pool->release(slot);
+                pool = nullptr;
+            }
+        }
+    };
+
+private:
+    static constexpr int CONNECT_TIMEOUT_SECONDS = 10;
+    static constexpr int MAX_BACKOFF_SECONDS = 30;
+    static constexpr int MAINTENANCE_POLL_MS = 500;
+
+    std::vector<Slot> slots;
+    std::chrono::milliseconds defaultWait;
+
+    std::thread maintainer;
+    std::mutex mutex;
+    std::condition_variable cv;         // A connection became idle
+    int wakeFd;                         // Wakes the maintainer (connection lost, stop)
+    bool stopping;
+
+    std::atomic<uint64_t> checkouts;
+    std::atomic<uint64_t> waitTimeouts;
+    std::atomic<uint64_t> connectionsLost;
+    std::atomic<uint64_t> reconnects;
+
+    bool findIdle(size_t& index) const {
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i].state == SlotState::IDLE) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+
+    void release(size_t index) {
+        bool lost = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot& slot = slots[index];
+            if (--slot.depth > 0) return;
+            slot.owner = std::thread::id();
+            if (slot.db->isConnected()) {
+                slot.state = SlotState::IDLE;
+            } else {
+                slot.state = SlotState::DOWN;
+                slot.nextAttempt = std::chrono::steady_clock::now();
+                lost = true;
+            }
+        }
+        if (lost) {
+            connectionsLost++;
+            Logger::warn("Database pool: connection " + std::to_string(index) + " lost, reconnecting");
+            wake();
+        } else {
+            cv.notify_one();
+        }
+    }
+
+    /**
+     * Maintenance thread only, slot not leased
+     */
+    void onConnectFailed(size_t index, const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot& slot = slots[index];
+        slot.db->disconnect();
+        slot.failures++;
+        int backoff = std::min(1 << std::min(slot.failures - 1, 5), MAX_BACKOFF_SECONDS);
+        slot.nextAttempt = std::chrono::steady_clock::now() + std::chrono::seconds(backoff);
+        slot.state = SlotState::DOWN;
+        // First failure at warn, the retries of a long outage at debug
+        std::string message = "Database pool: connection " + std::to_string(index) + " failed (attempt " +
+                              std::to_string(slot.failures) + ", retry in " + std::to_string(backoff) + " s): " + error;
+        if (slot.failures == 1) {
+            Logger::warn(message);
+        } else {
+            Logger::debug(message);
+        }
+    }
+
+    void onConnected(size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot& slot = slots[index];
+            if (slot.failures > 0) {
+                Logger::info("Database pool: connection " + std::to_string(index) + " up after " +
+                             std::to_string(slot.failures) + " failed attempts");
+            }
+            slot.failures = 0;
+            slot.state = SlotState::IDLE;
+        }
+        reconnects++;
+        cv.notify_all();
+    }
+
+    void maintainLoop() {
+        while (true) {
+            std::vector<size_t> toStart;
+            int timeoutMs = MAINTENANCE_POLL_MS;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping) break;
+                auto now = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < slots.size(); i++) {
+                    Slot& slot = slots[i];
+                    if (slot.state != SlotState::DOWN) continue;
+                    if (now >= slot.nextAttempt) {
+                        slot.state = SlotState::CONNECTING;
+                        slot.polling = PGRES_POLLING_WRITING;   // libpq: start as if writing
+                        slot.connectStarted = now;
+                        toStart.push_back(i);
+                    } else {
+                        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(slot.nextAttempt - now);
+                        timeoutMs = std::min(timeoutMs, (int)wait.count() + 1);
+                    }
+                }
+            }
+            // CONNECTING slots belong to this thread: no lock around libpq
+            for (size_t index : toStart) {
+                if (!slots[index].db->startConnect()) {
+                    onConnectFailed(index, slots[index].db->getLastError());
+                }
+            }
+
+            std::vector<pollfd> fds;
+            std::vector<size_t> polled;
+            fds.push_back({wakeFd, POLLIN, 0});
+            auto now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < slots.size(); i++) {
+                Slot& slot = slots[i];
+                SlotState state;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    state = slot.state;
+                }
+                if (state != SlotState::CONNECTING) continue;
+                if (now - slot.connectStarted > std::chrono::seconds(CONNECT_TIMEOUT_SECONDS)) {
+                    onConnectFailed(i, "timeout after " + std::to_string(CONNECT_TIMEOUT_SECONDS) + " s");
+                    continue;
+                }
+                short events = slot.polling == PGRES_POLLING_READING ? POLLIN : POLLOUT;
+                fds.push_back({slot.db->getSocket(), events, 0});
+                polled.push_back(i);
+            }
+
+            if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+                Logger::error("Database pool: poll failed: " + std::string(strerror(errno)));
+                std::this_thread::sleep_for(std::chrono::milliseconds(MAINTENANCE_POLL_MS));
+                continue;
+            }
+            if (fds[0].revents & POLLIN) {
+                uint64_t value;
+                while (read(wakeFd, &value, sizeof(value)) == sizeof(value)) {}
+            }
+            for (size_t k = 0; k < polled.size(); k++) {
+                if (fds[k + 1].revents == 0) continue;
+                size_t index = polled[k];
+                PostgresPollingStatusType status = slots[index].db->pollConnect();
+                if (status == PGRES_POLLING_OK) {
+                    onConnected(index);
+                } else if (status == PGRES_POLLING_FAILED) {
+                    onConnectFailed(index, slots[index].db->getLastError());
+                } else {
+                    slots[index].polling = status;
+                }
+            }
+        }
+    }
+
+public:
+    /**
+     * @param size Connections (metadata ingestor, tier mover, status
+     *             updates, camera set reads)
+     * @param acquireWait Default bound of acquire()
+     */
+    DatabasePool(const Config& config, size_t size, std::chrono::milliseconds acquireWait)
+        : defaultWait(acquireWait), wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), stopping(false),
+          checkouts(0), waitTimeouts(0), connectionsLost(0), reconnects(0) {
+        slots.resize(std::max<size_t>(size, 1));
+        for (auto& slot : slots) {
+            slot.db.reset(new Database(config, true));
+            slot.state = SlotState::DOWN;
+            slot.polling = PGRES_POLLING_WRITING;
+            slot.depth = 0;
+            slot.failures = 0;
+        }
+    }
+
+    ~DatabasePool() {
+        stop();
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+    }
+
+    DatabasePool(const DatabasePool&) = delete;
+    DatabasePool& operator=(const DatabasePool&) = delete;
+
+    /**
+     * Start connecting all connections; wait until one is up
+     * @return false if none came up within maxWait
+     */
+    bool start(std::chrono::milliseconds maxWait) {
+        if (!maintainer.joinable()) {
+            maintainer = std::thread(&DatabasePool::maintainLoop, this);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t index;
+        bool up = cv.wait_until(lock, std::chrono::steady_clock::now() + maxWait,
+                                [&] { return findIdle(index); });
+        Logger::info("Database pool: " + std::to_string(slots.size()) + " connections, " +
+                     std::to_string(defaultWait.count()) + " ms max wait");
+        return up;
+    }
+
+    /**
+     * Check a connection out, waiting at most maxWait for one to be free
+     * and connected; empty Lease = none (skip or retry later)
+     */
+    Lease acquire(std::chrono::milliseconds maxWait) {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::thread::id self = std::this_thread::get_id();
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i].state == SlotState::LEASED && slots[i].owner == self) {
+                slots[i].depth++;
+                return Lease(this, i);
+            }
+        }
+
+        size_t index = 0;
+        bool got = cv.wait_until(lock, std::chrono::steady_clock::now() + maxWait,
+                                 [&] { return stopping || findIdle(index); });
+        if (!got || stopping) {
+            waitTimeouts++;
+            return Lease();
+        }
+        Slot& slot = slots[index];
+        slot.state = SlotState::LEASED;
+        slot.owner = self;
+        slot.depth = 1;
+        checkouts++;
+        return Lease(this, index);
+    }
+
+    Lease acquire() {
+        return acquire(defaultWait);
+    }
+
+    /**
+     * Stop reconnecting and close the connections (after all users stopped)
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        cv.notify_all();
+        wake();
+        if (maintainer.joinable()) {
+            maintainer.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& slot : slots) {
+            if (slot.state != SlotState::LEASED) {
+                slot.db->disconnect();
+                slot.state = SlotState::DOWN;
+            }
+        }
+    }
+
+    size_t getUpCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t up = 0;
+        for (const auto& slot : slots) {
+            if (slot.state == SlotState::IDLE || slot.state == SlotState::LEASED) up++;
+        }
+        return up;
+    }
+
+    std::string getSummary() {
+        size_t up = 0, leased = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& slot : slots) {
+                if (slot.state == SlotState::IDLE || slot.state == SlotState::LEASED) up++;
+                if (slot.state == SlotState::LEASED) leased++;
+            }
+        }
+        return std::to_string(up) + "/" + std::to_string(slots.size()) + " up, " + std::to_string(leased) +
+               " in use, " + std::to_string(checkouts.load()) + " checkouts, " +
+               std::to_string(waitTimeouts.load()) + " wait timeouts, " + std::to_string(connectionsLost.load()) +
+               " lost, " + std::to_string(reconnects.load()) + " connects";
+    }
+};
+
+#endif // DATABASE_POOL_HPP
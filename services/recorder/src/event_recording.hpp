@@ -0,0 +1,303 @@
+#ifndef EVENT_RECORDING_HPP
+#define EVENT_RECORDING_HPP
+
+#include <string>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "libav_common.hpp"
+#include "logger.hpp"
+#include "segment_writer.hpp"
+
+/**
+ * PreRollBuffer - Last N seconds of compressed packets, whole GOPs only
+ *
+ * Holds packet references (no copies) grouped by GOP, so the buffer
+ * always starts on a video keyframe and can be written into a segment
+ * as-is. Old GOPs are dropped once the next GOP alone still covers the
+ * pre-roll, or when the byte budget is exceeded.
+ */
+class PreRollBuffer {
+private:
+    struct Entry {
+        AVPacket* packet;
+        int streamIndex;
+    };
+
+    struct Gop {
+        std::chrono::steady_clock::time_point startedAt;
+        std::chrono::system_clock::time_point wallTime;
+        std::deque<Entry> packets;
+        size_t bytes = 0;
+    };
+
+    std::chrono::milliseconds preRoll;
+    size_t maxBytes;
+    std::deque<Gop> gops;
+    size_t totalBytes;
+    uint64_t gopsEvicted;
+
+    void dropOldestGop() {
+        Gop& oldest = gops.front();
+        for (auto& entry : oldest.packets) {
+            av_packet_free(&entry.packet);
+        }
+        totalBytes -= oldest.bytes;
+        gops.pop_front();
+        gopsEvicted++;
+    }
+
+public:
+    PreRollBuffer(int preRollSeconds, size_t maxBufferBytes)
+        : preRoll(std::chrono::seconds(std::max(preRollSeconds, 0))), maxBytes(maxBufferBytes),
+          totalBytes(0), gopsEvicted(0) {}
+
+    ~PreRollBuffer() {
+        clear();
+    }
+
+    PreRollBuffer(const PreRollBuffer&) = delete;
+    PreRollBuffer& operator=(const PreRollBuffer&) = delete;
+
+    /**
+     * Take the packet reference (pkt is left blank)
+     *
+     * Packets before the first video keyframe are dropped.
+     */
+    void push(AVPacket* pkt, int streamIndex, bool isVideo) {
+        auto now = std::chrono::steady_clock::now();
+        if (isVideo && (pkt->flags & AV_PKT_FLAG_KEY)) {
+            Gop gop;
+            gop.startedAt = now;
+            gop.wallTime = std::chrono::system_clock::now();
+            gops.push_back(std::move(gop));
+        }
+        if (gops.empty()) {
+            av_packet_unref(pkt);
+            return;
+        }
+
+        Entry entry;
+        entry.packet = av_packet_alloc();
+        entry.streamIndex = streamIndex;
+        av_packet_move_ref(entry.packet, pkt);
+        gops.back().bytes += entry.packet->size;
+        totalBytes += entry.packet->size;
+        gops.back().packets.push_back(entry);
+
+        // Keep the newest GOPs that cover the pre-roll, within budget
+        while (gops.size() >= 2 && (gops[1].startedAt <= now - preRoll || totalBytes > maxBytes)) {
+            dropOldestGop();
+        }
+    }
+
+    /**
+     * Move the oldest buffered packet out (caller owns the reference)
+     *
+     * @return false when the buffer is empty
+     */
+    bool pop(AVPacket* out, int& streamIndex) {
+        while (!gops.empty() && gops.front().packets.empty()) {
+            gops.pop_front();
+        }
+        if (gops.empty()) return false;
+
+        Gop& gop = gops.front();
+        Entry entry = gop.packets.front();
+        gop.packets.pop_front();
+        gop.bytes -= entry.packet->size;
+        totalBytes -= entry.packet->size;
+
+        av_packet_move_ref(out, entry.packet);
+        av_packet_free(&entry.packet);
+        streamIndex = entry.streamIndex;
+        return true;
+    }
+
+    void clear() {
+        while (!gops.empty()) {
+            dropOldestGop();
+        }
+    }
+
+    /**
+     * Wall-clock time of the first buffered keyframe
+     */
+    std::chrono::system_clock::time_point getStartTime() const {
+        return gops.empty() ? std::chrono::system_clock::now() : gops.front().wallTime;
+    }
+
+    double getBufferedSeconds() const {
+        if (gops.empty()) return 0;
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - gops.front().startedAt).count();
+    }
+
+    size_t getBytes() const { return totalBytes; }
+    uint64_t getGopsEvicted() const { return gopsEvicted; }
+};
+
+/**
+ * PacketActivityDetector - Motion trigger from compressed packet sizes
+ *
+ * In a static scene inter frames are tiny; motion makes them grow. The
+ * detector keeps a slow moving average of non-key video packet sizes
+ * and fires when several consecutive packets are well above it. While
+ * above, the average still follows at a much slower rate, so a lasting
+ * shift in scene or bitrate stops triggering after a while. No decode,
+ * so it works in passthrough mode at no extra cost.
+ */
+class PacketActivityDetector {
+private:
+    static constexpr double BASELINE_WEIGHT = 0.02;    // ~50 packet average
+    static constexpr double ACTIVE_BASELINE_WEIGHT = 0.001;   // ~1000 packets (40 s at 25 fps)
+    static constexpr double TRIGGER_RATIO = 2.5;
+    static constexpr int TRIGGER_PACKETS = 3;
+    static constexpr int WARMUP_PACKETS = 50;
+
+    double baseline;
+    int aboveCount;
+    int seen;
+
+public:
+    PacketActivityDetector() : baseline(0), aboveCount(0), seen(0) {}
+
+    /**
+     * @return true when activity is detected
+     */
+    bool onVideoPacket(const AVPacket* pkt) {
+        if (pkt->flags & AV_PKT_FLAG_KEY) {
+            return false;   // Keyframe size says nothing about motion
+        }
+
+        double size = pkt->size;
+        if (seen < WARMUP_PACKETS) {
+            baseline = (baseline * seen + size) / (seen + 1);
+            seen++;
+            return false;
+        }
+
+        bool above = size > baseline * TRIGGER_RATIO;
+        aboveCount = above ? aboveCount + 1 : 0;
+        // Quiet frames teach fast; active ones slowly, so a lasting change
+        // (IR switch, rain, bitrate) is absorbed instead of recording forever
+        baseline += (size - baseline) * (above ? ACTIVE_BASELINE_WEIGHT : BASELINE_WEIGHT);
+        return aboveCount >= TRIGGER_PACKETS;
+    }
+};
+
+/**
+ * EventRecordingGate - Event-triggered recording in front of a SegmentWriter
+ *
+ * Idle: packets go into the PreRollBuffer only, nothing touches disk.
+ * trigger() (any thread) opens a segment that starts with the buffered
+ * pre-roll and keeps recording until post-roll seconds after the last
+ * trigger; then the segment is closed and buffering resumes. Long
+ * events rotate segments as usual.
+ */
+class EventRecordingGate {
+public:
+    struct Settings {
+        int preRollSeconds = 10;
+        int postRollSeconds = 30;
+        size_t maxPreRollBytes = 64 * 1024 * 1024;
+        bool motionDetection = false;
+    };
+
+private:
+    std::string cameraName;
+    Settings settings;
+    PreRollBuffer preRoll;
+    PacketActivityDetector detector;
+    std::atomic<int64_t> recordUntilMs;   // steady clock, 0 = idle
+    bool recording;
+    AVPacket* flushPacket;
+    uint64_t eventCount;
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    EventRecordingGate(const std::string& name, const Settings& s)
+        : cameraName(name), settings(s), preRoll(s.preRollSeconds, s.maxPreRollBytes),
+          recordUntilMs(0), recording(false), flushPacket(av_packet_alloc()), eventCount(0) {}
+
+    ~EventRecordingGate() {
+        av_packet_free(&flushPacket);
+    }
+
+    EventRecordingGate(const EventRecordingGate&) = delete;
+    EventRecordingGate& operator=(const EventRecordingGate&) = delete;
+
+    /**
+     * Start or extend an event (thread-safe)
+     */
+    void trigger() {
+        int64_t until = nowMs() + settings.postRollSeconds * 1000LL;
+        int64_t current = recordUntilMs.load();
+        while (current < until && !recordUntilMs.compare_exchange_weak(current, until)) {}
+    }
+
+    /**
+     * Writer thread: route one packet (consumes the reference)
+     *
+     * @return false if the segment writer failed
+     */
+    bool write(SegmentWriter& writer, AVPacket* pkt, int streamIndex, bool isVideo) {
+        if (settings.motionDetection && isVideo && detector.onVideoPacket(pkt)) {
+            if (!recording) {
+                Logger::info("EventRecording: motion detected on " + cameraName);
+            }
+            trigger();
+        }
+
+        bool active = nowMs() < recordUntilMs.load();
+        if (!recording && active) {
+            recording = true;
+            eventCount++;
+            Logger::info("EventRecording: event started for " + cameraName + " (" +
+                         std::to_string((int)preRoll.getBufferedSeconds()) + "s pre-roll, " +
+                         std::to_string(preRoll.getBytes() / 1024) + " KB)");
+
+            writer.setNextSegmentStartTime(preRoll.getStartTime());
+            int bufferedIndex;
+            while (preRoll.pop(flushPacket, bufferedIndex)) {
+                if (!writer.writePacket(flushPacket, bufferedIndex)) {
+                    preRoll.clear();
+                    av_packet_unref(pkt);
+                    return false;
+                }
+            }
+        } else if (recording && !active) {
+            recording = false;
+            writer.close();
+            Logger::info("EventRecording: event ended for " + cameraName + " (post-roll " +
+                         std::to_string(settings.postRollSeconds) + "s elapsed)");
+        }
+
+        if (recording) {
+            return writer.writePacket(pkt, streamIndex);
+        }
+        preRoll.push(pkt, streamIndex, isVideo);
+        return true;
+    }
+
+    /**
+     * Drop the pre-roll after a pipeline restart (writer thread stopped)
+     *
+     * Pending triggers survive, so an event that fires during a
+     * reconnect still records once packets flow again.
+     */
+    void reset() {
+        preRoll.clear();
+        detector = PacketActivityDetector();
+        recording = false;
+    }
+
+    bool isRecording() const { return recording; }
+    uint64_t getEventCount() const { return eventCount; }
+};
+
+#endif // EVENT_RECORDING_HPP
@@ -0,0 +1,277 @@
+#ifndef EVICTION_ENGINE_HPP
+#define EVICTION_ENGINE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+#include <cstring>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+#include "io_uring_queue.hpp"
+#include "segment_index.hpp"
+#include "logger.hpp"
+
+/**
+ * EvictionEngine - Background unlink of segments chosen by StorageManager
+ *
+ * StorageManager picks what to delete from tracked sizes (SegmentIndex)
+ * in one pass and hands the list over; this thread does the I/O, so
+ * cleanup never runs on the control loop. Unlinks go through io_uring
+ * (IORING_OP_UNLINKAT, up to QUEUE_DEPTH in flight) where the kernel
+ * allows it, plain unlink() otherwise.
+ *
+ * Work is done in batches of BATCH_FILES; after each batch the
+ * stop condition (actual free space, one statvfs) is checked. When it
+ * says enough, the rest of the job is handed back to the index.
+ * Sidecars (chunk offset index, keyframe index) go with their file,
+ * by plain unlink.
+ */
+class EvictionEngine {
+public:
+    using StopCondition = std::function<bool()>;
+    using ReturnSegments = std::function<void(std::vector<SegmentIndex::Segment>&&)>;
+    using SegmentFinished = std::function<void(const SegmentIndex::Segment&, bool deleted)>;
+
+private:
+    static constexpr unsigned QUEUE_DEPTH = 64;
+    static constexpr size_t BATCH_FILES = 256;
+
+    struct Job {
+        std::vector<SegmentIndex::Segment> segments;
+        std::string reason;
+        StopCondition done;        // Checked at batch boundaries, may be empty
+    };
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable idleCv;
+    std::deque<Job> jobs;
+    bool stopping;
+    bool busy;
+    ReturnSegments returnSegments;
+    SegmentFinished segmentFinished;
+
+    IoUringQueue ring;
+    bool useRing;
+
+    std::atomic<uint64_t> pendingBytes;     // Queued, not unlinked yet
+    std::atomic<uint64_t> freedBytes;
+    std::atomic<uint64_t> filesDeleted;
+    std::atomic<uint64_t> filesFailed;
+
+    /**
+     * Unlink segments[begin, end); returns bytes freed
+     */
+    uint64_t unlinkRange(const std::vector<SegmentIndex::Segment>& segments, size_t begin, size_t end) {
+        uint64_t freed = 0;
+        if (!useRing) {
+            for (size_t i = begin; i < end; i++) {
+                freed += finishUnlink(segments[i], ::unlink(segments[i].path.c_str()) == 0 ? 0 : -errno);
+            }
+            return freed;
+        }
+
+        // Rounds of up to QUEUE_DEPTH: queue, submit, reap all of them
+        size_t next = begin;
+        while (next < end) {
+            size_t roundStart = next;
+            while (next < end) {
+                io_uring_sqe* sqe = ring.getSqe();
+                if (!sqe) break;
+                sqe->opcode = IORING_OP_UNLINKAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = (uint64_t)(uintptr_t)segments[next].path.c_str();
+                sqe->user_data = next;
+                next++;
+            }
+            size_t queued = next - roundStart;
+
+            int ret = ring.submit((unsigned)queued);
+            if (ret < 0) {
+                // Nothing of this round was accepted: finish synchronously
+                Logger::warn("EvictionEngine: io_uring submit failed (" + std::string(strerror(-ret)) +
+                             "), using unlink()");
+                useRing = false;
+                return freed + unlinkRange(segments, roundStart, end);
+            }
+
+            size_t reaped = 0;
+            io_uring_cqe cqe;
+            while (reaped < queued) {
+                if (!ring.popCqe(cqe)) {
+                    ring.submit(1);   // Wait for the next completion
+                    continue;
+                }
+                freed += finishUnlink(segments[cqe.user_data], cqe.res);
+                reaped++;
+            }
+        }
+        return freed;
+    }
+
+    uint64_t finishUnlink(const SegmentIndex::Segment& segment, int result) {
+        pendingBytes -= segment.size;
+        bool deleted = result == 0 || result == -ENOENT;
+        if (segmentFinished) {
+            segmentFinished(segment, deleted);
+        }
+        if (deleted) {
+            for (const auto& sidecar : SegmentIndex::sidecarsOf(segment.path)) {
+                ::unlink(sidecar.c_str());
+            }
+            filesDeleted++;
+            freedBytes += segment.size;
+            return segment.size;
+        }
+        filesFailed++;
+        Logger::error("Failed to delete " + segment.path + ": " + strerror(-result));
+        return 0;
+    }
+
+    void runJob(Job& job) {
+        auto started = std::chrono::steady_clock::now();
+        uint64_t freed = 0;
+        size_t processed = 0;
+        bool stoppedEarly = false;
+
+        while (processed < job.segments.size()) {
+            if (job.done && job.done()) {
+                stoppedEarly = true;
+                break;
+            }
+            size_t end = std::min(processed + BATCH_FILES, job.segments.size());
+            freed += unlinkRange(job.segments, processed, end);
+            processed = end;
+        }
+
+        if (stoppedEarly) {
+            std::vector<SegmentIndex::Segment> rest(std::make_move_iterator(job.segments.begin() + processed),
+                                                    std::make_move_iterator(job.segments.end()));
+            for (const auto& segment : rest) {
+                pendingBytes -= segment.size;
+                if (segmentFinished) {
+                    segmentFinished(segment, false);
+                }
+            }
+            if (returnSegments) {
+                returnSegments(std::move(rest));
+            }
+        }
+
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        Logger::info("Eviction (" + job.reason + "): deleted " + std::to_string(processed) + " segments, " +
+                     std::to_string(freed / (1024 * 1024)) + " MB in " + std::to_string(elapsedMs) + " ms" +
+                     (stoppedEarly ? ", target reached early" : ""));
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;   // Stopping and drained
+
+            Job job = std::move(jobs.front());
+            jobs.pop_front();
+            busy = true;
+            lock.unlock();
+
+            runJob(job);
+
+            lock.lock();
+            busy = false;
+            if (jobs.empty()) {
+                idleCv.notify_all();
+            }
+        }
+    }
+
+public:
+    EvictionEngine()
+        : stopping(false), busy(false), useRing(false), pendingBytes(0), freedBytes(0),
+          filesDeleted(0), filesFailed(0) {}
+
+    ~EvictionEngine() {
+        stop();
+    }
+
+    EvictionEngine(const EvictionEngine&) = delete;
+    EvictionEngine& operator=(const EvictionEngine&) = delete;
+
+    /**
+     * @param onReturn Receives segments of a job stopped early (back to the index)
+     * @param onFinished Called for every segment leaving the queue (per-volume accounting)
+     */
+    void start(ReturnSegments onReturn, SegmentFinished onFinished = SegmentFinished()) {
+        if (worker.joinable()) return;
+        returnSegments = std::move(onReturn);
+        segmentFinished = std::move(onFinished);
+
+        useRing = ring.init(QUEUE_DEPTH) && ring.supports(IORING_OP_UNLINKAT);
+        Logger::info(std::string("Eviction engine: ") + (useRing ? "io_uring unlinkat" : "unlink()") +
+                     ", batches of " + std::to_string(BATCH_FILES));
+
+        stopping = false;
+        worker = std::thread(&EvictionEngine::workerLoop, this);
+    }
+
+    /**
+     * Finish queued jobs and stop the thread
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!worker.joinable()) return;
+            stopping = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    /**
+     * Queue segments for deletion (returns immediately)
+     *
+     * @param done Stop condition checked before every batch
+     */
+    void submit(std::vector<SegmentIndex::Segment>&& segments, const std::string& reason,
+                StopCondition done = StopCondition()) {
+        if (segments.empty()) return;
+        uint64_t bytes = 0;
+        for (const auto& segment : segments) {
+            bytes += segment.size;
+        }
+        pendingBytes += bytes;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back({std::move(segments), reason, std::move(done)});
+        }
+        cv.notify_one();
+    }
+
+    /**
+     * Block until every queued job is done (startup path only)
+     */
+    bool waitIdle(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return idleCv.wait_for(lock, timeout, [this] { return jobs.empty() && !busy; });
+    }
+
+    uint64_t getPendingBytes() const { return pendingBytes; }
+    uint64_t getFreedBytes() const { return freedBytes; }
+    uint64_t getFilesDeleted() const { return filesDeleted; }
+    uint64_t getFilesFailed() const { return filesFailed; }
+    bool isUsingIoUring() const { return useRing; }
+};
+
+#endif // EVICTION_ENGINE_HPP
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <filesystem>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <signal.h>
@@ -11,6 +12,8 @@
 #include "encoder_detector.hpp"
 #include "stream_analyzer.hpp"
 #include "gpu_selector.hpp"
+#include "recording_pipeline.hpp"
+#include "process_supervisor.hpp"
 
 /**
  * FFmpegMultiOutput - Single FFmpeg process with multiple outputs
@@ -34,9 +37,17 @@
  * - Hardware decode (NVDEC) for NVIDIA cameras
  * - 12 cameras capacity (6 NVENC + 6 VAAPI)
  * - Optimal hardware utilization
+ *
+ * Fallback backend: LibavPipeline runs the same pipeline in-process.
+ * Select this one with RECORDER_PIPELINE=ffmpeg.
+ *
+ * Exit detection: the child's pidfd is the pipeline event fd, so the
+ * camera reactor sees a crash as soon as it happens (no 5 s poll).
  */
-class FFmpegMultiOutput {
+class FFmpegMultiOutput : public RecordingPipeline {
 private:
+    static constexpr int STOP_TIMEOUT_SECONDS = 5;
+
     std::string cameraName;
     std::string cameraId;
     std::string rtspUrl;
@@ -47,6 +58,7 @@ private:
     EncoderType encoderType;
     GPUType gpuType;  // PHASE 5: GPU type (NVENC or VAAPI)
     pid_t processPid;
+    int pidFd;  // Readable when the child exits, -1 = poll waitpid
     bool isRunning;
     bool enableLiveStreaming;  // PHASE 3: Enable live streaming output
 
@@ -54,7 +66,29 @@ private:
     StreamAnalyzer::StreamInfo streamInfo;
     bool useHardwareAcceleration;  // Use CUDA for yuvj420p
     bool useHardwareDecode;  // PHASE 5: Use NVDEC for decode
+    RecordingMode recordingMode;
+    bool usePassthrough;  // Recording output is `-c:v copy`
+
+    std::filesystem::file_time_type startedAt;
+    mutable bool segmentSeen;  // ffmpeg created a segment since start()
+    int fragmentSeconds;       // Fragmented MP4 segments, 0 = classic MP4
     
+    void closePidFd() {
+        if (pidFd >= 0) {
+            close(pidFd);
+            pidFd = -1;
+        }
+    }
+
+    /**
+     * mp4 muxer options for fragmented segments (see SegmentWriter);
+     * the CLI muxer cuts at every keyframe and at least every fragmentSeconds
+     */
+    std::string buildFragmentOptions() const {
+        return "movflags=+frag_keyframe+empty_moov+default_base_moof:frag_duration=" +
+               std::to_string((int64_t)fragmentSeconds * 1000000);
+    }
+
     /**
      * Build FFmpeg command based on GPU type (PHASE 5)
      */
@@ -103,23 +137,29 @@ private:
         args.push_back("-map");
         args.push_back("0:a?");
 
-        // PHASE 5/4: Apply filter if needed
-        if (useHardwareAcceleration && streamInfo.isJpegColorRange) {
-            args.push_back("-vf");
-            args.push_back("scale_cuda=format=yuv420p");
-        }
+        if (usePassthrough) {
+            // Camera already sends H.264/H.265: remux without re-encoding
+            args.push_back("-c:v");
+            args.push_back("copy");
+        } else {
+            // PHASE 5/4: Apply filter if needed
+            if (useHardwareAcceleration && streamInfo.isJpegColorRange) {
+                args.push_back("-vf");
+                args.push_back("scale_cuda=format=yuv420p");
+            }
 
-        args.push_back("-c:v");
-        args.push_back("hevc_nvenc");
-        args.push_back("-preset");
-        args.push_back("p4");
+            args.push_back("-c:v");
+            args.push_back("hevc_nvenc");
+            args.push_back("-preset");
+            args.push_back("p4");
 
-        int bitrate = StreamAnalyzer::getRecommendedBitrate(
-            streamInfo.width > 0 ? streamInfo.width : 1920,
-            streamInfo.height > 0 ? streamInfo.height : 1080
-        );
-        args.push_back("-b:v");
-        args.push_back(std::to_string(bitrate) + "M");
+            int bitrate = StreamAnalyzer::getRecommendedBitrate(
+                streamInfo.width > 0 ? streamInfo.width : 1920,
+                streamInfo.height > 0 ? streamInfo.height : 1080
+            );
+            args.push_back("-b:v");
+            args.push_back(std::to_string(bitrate) + "M");
+        }
 
         args.push_back("-c:a");
         args.push_back("aac");
@@ -133,6 +173,10 @@ private:
         args.push_back("180");
         args.push_back("-segment_format");
         args.push_back("mp4");
+        if (fragmentSeconds > 0) {
+            args.push_back("-segment_format_options");
+            args.push_back(buildFragmentOptions());
+        }
         args.push_back("-strftime");
         args.push_back("1");
         args.push_back("-reset_timestamps");
@@ -215,19 +259,25 @@ private:
         args.push_back("-map");
         args.push_back("0:a?");
 
-        // VAAPI filter chain
-        args.push_back("-vf");
-        args.push_back("format=nv12,hwupload");
+        if (usePassthrough) {
+            // Camera already sends H.264/H.265: remux without re-encoding
+            args.push_back("-c:v");
+            args.push_back("copy");
+        } else {
+            // VAAPI filter chain
+            args.push_back("-vf");
+            args.push_back("format=nv12,hwupload");
 
-        args.push_back("-c:v");
-        args.push_back("h264_vaapi");
+            args.push_back("-c:v");
+            args.push_back("h264_vaapi");
 
-        int bitrate = StreamAnalyzer::getRecommendedBitrate(
-            streamInfo.width > 0 ? streamInfo.width : 1920,
-            streamInfo.height > 0 ? streamInfo.height : 1080
-        );
-        args.push_back("-b:v");
-        args.push_back(std::to_string(bitrate) + "M");
+            int bitrate = StreamAnalyzer::getRecommendedBitrate(
+                streamInfo.width > 0 ? streamInfo.width : 1920,
+                streamInfo.height > 0 ? streamInfo.height : 1080
+            );
+            args.push_back("-b:v");
+            args.push_back(std::to_string(bitrate) + "M");
+        }
 
         args.push_back("-c:a");
         args.push_back("aac");
@@ -241,6 +291,10 @@ private:
         args.push_back("180");
         args.push_back("-segment_format");
         args.push_back("mp4");
+        if (fragmentSeconds > 0) {
+            args.push_back("-segment_format_options");
+            args.push_back(buildFragmentOptions());
+        }
         args.push_back("-strftime");
         args.push_back("1");
         args.push_back("-reset_timestamps");
@@ -300,10 +354,13 @@ public:
     FFmpegMultiOutput(const std::string& name, const std::string& id,
                       const std::string& url, const std::string& recPath,
                       bool enableLive = true, bool enableHwAccel = true,
-                      GPUType preferredGPU = GPUType::AUTO)
+                      GPUType preferredGPU = GPUType::AUTO,
+                      RecordingMode mode = RecordingMode::AUTO,
+                      const StreamAnalyzer::StreamInfo* probedInfo = nullptr)
         : cameraName(name), cameraId(id), rtspUrl(url), recordingPath(recPath),
-          processPid(-1), isRunning(false), enableLiveStreaming(enableLive),
-          useHardwareAcceleration(enableHwAccel), useHardwareDecode(true) {
+          processPid(-1), pidFd(-1), isRunning(false), enableLiveStreaming(enableLive),
+          useHardwareAcceleration(enableHwAccel), useHardwareDecode(true),
+          recordingMode(mode), usePassthrough(false), segmentSeen(false), fragmentSeconds(2) {
 
         // PHASE 5: GPU selection
         Logger::info("FFmpegMultiOutput created for " + cameraName);
@@ -317,9 +374,13 @@ public:
         Logger::info("  GPU: " + GPUSelector::getGPUTypeName(gpuType));
         Logger::info("  GPU Status: " + GPUSelector::getStatus());
 
-        // PHASE 4: Analyze stream properties
-        Logger::info("  Analyzing stream properties...");
-        streamInfo = StreamAnalyzer::analyze(rtspUrl, 10);
+        // PHASE 4: Analyze stream properties (StreamProber result when given)
+        if (probedInfo) {
+            streamInfo = *probedInfo;
+        } else {
+            Logger::info("  Analyzing stream properties...");
+            streamInfo = StreamAnalyzer::analyze(rtspUrl, 10);
+        }
 
         if (!streamInfo.isValid) {
             Logger::warn("  Failed to analyze stream, using defaults");
@@ -330,6 +391,8 @@ public:
             streamInfo.isJpegColorRange = false;
         }
 
+        usePassthrough = resolvePassthrough(recordingMode, streamInfo.codec);
+
         // Set encoder type based on GPU
         if (gpuType == GPUType::NVIDIA_NVENC) {
             encoderType = ENCODER_NVENC;
@@ -352,8 +415,16 @@ public:
         int recBitrate = StreamAnalyzer::getRecommendedBitrate(streamInfo.width, streamInfo.height);
         int liveBitrate = StreamAnalyzer::getRecommendedLiveBitrate(streamInfo.width, streamInfo.height);
 
-        if (gpuType == GPUType::NVIDIA_NVENC) {
+        if (usePassthrough) {
+            Logger::info("  Recording: passthrough (" + streamInfo.codec + " copy, mode " +
+                        getRecordingModeName(recordingMode) + ")");
+        } else if (gpuType == GPUType::NVIDIA_NVENC) {
             Logger::info("  Recording: H.265 NVENC @ " + std::to_string(recBitrate) + "Mbps");
+        } else {
+            Logger::info("  Recording: H.264 VAAPI @ " + std::to_string(recBitrate) + "Mbps");
+        }
+
+        if (gpuType == GPUType::NVIDIA_NVENC) {
             if (enableLiveStreaming) {
                 Logger::info("  Live High: H.264 NVENC @ " + std::to_string(liveBitrate) + "Mbps");
             }
@@ -369,7 +440,6 @@ public:
                 Logger::info("  Expected CPU: ~12-15% per camera (with NVDEC)");
             }
         } else {
-            Logger::info("  Recording: H.264 VAAPI @ " + std::to_string(recBitrate) + "Mbps");
             if (enableLiveStreaming) {
                 Logger::info("  Live High: H.264 VAAPI @ " + std::to_string(liveBitrate) + "Mbps");
             }
@@ -377,8 +447,9 @@ public:
         }
     }
 
-    ~FFmpegMultiOutput() {
+    ~FFmpegMultiOutput() override {
         stop();
+        closePidFd();
         // PHASE 5: Release GPU allocation
         GPUSelector::releaseGPU(gpuType);
     }
@@ -386,7 +457,7 @@ public:
     /**
      * Start multi-output FFmpeg process
      */
-    bool start() {
+    bool start() override {
         if (isRunning) {
             Logger::warn("FFmpegMultiOutput already running for " + cameraName);
             return false;
@@ -394,6 +465,8 @@ public:
         
         // Build command
         std::vector<std::string> args = buildFFmpegCommand();
+        startedAt = std::filesystem::file_time_type::clock::now();
+        segmentSeen = false;
         
         // Fork process
         processPid = fork();
@@ -425,6 +498,8 @@ public:
         
         // Parent process
         isRunning = true;
+        closePidFd();
+        pidFd = ProcessSupervisor::openPidFd(processPid);
         Logger::info("Started FFmpegMultiOutput for " + cameraName + " (PID: " + std::to_string(processPid) + ")");
         Logger::info("  PHASE 3: Single process with dual outputs");
         Logger::info("  Output 1 (Recording): " + recordingPath);
@@ -437,7 +512,7 @@ public:
     /**
      * Check if process is still running
      */
-    bool checkStatus() {
+    bool checkStatus() override {
         if (!isRunning || processPid == -1) {
             return false;
         }
@@ -449,11 +524,7 @@ public:
             return true;  // Still running
         } else if (result == processPid) {
             // Process exited
-            if (WIFEXITED(status)) {
-                Logger::warn("FFmpegMultiOutput exited for " + cameraName + " - code " + std::to_string(WEXITSTATUS(status)));
-            } else if (WIFSIGNALED(status)) {
-                Logger::warn("FFmpegMultiOutput killed for " + cameraName + " - signal " + std::to_string(WTERMSIG(status)));
-            }
+            Logger::warn("FFmpegMultiOutput exited for " + cameraName + " - " + ProcessSupervisor::describeExit(status));
             isRunning = false;
             processPid = -1;
             return false;
@@ -463,40 +534,89 @@ public:
     }
     
     /**
-     * Stop process gracefully
+     * Stop process gracefully (SIGTERM, SIGKILL after 5 seconds)
+     */
+    void stop() override {
+        requestStop();
+        if (!waitStopped(std::chrono::steady_clock::now() + std::chrono::seconds(STOP_TIMEOUT_SECONDS))) {
+            forceStop();
+        }
+    }
+
+    /**
+     * Send SIGTERM without waiting
      */
-    void stop() {
+    void requestStop() override {
         if (!isRunning || processPid == -1) {
             return;
         }
-        
         Logger::info("Stopping FFmpegMultiOutput for " + cameraName + " (PID: " + std::to_string(processPid) + ")");
-        
-        // Send SIGTERM for graceful shutdown
         kill(processPid, SIGTERM);
-        
-        // Wait up to 5 seconds
-        for (int i = 0; i < 50; i++) {
-            if (!checkStatus()) {
-                Logger::info("FFmpegMultiOutput stopped gracefully for " + cameraName);
-                return;
-            }
-            usleep(100000);  // 100ms
+    }
+
+    /**
+     * Wait for the child on its pidfd until the deadline
+     */
+    bool waitStopped(std::chrono::steady_clock::time_point deadline) override {
+        if (!isRunning || processPid == -1) {
+            return true;
+        }
+
+        int status = 0;
+        if (!ProcessSupervisor::waitForExit(processPid, pidFd, deadline, &status)) {
+            return false;
+        }
+        Logger::info("FFmpegMultiOutput stopped gracefully for " + cameraName + " (" +
+                     ProcessSupervisor::describeExit(status) + ")");
+        isRunning = false;
+        processPid = -1;
+        return true;
+    }
+
+    /**
+     * SIGKILL and reap
+     */
+    void forceStop() override {
+        if (!isRunning || processPid == -1) {
+            return;
         }
-        
-        // Force kill if still running
         Logger::warn("FFmpegMultiOutput not responding, force killing for " + cameraName);
         kill(processPid, SIGKILL);
         waitpid(processPid, nullptr, 0);
-        
+
         isRunning = false;
         processPid = -1;
     }
     
-    bool getIsRunning() const { return isRunning; }
+    /**
+     * The child writes segments itself: look for an .mp4 newer than start()
+     * (directory scan, only until the first one shows up)
+     */
+    bool hasRecordedSegment() const override {
+        if (segmentSeen || !isRunning) {
+            return segmentSeen;
+        }
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(recordingPath, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() != ".mp4") continue;
+            auto modified = std::filesystem::last_write_time(it->path(), ec);
+            if (!ec && modified >= startedAt) {
+                segmentSeen = true;
+                break;
+            }
+            ec.clear();
+        }
+        return segmentSeen;
+    }
+
+    bool getIsRunning() const override { return isRunning; }
     pid_t getPid() const { return processPid; }
-    EncoderType getEncoderType() const { return encoderType; }
-    std::string getEncoderName() const { return EncoderDetector::getEncoderName(encoderType); }
+    int getEventFd() const override { return pidFd; }
+    StreamAnalyzer::StreamInfo getStreamInfo() const override { return streamInfo; }
+    EncoderType getEncoderType() const override { return encoderType; }
+    std::string getEncoderName() const override { return EncoderDetector::getEncoderName(encoderType); }
+    std::string getBackendName() const override { return "ffmpeg CLI"; }
+    void setFragmentSeconds(int seconds) override { fragmentSeconds = std::max(seconds, 0); }
 };
 
 #endif // FFMPEG_MULTI_OUTPUT_HPP
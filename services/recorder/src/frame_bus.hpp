@@ -0,0 +1,199 @@
+#ifndef FRAME_BUS_HPP
+#define FRAME_BUS_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include "libav_common.hpp"
+
+/**
+ * FrameBus - Decode-once fan-out of video frames inside one camera pipeline
+ *
+ * The pipeline decodes (and converts/uploads) each frame once and publishes
+ * it here. Every consumer - recording encoder, live encoder, snapshots,
+ * analytics - gets its own bounded queue of ref-counted AVFrames: publishing
+ * only takes a new reference, frame data (system or GPU memory) is shared.
+ *
+ * A full queue never blocks the publisher; the consumer's drop policy
+ * decides which frame is discarded.
+ */
+class FrameBus {
+public:
+    enum class DropPolicy {
+        DROP_OLDEST,   // Keep the freshest frames (live, snapshots)
+        DROP_NEWEST    // Keep what is already queued (recording)
+    };
+
+    class Consumer {
+        friend class FrameBus;
+
+    private:
+        std::string name;
+        size_t capacity;
+        DropPolicy policy;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<AVFrame*> queue;
+        bool closed;
+
+        std::atomic<uint64_t> framesDelivered;
+        std::atomic<uint64_t> framesDropped;
+
+        void push(const AVFrame* source) {
+            AVFrame* ref = av_frame_alloc();
+            if (!ref || av_frame_ref(ref, source) < 0) {
+                av_frame_free(&ref);
+                framesDropped++;
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) {
+                av_frame_free(&ref);
+                return;
+            }
+            if (queue.size() >= capacity) {
+                framesDropped++;
+                if (policy == DropPolicy::DROP_NEWEST) {
+                    av_frame_free(&ref);
+                    return;
+                }
+                AVFrame* oldest = queue.front();
+                queue.pop_front();
+                av_frame_free(&oldest);
+            }
+            queue.push_back(ref);
+            framesDelivered++;
+            cv.notify_one();
+        }
+
+    public:
+        Consumer(const std::string& consumerName, size_t maxFrames, DropPolicy dropPolicy)
+            : name(consumerName), capacity(std::max<size_t>(maxFrames, 1)), policy(dropPolicy),
+              closed(false), framesDelivered(0), framesDropped(0) {}
+
+        ~Consumer() {
+            for (AVFrame* frame : queue) {
+                av_frame_free(&frame);
+            }
+        }
+
+        Consumer(const Consumer&) = delete;
+        Consumer& operator=(const Consumer&) = delete;
+
+        /**
+         * Wait for the next frame
+         *
+         * @return Frame owned by the caller (av_frame_free), nullptr once closed and drained
+         */
+        AVFrame* pop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !queue.empty() || closed; });
+            if (queue.empty()) {
+                return nullptr;
+            }
+            AVFrame* frame = queue.front();
+            queue.pop_front();
+            return frame;
+        }
+
+        /**
+         * Stop accepting frames; pop() returns what is queued, then nullptr
+         */
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            cv.notify_all();
+        }
+
+        size_t getQueueDepth() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return queue.size();
+        }
+
+        std::string getName() const { return name; }
+        size_t getCapacity() const { return capacity; }
+        uint64_t getFramesDelivered() const { return framesDelivered; }
+        uint64_t getFramesDropped() const { return framesDropped; }
+    };
+
+private:
+    std::mutex consumersMutex;
+    std::vector<std::shared_ptr<Consumer>> consumers;
+    std::atomic<uint64_t> framesPublished;
+
+public:
+    FrameBus() : framesPublished(0) {}
+
+    FrameBus(const FrameBus&) = delete;
+    FrameBus& operator=(const FrameBus&) = delete;
+
+    /**
+     * Add a consumer with its own bounded queue
+     */
+    std::shared_ptr<Consumer> subscribe(const std::string& name, size_t maxFrames, DropPolicy policy) {
+        auto consumer = std::make_shared<Consumer>(name, maxFrames, policy);
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        consumers.push_back(consumer);
+        return consumer;
+    }
+
+    /**
+     * Remove a consumer (its queue is closed)
+     */
+    void unsubscribe(const std::shared_ptr<Consumer>& consumer) {
+        if (!consumer) return;
+        consumer->close();
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        consumers.erase(std::remove(consumers.begin(), consumers.end(), consumer), consumers.end());
+    }
+
+    /**
+     * Hand a reference of the frame to every consumer (frame is not consumed)
+     */
+    void publish(const AVFrame* frame) {
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        for (auto& consumer : consumers) {
+            consumer->push(frame);
+        }
+        framesPublished++;
+    }
+
+    /**
+     * Close every consumer at end of stream
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        for (auto& consumer : consumers) {
+            consumer->close();
+        }
+        consumers.clear();
+    }
+
+    /**
+     * Total queue capacity (frames a decoder may have to keep alive)
+     */
+    size_t getTotalCapacity() {
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        size_t total = 0;
+        for (auto& consumer : consumers) {
+            total += consumer->getCapacity();
+        }
+        return total;
+    }
+
+    size_t getConsumerCount() {
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        return consumers.size();
+    }
+
+    uint64_t getFramesPublished() const { return framesPublished; }
+};
+
+#endif // FRAME_BUS_HPP
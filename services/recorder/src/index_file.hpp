@@ -0,0 +1,96 @@
+#ifndef INDEX_FILE_HPP
+#define INDEX_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "logger.hpp"
+
+/**
+ * IndexFile - Append-only binary sidecar of a recording file
+ *
+ * 8-byte magic, then fixed-size little-endian records (layout defined
+ * by the owner: ChunkIndex, SeekIndex). Opened with O_APPEND, records
+ * are added with one write() each call, after the data they point at
+ * has been handed to the recording file; a crash loses at most the
+ * records of the last, unfinished write.
+ */
+class IndexFile {
+public:
+    static constexpr size_t MAGIC_BYTES = 8;
+
+private:
+    int fd;
+    std::string path;
+
+    bool writeAll(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+public:
+    IndexFile() : fd(-1) {}
+
+    ~IndexFile() {
+        close();
+    }
+
+    IndexFile(const IndexFile&) = delete;
+    IndexFile& operator=(const IndexFile&) = delete;
+
+    static void putLittleEndian(uint8_t* out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            out[i] = (uint8_t)(value >> (8 * i));
+        }
+    }
+
+    /**
+     * Create (truncate) and write the magic
+     */
+    bool create(const std::string& filePath, const char (&magic)[MAGIC_BYTES + 1]) {
+        close();
+        path = filePath;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            Logger::error("IndexFile: cannot create " + path + ": " + strerror(errno));
+            return false;
+        }
+        if (!writeAll(reinterpret_cast<const uint8_t*>(magic), MAGIC_BYTES)) {
+            Logger::error("IndexFile: cannot write " + path + ": " + strerror(errno));
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool append(const uint8_t* records, size_t size) {
+        if (fd < 0) return false;
+        if (!writeAll(records, size)) {
+            Logger::error("IndexFile: cannot append to " + path + ": " + strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd < 0) return;
+        ::close(fd);
+        fd = -1;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+    const std::string& getPath() const { return path; }
+};
+
+#endif // INDEX_FILE_HPP
@@ -0,0 +1,193 @@
+#ifndef IO_URING_QUEUE_HPP
+#define IO_URING_QUEUE_HPP
+
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/**
+ * IoUringQueue - Minimal io_uring submission/completion ring
+ *
+ * Raw syscalls on the kernel UAPI header, no liburing dependency. Only
+ * what the recorder needs: get an SQE, submit (optionally waiting for
+ * completions), reap CQEs. One thread per queue.
+ *
+ * init() fails cleanly where io_uring is missing or blocked (old
+ * kernel, seccomp in containers); callers keep a synchronous fallback.
+ */
+class IoUringQueue {
+private:
+    int ringFd;
+    unsigned entries;
+
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    io_uring_cqe* cqes;
+
+    unsigned localTail;      // SQEs handed out
+    unsigned submittedTail;  // SQEs published to the kernel
+
+    void release() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) close(ringFd);
+        ringFd = -1;
+        sqRing = cqRing = nullptr;
+        sqes = nullptr;
+    }
+
+public:
+    IoUringQueue()
+        : ringFd(-1), entries(0), sqRing(nullptr), sqRingSize(0), cqRing(nullptr), cqRingSize(0),
+          sqes(nullptr), sqesSize(0), sqHead(nullptr), sqTail(nullptr), sqMask(nullptr), sqArray(nullptr),
+          cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr), localTail(0), submittedTail(0) {}
+
+    ~IoUringQueue() {
+        release();
+    }
+
+    IoUringQueue(const IoUringQueue&) = delete;
+    IoUringQueue& operator=(const IoUringQueue&) = delete;
+
+    /**
+     * @return false (errno set) if io_uring is not usable here
+     */
+    bool init(unsigned queueDepth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = (int)syscall(__NR_io_uring_setup, queueDepth, &params);
+        if (fd < 0) return false;
+        ringFd = fd;
+        entries = params.sq_entries;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            release();
+            return false;
+        }
+        if (singleMmap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                release();
+                return false;
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_SQES);
+        if (sqeMemory == MAP_FAILED) {
+            release();
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqeMemory);
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        localTail = submittedTail = *sqTail;
+        return true;
+    }
+
+    /**
+     * Kernel supports an opcode (IORING_REGISTER_PROBE)
+     */
+    bool supports(int opcode) const {
+        if (ringFd < 0) return false;
+        const unsigned maxOps = 256;
+        std::vector<char> buffer(sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, maxOps) < 0) {
+            return false;
+        }
+        return opcode < probe->ops_len && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    /**
+     * Next free SQE, zeroed (nullptr when the ring is full: submit first)
+     */
+    io_uring_sqe* getSqe() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (localTail - head >= entries) return nullptr;
+        io_uring_sqe* sqe = &sqes[localTail & *sqMask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        localTail++;
+        return sqe;
+    }
+
+    /**
+     * Publish queued SQEs; waitFor > 0 blocks until that many complete
+     *
+     * @return Number submitted, or -errno
+     */
+    int submit(unsigned waitFor = 0) {
+        unsigned pending = localTail - submittedTail;
+        for (unsigned tail = submittedTail; tail != localTail; tail++) {
+            sqArray[tail & *sqMask] = tail & *sqMask;
+        }
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        submittedTail = localTail;
+
+        unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int ret;
+        do {
+            ret = (int)syscall(__NR_io_uring_enter, ringFd, pending, waitFor, flags, nullptr, 0);
+        } while (ret < 0 && errno == EINTR);
+        return ret < 0 ? -errno : ret;
+    }
+
+    /**
+     * Take one completion if available
+     */
+    bool popCqe(io_uring_cqe& out) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        out = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    unsigned getEntries() const { return entries; }
+    bool isReady() const { return ringFd >= 0; }
+};
+
+#endif // IO_URING_QUEUE_HPP
@@ -0,0 +1,25 @@
+#ifndef LIBAV_COMMON_HPP
+#define LIBAV_COMMON_HPP
+
+#include <string>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
+}
+
+/**
+ * Convert libav error code to readable string
+ */
+inline std::string avErrorString(int errnum) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, errbuf, sizeof(errbuf));
+    return std::string(errbuf);
+}
+
+#endif // LIBAV_COMMON_HPP
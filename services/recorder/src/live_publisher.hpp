@@ -0,0 +1,176 @@
+#ifndef LIVE_PUBLISHER_HPP
+#define LIVE_PUBLISHER_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include "libav_common.hpp"
+#include "logger.hpp"
+
+/**
+ * LivePublisher - RTSP publish to MediaMTX from the in-process pipeline
+ *
+ * Equivalent of `-f rtsp -rtsp_transport tcp <url>` in the ffmpeg CLI.
+ * The session is opened on the first video keyframe. If MediaMTX is down
+ * or the publish fails, live output is retried after RETRY_SECONDS while
+ * recording continues unaffected. Blocking socket I/O is interrupted
+ * once the abort flag is set (forced stop of the pipeline).
+ */
+class LivePublisher {
+private:
+    struct OutputStream {
+        AVCodecParameters* codecpar;  // Owned copy
+        AVRational sourceTimeBase;
+    };
+
+    static constexpr int RETRY_SECONDS = 30;
+
+    std::string cameraName;
+    std::string publishUrl;
+    std::vector<OutputStream> streams;
+    int videoStream;
+
+    AVFormatContext* outputCtx;
+    std::chrono::steady_clock::time_point retryAt;
+    uint64_t packetsSent;
+    const std::atomic<bool>* abortFlag;
+
+    static int interruptCallback(void* opaque) {
+        auto* self = static_cast<LivePublisher*>(opaque);
+        return self->abortFlag && *self->abortFlag ? 1 : 0;
+    }
+
+    bool open() {
+        int ret = avformat_alloc_output_context2(&outputCtx, nullptr, "rtsp", publishUrl.c_str());
+        if (ret < 0 || !outputCtx) {
+            Logger::warn("LivePublisher: cannot create RTSP muxer for " + cameraName + ": " + avErrorString(ret));
+            outputCtx = nullptr;
+            return false;
+        }
+        outputCtx->interrupt_callback.callback = &LivePublisher::interruptCallback;
+        outputCtx->interrupt_callback.opaque = this;
+
+        for (const auto& stream : streams) {
+            AVStream* out = avformat_new_stream(outputCtx, nullptr);
+            if (!out) {
+                closeOutput();
+                return false;
+            }
+            avcodec_parameters_copy(out->codecpar, stream.codecpar);
+            out->codecpar->codec_tag = 0;
+            out->time_base = stream.sourceTimeBase;
+        }
+
+        AVDictionary* opts = nullptr;
+        av_dict_set(&opts, "rtsp_transport", "tcp", 0);
+        ret = avformat_write_header(outputCtx, &opts);
+        av_dict_free(&opts);
+
+        if (ret < 0) {
+            Logger::warn("LivePublisher: publish failed for " + cameraName + ": " + avErrorString(ret) +
+                         " (retry in " + std::to_string(RETRY_SECONDS) + "s)");
+            closeOutput();
+            return false;
+        }
+
+        Logger::info("LivePublisher: publishing " + cameraName + " to MediaMTX");
+        return true;
+    }
+
+    void closeOutput() {
+        if (!outputCtx) return;
+        avformat_free_context(outputCtx);
+        outputCtx = nullptr;
+    }
+
+    void fail() {
+        if (outputCtx) {
+            av_write_trailer(outputCtx);
+            closeOutput();
+        }
+        retryAt = std::chrono::steady_clock::now() + std::chrono::seconds(RETRY_SECONDS);
+    }
+
+public:
+    LivePublisher(const std::string& name, const std::string& url, const std::atomic<bool>* abort = nullptr)
+        : cameraName(name), publishUrl(url), videoStream(-1), outputCtx(nullptr),
+          retryAt(std::chrono::steady_clock::time_point::min()), packetsSent(0), abortFlag(abort) {}
+
+    ~LivePublisher() {
+        close();
+        for (auto& stream : streams) {
+            avcodec_parameters_free(&stream.codecpar);
+        }
+    }
+
+    LivePublisher(const LivePublisher&) = delete;
+    LivePublisher& operator=(const LivePublisher&) = delete;
+
+    /**
+     * Register an output stream (must happen before the first packet)
+     */
+    int addStream(const AVCodecParameters* codecpar, AVRational timeBase) {
+        OutputStream stream;
+        stream.codecpar = avcodec_parameters_alloc();
+        avcodec_parameters_copy(stream.codecpar, codecpar);
+        stream.sourceTimeBase = timeBase;
+        streams.push_back(stream);
+
+        int index = (int)streams.size() - 1;
+        if (videoStream < 0 && codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            videoStream = index;
+        }
+        return index;
+    }
+
+    /**
+     * Send a packet to MediaMTX (consumes the packet reference)
+     */
+    void writePacket(AVPacket* pkt, int streamIndex) {
+        if (videoStream < 0 || streamIndex < 0 || streamIndex >= (int)streams.size()) {
+            av_packet_unref(pkt);
+            return;
+        }
+
+        if (!outputCtx) {
+            bool isKey = streamIndex == videoStream && (pkt->flags & AV_PKT_FLAG_KEY);
+            auto now = std::chrono::steady_clock::now();
+            if (!isKey || now < retryAt) {
+                av_packet_unref(pkt);
+                return;
+            }
+            if (!open()) {
+                retryAt = now + std::chrono::seconds(RETRY_SECONDS);
+                av_packet_unref(pkt);
+                return;
+            }
+        }
+
+        AVStream* out = outputCtx->streams[streamIndex];
+        av_packet_rescale_ts(pkt, streams[streamIndex].sourceTimeBase, out->time_base);
+        pkt->stream_index = streamIndex;
+        pkt->pos = -1;
+
+        int ret = av_interleaved_write_frame(outputCtx, pkt);
+        if (ret < 0) {
+            Logger::warn("LivePublisher: write failed for " + cameraName + ": " + avErrorString(ret) +
+                         " (retry in " + std::to_string(RETRY_SECONDS) + "s)");
+            fail();
+            return;
+        }
+        packetsSent++;
+    }
+
+    void close() {
+        if (outputCtx) {
+            av_write_trailer(outputCtx);
+            closeOutput();
+        }
+    }
+
+    bool isPublishing() const { return outputCtx != nullptr; }
+    uint64_t getPacketsSent() const { return packetsSent; }
+};
+
+#endif // LIVE_PUBLISHER_HPP
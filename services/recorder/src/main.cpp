@@ -2,12 +2,15 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 #include <signal.h>
 #include "camera_manager.hpp"
 #include "config.hpp"
-#include "database.hpp"
+#include "database_pool.hpp"
 #include "logger.hpp"
 #include "storage_manager.hpp"
+#include "tier_mover.hpp"
+#include "partition_maintainer.hpp"
 #include "mediamtx_health.hpp"
 
 // Global flag for graceful shutdown
@@ -40,9 +43,13 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
-        // Initialize database connection
-        auto db = std::make_shared<Database>(config, 3, 5);  // 3 retries, 5s delay
-        if (!db->connectWithRetry()) {
+        // Database connections, shared by all recorder threads
+        auto dbPool = std::make_shared<DatabasePool>(
+            config,
+            (size_t)std::max(config.getDbPoolSize(), 1),
+            std::chrono::milliseconds(std::max(config.getDbPoolWaitMs(), 0))
+        );
+        if (!dbPool->start(std::chrono::seconds(30))) {
             Logger::error("Failed to connect to database after retries");
             return 1;
         }
@@ -56,6 +63,23 @@ int main(int argc, char* argv[]) {
             config.getMinFreeSpaceGB()
         );
         
+        // More recording volumes (JBOD); cameras are spread over all of them
+        for (const auto& volume : config.getRecordingVolumes()) {
+            storageManager->addVolume(volume);
+        }
+        
+        // Slower tiers for aged recordings (optional)
+        if (!config.getWarmPath().empty()) {
+            storageManager->addTier("warm", config.getWarmPath());
+        }
+        if (!config.getColdPath().empty()) {
+            storageManager->addTier("cold", config.getColdPath());
+        }
+        
+        // Index existing segments once; cleanup works from the index
+        storageManager->rebuildIndex();
+        storageManager->startVolumeProbes();
+        
         // Log initial storage status
         storageManager->logStorageInfo();
         
@@ -66,6 +90,7 @@ int main(int argc, char* argv[]) {
             Logger::info("Attempting emergency cleanup...");
             uint64_t freed = storageManager->emergencyCleanup(config.getMinFreeSpaceGB() + 20); // Target 20GB extra
             if (freed > 0) {
+                storageManager->waitForEviction(std::chrono::minutes(10));
                 Logger::info("Emergency cleanup freed " + std::to_string(freed) + " GB");
                 if (!storageManager->hasEnoughSpace()) {
                     Logger::error("Still insufficient space after cleanup. Exiting.");
@@ -79,6 +104,20 @@ int main(int argc, char* argv[]) {
         
         Logger::info("Disk space check passed - sufficient space available");
         
+        // Move aged recordings to the slower tiers in the background
+        TierMover::Settings tierSettings;
+        tierSettings.warmAfterHours = config.getTierWarmAfterHours();
+        tierSettings.coldAfterDays = config.getTierColdAfterDays();
+        tierSettings.bandwidthMBps = config.getTierMoveMBps();
+        auto tierMover = std::make_shared<TierMover>(dbPool, storageManager, tierSettings);
+        tierMover->start();
+        
+        // Daily partitions ahead; retention drops whole days of metadata (background)
+        auto partitionMaintainer = std::make_shared<PartitionMaintainer>(dbPool, storageManager,
+                                                                         config.getPartitionDaysAhead(),
+                                                                         config.getMetricsRetentionDays());
+        partitionMaintainer->start();
+        
         // Initialize MediaMTX Health Monitor
         std::string mediamtxUrl = getEnvVar("MEDIAMTX_API_URL", "http://localhost:9997");
         int healthCheckInterval = std::stoi(getEnvVar("MEDIAMTX_HEALTH_CHECK_INTERVAL", "30"));
@@ -92,7 +131,7 @@ int main(int argc, char* argv[]) {
         }
         
         // Initialize Camera Manager
-        auto cameraManager = std::make_shared<CameraManager>(config, db, storageManager);
+        auto cameraManager = std::make_shared<CameraManager>(config, dbPool, storageManager);
         
         // Load cameras from database
         Logger::info("Loading cameras from database...");
@@ -114,9 +153,10 @@ int main(int argc, char* argv[]) {
         Logger::info("Recording engine started successfully");
         Logger::info("Press Ctrl+C to stop");
         
-        // Storage cleanup thread
-        auto lastCleanup = std::chrono::steady_clock::now();
-        int cleanupIntervalSeconds = config.getCleanupIntervalHours() * 3600;
+        int eventPollSeconds = std::max(config.getEventPollSeconds(), 1);
+        int storageSampleSeconds = std::max(config.getStorageSampleSeconds(), 1);
+        int heartbeatSeconds = config.getHeartbeatSeconds();
+        int cameraResyncSeconds = config.getCameraResyncSeconds();
         
         // Main loop - wait for shutdown signal
         while (!g_shutdown) {
@@ -124,16 +164,27 @@ int main(int argc, char* argv[]) {
             
             // Log status every 60 seconds
             static int counter = 0;
-            if (++counter % 60 == 0) {
+            ++counter;
+
+            // Cameras added, removed or edited (NOTIFY, periodic diff)
+            cameraManager->reconcileCameras(cameraResyncSeconds);
+            
+            // Event-triggered cameras: pick up new events
+            if (counter % eventPollSeconds == 0) {
+                cameraManager->pollEvents();
+            }
+
+            if (counter % 60 == 0) {
                 cameraManager->logStatus();
                 
                 // Check MediaMTX health
                 std::string mediamtxStatus = mediamtxHealth->getStatus();
                 Logger::info("MediaMTX Status: " + mediamtxStatus);
                 
-                // Check database connection
-                if (!db->isConnected()) {
-                    Logger::warn("Database connection check failed - will auto-reconnect on next query");
+                // Database connections (reconnected in the background)
+                Logger::info("Database pool: " + dbPool->getSummary());
+                if (dbPool->getUpCount() == 0) {
+                    Logger::warn("No database connection - reconnecting in the background");
                 }
             }
             
@@ -142,35 +193,24 @@ int main(int argc, char* argv[]) {
                 mediamtxHealth->isServerHealthy();
             }
             
-            // Check if it's time for cleanup
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastCleanup).count();
+            // Recording cameras: cameras.last_seen
+            if (heartbeatSeconds > 0 && counter % heartbeatSeconds == 0) {
+                cameraManager->sendHeartbeats();
+            }
             
-            if (elapsed >= cleanupIntervalSeconds) {
-                Logger::info("Running scheduled cleanup...");
-                storageManager->logStorageInfo();
-                
-                // Run normal cleanup
-                storageManager->cleanupOldRecordings();
-                
-                // Check if emergency cleanup needed
-                if (!storageManager->hasEnoughSpace()) {
-                    Logger::warn("Disk space critical - running emergency cleanup");
-                    uint64_t freedGB = storageManager->emergencyCleanup(config.getMinFreeSpaceGB() + 10);
-                    if (freedGB > 0) {
-                        Logger::info("Emergency cleanup freed " + std::to_string(freedGB) + " GB");
-                    }
-                }
-                
-                lastCleanup = now;
+            // Disk consumption: retention, predictive eviction ahead of a full disk
+            if (counter % storageSampleSeconds == 0) {
+                cameraManager->sampleStorage();
             }
         }
         
         // Graceful shutdown
         Logger::info("Stopping recording engine...");
         cameraManager->stopAll();
+        tierMover->stop();
+        partitionMaintainer->stop();
         
-        db->disconnect();
+        dbPool->stop();
         Logger::info("Recording engine stopped");
         
     } catch (const std::exception& e) {
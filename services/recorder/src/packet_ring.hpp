@@ -0,0 +1,234 @@
+#ifndef PACKET_RING_HPP
+#define PACKET_RING_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include "libav_common.hpp"
+
+/**
+ * RingSignal - Wakeup shared by the rings feeding one writer thread
+ *
+ * Producers only take the mutex when the writer is actually asleep, so
+ * the packet path stays lock-free while the writer keeps up.
+ */
+class RingSignal {
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> waiting;
+
+public:
+    RingSignal() : waiting(false) {}
+
+    RingSignal(const RingSignal&) = delete;
+    RingSignal& operator=(const RingSignal&) = delete;
+
+    void notify() {
+        if (waiting.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_one();
+        }
+    }
+
+    /**
+     * Sleep until ready() is true or the timeout expires
+     */
+    void wait(int timeoutMs, const std::function<bool()>& ready) {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true);
+        cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+        waiting.store(false);
+    }
+};
+
+/**
+ * PacketRing - Bounded lock-free single-producer/single-consumer packet queue
+ *
+ * Sits between the RTSP demux (or an encoder) and a writer thread so a
+ * slow disk flush in the segment writer never stalls RTSP reads.
+ *
+ * - Fixed power-of-two slot array, AVPackets preallocated; push() only
+ *   takes a reference, pop() moves it out
+ * - Producer and consumer indices live on separate cache lines
+ * - High-water mark: once the ring is that full, the producer drops the
+ *   rest of the current GOP and resumes on the next video keyframe
+ *   with room, so the writer never gets a GOP with holes in it
+ * - Counters: depth, packets/GOPs dropped, max queueing latency
+ */
+class PacketRing {
+public:
+    struct Stats {
+        size_t depth;
+        size_t capacity;
+        uint64_t packetsPushed;
+        uint64_t packetsDropped;
+        uint64_t gopsDropped;
+        int64_t maxLatencyMs;
+    };
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Slot {
+        AVPacket* packet;
+        int streamIndex;
+        int64_t enqueuedUs;
+    };
+
+    std::string name;
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t highWater;
+    std::shared_ptr<RingSignal> signal;
+
+    // Producer side
+    alignas(CACHE_LINE) std::atomic<size_t> head;
+    bool droppingGop;
+    std::atomic<uint64_t> packetsPushed;
+    std::atomic<uint64_t> packetsDropped;
+    std::atomic<uint64_t> gopsDropped;
+
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<size_t> tail;
+    std::atomic<int64_t> maxLatencyUs;
+
+    alignas(CACHE_LINE) std::atomic<bool> closed;
+
+    static size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+public:
+    /**
+     * @param ringName Name for logs/stats
+     * @param minCapacity Slot count (rounded up to a power of two)
+     * @param waitSignal Wakeup of the consuming writer thread
+     */
+    PacketRing(const std::string& ringName, size_t minCapacity, std::shared_ptr<RingSignal> waitSignal)
+        : name(ringName), signal(std::move(waitSignal)), head(0), droppingGop(false),
+          packetsPushed(0), packetsDropped(0), gopsDropped(0), tail(0), maxLatencyUs(0), closed(false) {
+        size_t capacity = roundUpPowerOfTwo(minCapacity);
+        mask = capacity - 1;
+        highWater = capacity - capacity / 4;
+        slots.resize(capacity);
+        for (auto& slot : slots) {
+            slot.packet = av_packet_alloc();
+            slot.streamIndex = -1;
+            slot.enqueuedUs = 0;
+        }
+    }
+
+    ~PacketRing() {
+        for (auto& slot : slots) {
+            av_packet_free(&slot.packet);
+        }
+    }
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    /**
+     * Producer: queue a reference of the packet (packet is not consumed)
+     *
+     * @param isVideo Packet belongs to the video stream (keyframes end a GOP drop)
+     * @return false if the packet was dropped
+     */
+    bool push(const AVPacket* pkt, int streamIndex, bool isVideo) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t depth = h - tail.load(std::memory_order_acquire);
+        bool isKey = isVideo && (pkt->flags & AV_PKT_FLAG_KEY);
+
+        if (droppingGop) {
+            if (!isKey || depth >= highWater) {
+                packetsDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            droppingGop = false;
+        } else if (depth >= highWater) {
+            droppingGop = true;
+            gopsDropped.fetch_add(1, std::memory_order_relaxed);
+            packetsDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Slot& slot = slots[h & mask];
+        if (av_packet_ref(slot.packet, pkt) < 0) {
+            packetsDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slot.streamIndex = streamIndex;
+        slot.enqueuedUs = av_gettime_relative();
+
+        head.store(h + 1);   // seq_cst pairs with RingSignal::wait()
+        packetsPushed.fetch_add(1, std::memory_order_relaxed);
+        signal->notify();
+        return true;
+    }
+
+    /**
+     * Consumer: take the oldest packet
+     *
+     * @param out Receives the packet reference (caller unrefs)
+     * @return false if the ring is empty
+     */
+    bool pop(AVPacket* out, int& streamIndex) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        Slot& slot = slots[t & mask];
+        av_packet_move_ref(out, slot.packet);
+        streamIndex = slot.streamIndex;
+
+        int64_t latency = av_gettime_relative() - slot.enqueuedUs;
+        if (latency > maxLatencyUs.load(std::memory_order_relaxed)) {
+            maxLatencyUs.store(latency, std::memory_order_relaxed);
+        }
+
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Producer: no more packets will follow
+     */
+    void close() {
+        closed.store(true);
+        signal->notify();
+    }
+
+    bool isEmpty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Closed and fully drained
+     */
+    bool isFinished() const {
+        return closed.load() && isEmpty();
+    }
+
+    Stats getStats() const {
+        Stats stats;
+        stats.depth = head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        stats.capacity = slots.size();
+        stats.packetsPushed = packetsPushed.load(std::memory_order_relaxed);
+        stats.packetsDropped = packetsDropped.load(std::memory_order_relaxed);
+        stats.gopsDropped = gopsDropped.load(std::memory_order_relaxed);
+        stats.maxLatencyMs = maxLatencyUs.load(std::memory_order_relaxed) / 1000;
+        return stats;
+    }
+
+    std::string getName() const { return name; }
+};
+
+#endif // PACKET_RING_HPP
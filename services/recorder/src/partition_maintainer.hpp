@@ -0,0 +1,163 @@
+#ifndef PARTITION_MAINTAINER_HPP
+#define PARTITION_MAINTAINER_HPP
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
+#include <condition_variable>
+#include "storage_manager.hpp"
+#include "database_pool.hpp"
+#include "logger.hpp"
+
+/**
+ * PartitionMaintainer - Daily partitions of recordings, events and
+ * system_metrics (migration 009)
+ *
+ * One background thread (the drops may wait on table locks, which must
+ * not hold up the control loop) runs a pass at start and then every
+ * RUN_INTERVAL_SECONDS, through a pooled connection:
+ * 1. creates the partitions up to daysAhead days from today, so inserts
+ *    never land in the DEFAULT partitions
+ * 2. drops the recordings and events days whose files are gone: older
+ *    than the oldest segment StorageManager still indexes (less one day
+ *    for segments crossing midnight and segments being moved), and
+ *    never younger than the longest retention, global or per camera
+ * 3. drops system_metrics days older than metricsRetentionDays
+ *
+ * Retention of the metadata is thus a DROP TABLE per day instead of
+ * row deletes, and follows the file deletes of the retention, quota and
+ * disk-pressure passes. If nothing is indexed (no recordings, or a
+ * volume not mounted) only the retention bound applies.
+ */
+class PartitionMaintainer {
+private:
+    static constexpr std::time_t DAY_SECONDS = 86400;
+    static constexpr int RUN_INTERVAL_SECONDS = 3600;
+    static constexpr int RETRY_SECONDS = 300;
+
+    std::shared_ptr<DatabasePool> pool;
+    std::shared_ptr<StorageManager> storage;
+    int daysAhead;
+    int metricsRetentionDays;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+
+    static std::string localDate(std::time_t when) {
+        std::tm tm;
+        localtime_r(&when, &tm);
+        char buffer[16];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm);
+        return buffer;
+    }
+
+    /**
+     * Rows starting before this may go, 0 = keep everything
+     */
+    std::time_t recordingsCutoff(std::time_t now) const {
+        int retentionDays = storage->getLongestRetentionDays();
+        std::time_t retentionCutoff = retentionDays > 0 ? now - (std::time_t)retentionDays * DAY_SECONDS : 0;
+        std::time_t oldest = storage->getOldestSegmentTime();
+        if (oldest == 0) return retentionCutoff;
+        std::time_t filesCutoff = oldest - DAY_SECONDS;
+        return retentionCutoff > 0 ? std::min(filesCutoff, retentionCutoff) : filesCutoff;
+    }
+
+    /**
+     * Sleep that stop() cuts short; false = stopping
+     */
+    bool sleepFor(int seconds) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return !cv.wait_for(lock, std::chrono::seconds(seconds), [this] { return stopping; });
+    }
+
+    /**
+     * One pass; false if a step failed (database down, table lock busy)
+     */
+    bool runPass() {
+        DatabasePool::Lease database = pool->acquire();
+        if (!database) {
+            Logger::warn("PartitionMaintainer: no database connection, retry in " +
+                         std::to_string(RETRY_SECONDS) + " s");
+            return false;
+        }
+
+        int created = database->ensureTimePartitions(daysAhead);
+        bool ok = created >= 0;
+        if (created > 0) {
+            Logger::info("Created " + std::to_string(created) + " time partitions");
+        }
+
+        std::time_t now = std::time(nullptr);
+        std::time_t cutoff = recordingsCutoff(now);
+        if (cutoff > 0) {
+            std::string cutoffDay = localDate(cutoff);
+            int recordings = database->dropTimePartitionsBefore("recordings", cutoffDay);
+            int events = database->dropTimePartitionsBefore("events", cutoffDay);
+            ok = ok && recordings >= 0 && events >= 0;
+            if (recordings > 0 || events > 0) {
+                Logger::info("Retention: dropped " + std::to_string(std::max(recordings, 0)) +
+                             " recordings and " + std::to_string(std::max(events, 0)) +
+                             " events partitions before " + cutoffDay);
+            }
+        }
+
+        if (metricsRetentionDays > 0) {
+            std::string cutoffDay = localDate(now - (std::time_t)metricsRetentionDays * DAY_SECONDS);
+            int metrics = database->dropTimePartitionsBefore("system_metrics", cutoffDay);
+            ok = ok && metrics >= 0;
+            if (metrics > 0) {
+                Logger::info("Retention: dropped " + std::to_string(metrics) +
+                             " system_metrics partitions before " + cutoffDay);
+            }
+        }
+        return ok;
+    }
+
+    void workerLoop() {
+        while (sleepFor(runPass() ? RUN_INTERVAL_SECONDS : RETRY_SECONDS)) {}
+    }
+
+public:
+    PartitionMaintainer(std::shared_ptr<DatabasePool> databasePool, std::shared_ptr<StorageManager> storageManager,
+                        int partitionDaysAhead, int metricsRetention)
+        : pool(std::move(databasePool)), storage(std::move(storageManager)),
+          daysAhead(std::max(partitionDaysAhead, 1)), metricsRetentionDays(std::max(metricsRetention, 0)),
+          stopping(false) {}
+
+    ~PartitionMaintainer() {
+        stop();
+    }
+
+    PartitionMaintainer(const PartitionMaintainer&) = delete;
+    PartitionMaintainer& operator=(const PartitionMaintainer&) = delete;
+
+    void start() {
+        if (worker.joinable()) return;
+        Logger::info("Partition maintainer: " + std::to_string(daysAhead) + " days ahead, system_metrics kept " +
+                     (metricsRetentionDays > 0 ? std::to_string(metricsRetentionDays) + " days" : "forever"));
+        worker = std::thread(&PartitionMaintainer::workerLoop, this);
+    }
+
+    /**
+     * Stop after the current pass
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
+
+#endif // PARTITION_MAINTAINER_HPP
@@ -0,0 +1,179 @@
+#ifndef PROBE_CACHE_HPP
+#define PROBE_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <ctime>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include "stream_analyzer.hpp"
+#include "logger.hpp"
+
+/**
+ * ProbeCache - Persistent stream properties, keyed by RTSP URL
+ *
+ * Keeps the last known codec, resolution, fps and pix_fmt of every
+ * camera across restarts, so a pipeline can be built without waiting
+ * for a fresh probe.
+ *
+ * File format: one tab-separated line per camera
+ *   url  codec  width  height  fps  pix_fmt  probed_at (unix seconds)
+ *
+ * The file holds RTSP credentials, so it is written 0600, via a temp
+ * file + rename so a crash never leaves it half-written.
+ */
+class ProbeCache {
+public:
+    struct Entry {
+        StreamAnalyzer::StreamInfo info;
+        std::time_t probedAt;
+    };
+
+private:
+    std::string filePath;
+    mutable std::mutex mutex;
+    std::mutex saveMutex;      // One writer of the temp file at a time
+    std::unordered_map<std::string, Entry> entries;
+    bool dirty;
+
+    static bool parseLine(const std::string& line, std::string& url, Entry& entry) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 7) {
+            return false;
+        }
+
+        try {
+            url = fields[0];
+            entry.info.codec = fields[1];
+            entry.info.width = std::stoi(fields[2]);
+            entry.info.height = std::stoi(fields[3]);
+            entry.info.frameRate = std::stod(fields[4]);
+            entry.info.pixelFormat = fields[5];
+            entry.probedAt = (std::time_t)std::stoll(fields[6]);
+        } catch (...) {
+            return false;
+        }
+        entry.info.isJpegColorRange = entry.info.pixelFormat.find("yuvj") == 0;
+        entry.info.isValid = !url.empty() && entry.info.width > 0 && entry.info.height > 0;
+        return entry.info.isValid;
+    }
+
+public:
+    explicit ProbeCache(const std::string& path) : filePath(path), dirty(false) {}
+
+    ProbeCache(const ProbeCache&) = delete;
+    ProbeCache& operator=(const ProbeCache&) = delete;
+
+    /**
+     * Read the cache file (missing file = empty cache)
+     *
+     * @return Number of entries loaded
+     */
+    size_t load() {
+        std::ifstream file(filePath);
+        if (!file) {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string line;
+        size_t skipped = 0;
+        while (std::getline(file, line)) {
+            std::string url;
+            Entry entry;
+            if (parseLine(line, url, entry)) {
+                entries[url] = entry;
+            } else if (!line.empty()) {
+                skipped++;
+            }
+        }
+        if (skipped > 0) {
+            Logger::warn("ProbeCache: ignored " + std::to_string(skipped) + " malformed lines in " + filePath);
+        }
+        return entries.size();
+    }
+
+    /**
+     * Write the cache file if anything changed since the last save
+     */
+    bool save() {
+        std::lock_guard<std::mutex> saveLock(saveMutex);
+        std::unordered_map<std::string, Entry> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!dirty) return true;
+            snapshot = entries;
+            dirty = false;
+        }
+
+        std::string tmpPath = filePath + ".tmp";
+        mode_t oldMask = umask(077);
+        std::ofstream file(tmpPath, std::ios::trunc);
+        umask(oldMask);
+        if (!file) {
+            Logger::error("ProbeCache: cannot write " + tmpPath + ": " + strerror(errno));
+            std::lock_guard<std::mutex> lock(mutex);
+            dirty = true;
+            return false;
+        }
+
+        for (const auto& item : snapshot) {
+            const StreamAnalyzer::StreamInfo& info = item.second.info;
+            file << item.first << '\t' << info.codec << '\t' << info.width << '\t' << info.height << '\t'
+                 << info.frameRate << '\t' << info.pixelFormat << '\t' << (long long)item.second.probedAt << '\n';
+        }
+        file.close();
+
+        if (!file || std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+            Logger::error("ProbeCache: cannot replace " + filePath + ": " + strerror(errno));
+            std::remove(tmpPath.c_str());
+            std::lock_guard<std::mutex> lock(mutex);
+            dirty = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool get(const std::string& url, Entry& entry) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(url);
+        if (it == entries.end()) {
+            return false;
+        }
+        entry = it->second;
+        return true;
+    }
+
+    /**
+     * Store a successful probe (invalid results are ignored)
+     */
+    void put(const std::string& url, const StreamAnalyzer::StreamInfo& info) {
+        if (!info.isValid) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entries[url];
+        entry.info = info;
+        entry.probedAt = std::time(nullptr);
+        dirty = true;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    std::string getPath() const { return filePath; }
+};
+
+#endif // PROBE_CACHE_HPP
@@ -0,0 +1,93 @@
+#ifndef PROCESS_SUPERVISOR_HPP
+#define PROCESS_SUPERVISOR_HPP
+
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include "logger.hpp"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+/**
+ * ProcessSupervisor - Child exit notification without polling
+ *
+ * A pidfd (Linux 5.3+) becomes readable the moment the child exits, so
+ * the camera reactor can watch it like any other fd and restart a
+ * crashed ffmpeg within milliseconds. On older kernels openPidFd()
+ * returns -1 and callers fall back to waitpid(WNOHANG) polling.
+ */
+class ProcessSupervisor {
+private:
+    static constexpr int FALLBACK_POLL_MS = 20;
+
+public:
+    /**
+     * @return pidfd for the child, -1 if the kernel has no pidfd_open
+     */
+    static int openPidFd(pid_t pid) {
+        int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+        if (fd < 0) {
+            Logger::debug("pidfd_open unavailable (" + std::string(strerror(errno)) + "), polling child " +
+                          std::to_string(pid));
+            return -1;
+        }
+        return fd;
+    }
+
+    /**
+     * Wait until the child exits or the deadline passes, then reap it
+     *
+     * @param pidFd pidfd from openPidFd(), or -1 to poll waitpid
+     * @param status Receives the waitpid status
+     * @return true if the child was reaped
+     */
+    static bool waitForExit(pid_t pid, int pidFd, std::chrono::steady_clock::time_point deadline, int* status) {
+        while (true) {
+            pid_t result = waitpid(pid, status, WNOHANG);
+            if (result == pid || (result < 0 && errno == ECHILD)) {
+                return true;
+            }
+
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return false;
+            }
+
+            if (pidFd >= 0) {
+                pollfd pfd{};
+                pfd.fd = pidFd;
+                pfd.events = POLLIN;
+                poll(&pfd, 1, (int)remaining);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(
+                    std::min<int64_t>(remaining, FALLBACK_POLL_MS)));
+            }
+        }
+    }
+
+    /**
+     * Describe a waitpid status for logs
+     */
+    static std::string describeExit(int status) {
+        if (WIFEXITED(status)) {
+            return "code " + std::to_string(WEXITSTATUS(status));
+        }
+        if (WIFSIGNALED(status)) {
+            return "signal " + std::to_string(WTERMSIG(status));
+        }
+        return "unknown status";
+    }
+};
+
+#endif // PROCESS_SUPERVISOR_HPP
@@ -0,0 +1,250 @@
+#ifndef RECORDING_INGESTOR_HPP
+#define RECORDING_INGESTOR_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <condition_variable>
+#include "database.hpp"
+#include "database_pool.hpp"
+#include "logger.hpp"
+
+/**
+ * RecordingIngestor - Writes a recordings row for every closed segment
+ *
+ * Camera threads only append to a bounded in-memory queue; one worker
+ * with a pooled connection takes up to batchRows rows at a time (or what
+ * is there after FLUSH_INTERVAL_MS) and inserts them with one COPY
+ * (Database::copyRecordings), so Postgres sees a few round trips per
+ * batch instead of one blocking statement per segment.
+ *
+ * When the queue is full (database down for long), new rows are dropped
+ * and counted: the files are on disk, and the API disk scan adds rows
+ * that are missing. A failed batch stays queued and is retried with
+ * back-off; stop() writes what is left if the database is reachable.
+ * A batch the server rejects for its data (SQLSTATE class 22 or 23: a
+ * value too long for its column, a constraint) is bisected down to the
+ * bad row, which is dropped after MAX_ROW_ATTEMPTS, so it cannot block
+ * the queue; full batches resume once the rejected rows are through.
+ * Any other error (disk full, read-only after failover, lock timeout)
+ * says nothing about the rows and is retried with back-off.
+ */
+class RecordingIngestor {
+private:
+    static constexpr int FLUSH_INTERVAL_MS = 1000;
+    static constexpr int MAX_BACKOFF_SECONDS = 30;
+    static constexpr int MAX_ROW_ATTEMPTS = 3;
+
+    enum class FlushResult {
+        OK,
+        REJECTED,       // Server refused the data (class 22/23)
+        FAILED          // No connection, or an error unrelated to the rows
+    };
+
+    std::shared_ptr<DatabasePool> pool;
+    size_t maxQueuedRows;
+    size_t batchRows;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<RecordingRow> queue;
+    bool stopping;
+
+    std::atomic<uint64_t> rowsEnqueued;
+    std::atomic<uint64_t> rowsInserted;
+    std::atomic<uint64_t> rowsDropped;
+    std::atomic<uint64_t> batchesFailed;
+    std::atomic<uint64_t> rowsRejected;
+    std::atomic<uint64_t> lastBatchMs;
+
+    /**
+     * Data exceptions and integrity violations: one of the rows is bad
+     */
+    static bool isRowError(const std::string& sqlState) {
+        return sqlState.compare(0, 2, "22") == 0 || sqlState.compare(0, 2, "23") == 0;
+    }
+
+    /**
+     * Insert up to limit rows of the head of the queue; rows leave it
+     * only once committed
+     * @param rows Set to the number of rows tried
+     */
+    FlushResult flushBatch(size_t limit, size_t& rows) {
+        std::vector<RecordingRow> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t count = std::min(queue.size(), limit);
+            batch.assign(queue.begin(), queue.begin() + count);
+        }
+        rows = batch.size();
+        if (batch.empty()) return FlushResult::OK;
+
+        auto started = std::chrono::steady_clock::now();
+        DatabasePool::Lease database = pool->acquire();
+        std::string sqlState;
+        int inserted = database ? database->copyRecordings(batch, sqlState) : -1;
+        if (inserted < 0) {
+            batchesFailed++;
+            return isRowError(sqlState) ? FlushResult::REJECTED : FlushResult::FAILED;
+        }
+        lastBatchMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        rowsInserted += (uint64_t)inserted;   // Rows the disk scan added first are not counted
+
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.erase(queue.begin(), queue.begin() + std::min(batch.size(), queue.size()));
+        return FlushResult::OK;
+    }
+
+    /**
+     * The head row was rejected on its own MAX_ROW_ATTEMPTS times
+     */
+    void dropHeadRow() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return;
+        Logger::error("RecordingIngestor: row for " + queue.front().filepath +
+                      " rejected by the database, dropped (left to the disk scan)");
+        queue.pop_front();
+        rowsDropped++;
+        rowsRejected++;
+    }
+
+    void workerLoop() {
+        int backoffSeconds = 1;
+        size_t limit = batchRows;       // Below batchRows while bisecting a rejected batch
+        size_t suspectRows = 0;         // Rows of the rejected batch not yet committed
+        int rowAttempts = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                // Full batch now, or whatever is there after the interval
+                cv.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS),
+                            [this] { return stopping || queue.size() >= batchRows; });
+                if (queue.empty()) {
+                    if (stopping) break;
+                    continue;
+                }
+            }
+
+            size_t rows = 0;
+            FlushResult result = flushBatch(limit, rows);
+            if (result == FlushResult::OK) {
+                backoffSeconds = 1;
+                rowAttempts = 0;
+                suspectRows -= std::min(rows, suspectRows);
+                if (suspectRows == 0) limit = batchRows;   // The rejected rows are through
+                continue;
+            }
+            if (result == FlushResult::REJECTED) {
+                if (suspectRows == 0) suspectRows = rows;
+                if (limit > 1) {
+                    limit = (std::min(limit, getQueuedRows()) + 1) / 2;   // The bad row is in the first half or the next
+                    continue;
+                }
+                if (++rowAttempts >= MAX_ROW_ATTEMPTS) {
+                    dropHeadRow();
+                    limit = batchRows;
+                    suspectRows = 0;
+                    rowAttempts = 0;
+                    continue;
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) break;    // Database down at shutdown: the disk scan catches up
+            Logger::warn("RecordingIngestor: batch insert failed, " + std::to_string(queue.size()) +
+                         " rows queued, retry in " + std::to_string(backoffSeconds) + " s");
+            cv.wait_for(lock, std::chrono::seconds(backoffSeconds), [this] { return stopping; });
+            backoffSeconds = std::min(backoffSeconds * 2, MAX_BACKOFF_SECONDS);
+        }
+
+        size_t left;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            left = queue.size();
+            queue.clear();
+        }
+        if (left > 0) {
+            rowsDropped += left;
+            Logger::warn("RecordingIngestor: " + std::to_string(left) + " rows not written, left to the disk scan");
+        }
+    }
+
+public:
+    RecordingIngestor(std::shared_ptr<DatabasePool> databasePool, size_t maxRows, size_t rowsPerBatch)
+        : pool(std::move(databasePool)), maxQueuedRows(std::max<size_t>(maxRows, 1)),
+          batchRows(std::max<size_t>(rowsPerBatch, 1)), stopping(false), rowsEnqueued(0),
+          rowsInserted(0), rowsDropped(0), batchesFailed(0), rowsRejected(0), lastBatchMs(0) {}
+
+    ~RecordingIngestor() {
+        stop();
+    }
+
+    RecordingIngestor(const RecordingIngestor&) = delete;
+    RecordingIngestor& operator=(const RecordingIngestor&) = delete;
+
+    void start() {
+        if (worker.joinable()) return;
+        Logger::info("Recording ingestor: batches of " + std::to_string(batchRows) + " rows, queue cap " +
+                     std::to_string(maxQueuedRows));
+        worker = std::thread(&RecordingIngestor::workerLoop, this);
+    }
+
+    /**
+     * Queue a row (camera threads, never blocks on the database)
+     * @return false if dropped (queue full or stopping)
+     */
+    bool enqueue(RecordingRow row) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || queue.size() >= maxQueuedRows) {
+                rowsDropped++;
+                return false;
+            }
+            queue.push_back(std::move(row));
+            rowsEnqueued++;
+            if (queue.size() < batchRows) return true;
+        }
+        cv.notify_one();
+        return true;
+    }
+
+    /**
+     * Write what is queued, then stop (call after the recorders stopped)
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    size_t getQueuedRows() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size();
+    }
+
+    uint64_t getRowsInserted() const { return rowsInserted; }
+    uint64_t getRowsDropped() const { return rowsDropped; }
+
+    std::string getSummary() {
+        return std::to_string(rowsInserted.load()) + "/" + std::to_string(rowsEnqueued.load()) + " rows, " +
+               std::to_string(getQueuedRows()) + " queued, " + std::to_string(rowsDropped.load()) + " dropped (" +
+               std::to_string(rowsRejected.load()) + " rejected), " +
+               std::to_string(batchesFailed.load()) + " failed batches, last batch " +
+               std::to_string(lastBatchMs.load()) + " ms";
+    }
+};
+
+#endif // RECORDING_INGESTOR_HPP
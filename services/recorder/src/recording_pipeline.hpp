@@ -0,0 +1,269 @@
+#ifndef RECORDING_PIPELINE_HPP
+#define RECORDING_PIPELINE_HPP
+
+#include <string>
+#include <chrono>
+#include <functional>
+#include "encoder_detector.hpp"
+#include "stream_analyzer.hpp"
+#include "segment_file.hpp"
+#include "logger.hpp"
+
+/**
+ * Pipeline backends
+ *
+ * - LIBAV: in-process demux/encode/mux inside vms-recorder (default)
+ * - FFMPEG_CLI: fork/exec of the ffmpeg binary (fallback)
+ */
+enum class PipelineBackend {
+    LIBAV,
+    FFMPEG_CLI
+};
+
+/**
+ * Parse RECORDER_PIPELINE value ("libav" or "ffmpeg")
+ */
+inline PipelineBackend parsePipelineBackend(const std::string& value) {
+    if (value == "ffmpeg" || value == "ffmpeg_cli" || value == "cli") {
+        return PipelineBackend::FFMPEG_CLI;
+    }
+    return PipelineBackend::LIBAV;
+}
+
+/**
+ * Recording modes (cameras.recording_mode)
+ *
+ * - AUTO: passthrough when the camera sends H.264/H.265, transcode otherwise
+ * - PASSTHROUGH: remux camera packets into the MP4 segments (no decode/encode)
+ * - TRANSCODE: always re-encode (hevc_nvenc / h264_vaapi)
+ */
+enum class RecordingMode {
+    AUTO,
+    PASSTHROUGH,
+    TRANSCODE
+};
+
+/**
+ * Parse cameras.recording_mode value
+ */
+inline RecordingMode parseRecordingMode(const std::string& value) {
+    if (value == "passthrough" || value == "copy") {
+        return RecordingMode::PASSTHROUGH;
+    }
+    if (value == "transcode") {
+        return RecordingMode::TRANSCODE;
+    }
+    return RecordingMode::AUTO;
+}
+
+inline std::string getRecordingModeName(RecordingMode mode) {
+    switch (mode) {
+        case RecordingMode::PASSTHROUGH:
+            return "passthrough";
+        case RecordingMode::TRANSCODE:
+            return "transcode";
+        default:
+            return "auto";
+    }
+}
+
+/**
+ * When the recording output writes (cameras.recording_trigger)
+ *
+ * - CONTINUOUS: always, in 180 s segments
+ * - EVENT: around events only (events table / API), with pre-roll
+ * - MOTION: EVENT plus the packet-size motion detector
+ */
+enum class RecordingTrigger {
+    CONTINUOUS,
+    EVENT,
+    MOTION
+};
+
+inline RecordingTrigger parseRecordingTrigger(const std::string& value) {
+    if (value == "event") {
+        return RecordingTrigger::EVENT;
+    }
+    if (value == "motion") {
+        return RecordingTrigger::MOTION;
+    }
+    return RecordingTrigger::CONTINUOUS;
+}
+
+inline std::string getRecordingTriggerName(RecordingTrigger trigger) {
+    switch (trigger) {
+        case RecordingTrigger::EVENT:
+            return "event";
+        case RecordingTrigger::MOTION:
+            return "motion";
+        default:
+            return "continuous";
+    }
+}
+
+/**
+ * Decide whether the recording output can copy the camera codec
+ *
+ * @param mode Configured mode for the camera
+ * @param codec Decoder name from StreamInfo.codec (e.g. "h264", "hevc")
+ * @return true to remux packets, false to re-encode
+ */
+inline bool resolvePassthrough(RecordingMode mode, const std::string& codec) {
+    bool codecSupported = (codec == "h264" || codec == "hevc");
+    if (mode == RecordingMode::TRANSCODE) {
+        return false;
+    }
+    if (mode == RecordingMode::PASSTHROUGH && !codecSupported) {
+        Logger::warn("Passthrough requested but codec '" + codec + "' is not H.264/H.265, transcoding instead");
+    }
+    return codecSupported;
+}
+
+/**
+ * RecordingPipeline - Per-camera recording + live output
+ *
+ * Common interface for the in-process libav pipeline and the
+ * fork/exec ffmpeg fallback, so CameraRecorder can supervise either.
+ */
+class RecordingPipeline {
+public:
+    virtual ~RecordingPipeline() = default;
+
+    /**
+     * Start the pipeline (non-blocking)
+     */
+    virtual bool start() = 0;
+
+    /**
+     * Check if the pipeline is still running
+     */
+    virtual bool checkStatus() = 0;
+
+    /**
+     * Stop the pipeline gracefully
+     */
+    virtual void stop() = 0;
+
+    /**
+     * Batched shutdown, so N pipelines stop in parallel under one deadline:
+     * requestStop() on all, then waitStopped() on all with the same
+     * deadline, then forceStop() on the ones that did not make it.
+     */
+    virtual void requestStop() {}
+    virtual bool waitStopped(std::chrono::steady_clock::time_point deadline) {
+        (void)deadline;
+        stop();
+        return true;
+    }
+    virtual void forceStop() {}
+
+    virtual bool getIsRunning() const = 0;
+
+    /**
+     * Stream is open and media is flowing (past connect/probe)
+     */
+    virtual bool isStreaming() const { return getIsRunning(); }
+
+    /**
+     * fd that becomes readable when the pipeline changes state (stream
+     * opened, exited), for the camera reactor. -1 = no notification,
+     * checkStatus() has to be polled.
+     */
+    virtual int getEventFd() const { return -1; }
+
+    /**
+     * First recording segment has been opened (startup metric)
+     */
+    virtual bool hasRecordedSegment() const { return isStreaming(); }
+
+    /**
+     * Properties of the camera stream, isValid = false until known
+     */
+    virtual StreamAnalyzer::StreamInfo getStreamInfo() const { return StreamAnalyzer::StreamInfo(); }
+
+    /**
+     * Start or extend an event recording (thread-safe, no-op for
+     * continuous recording or backends without event support)
+     */
+    virtual void triggerRecording(const std::string& reason) { (void)reason; }
+
+    /**
+     * Fragment length of MP4 segments, 0 = classic MP4 (call before start())
+     */
+    virtual void setFragmentSeconds(int seconds) { (void)seconds; }
+
+    /**
+     * Preallocation / page-cache handling of segment files (call before
+     * start(); backends writing through another process ignore it)
+     */
+    virtual void setSegmentFileOptions(const SegmentFile::Options& options) { (void)options; }
+
+    using SegmentClosedCallback = std::function<void(const std::string& path, uint64_t sizeBytes)>;
+
+    /**
+     * Report every closed recording file: a segment, or a whole chunk in
+     * chunk mode (call before start())
+     *
+     * @return false if the backend cannot; the caller then has to look
+     *         for new segments on disk
+     */
+    virtual bool setSegmentClosedCallback(SegmentClosedCallback callback) {
+        (void)callback;
+        return false;
+    }
+
+    /**
+     * One recorded segment, with what the recordings table wants to know
+     */
+    struct RecordedSegment {
+        std::string path;
+        uint64_t offset;              // In path; > 0 only in chunk mode
+        std::chrono::system_clock::time_point startTime;
+        double durationSeconds;
+        uint64_t sizeBytes;
+        std::string codec;            // As recorded (differs from the camera when transcoding)
+        int width;
+        int height;
+        double frameRate;
+    };
+
+    using SegmentRecordedCallback = std::function<void(const RecordedSegment& segment)>;
+
+    /**
+     * Report every closed segment, also the ones inside a chunk file
+     * (called on the pipeline thread; call before start())
+     *
+     * @return false if the backend cannot; rows then come from the API
+     *         disk scan only
+     */
+    virtual bool setSegmentRecordedCallback(SegmentRecordedCallback callback) {
+        (void)callback;
+        return false;
+    }
+
+    using DirectoryProvider = std::function<std::string()>;
+
+    /**
+     * Ask for the recording directory at every segment boundary, so a
+     * camera can move to another volume while running (call before
+     * start(); backends without it keep the constructor path until
+     * restarted)
+     */
+    virtual void setDirectoryProvider(DirectoryProvider provider) { (void)provider; }
+
+    /**
+     * Recording bytes written since start, monotonic (0 if unknown)
+     */
+    virtual uint64_t getBytesWritten() const { return 0; }
+
+    virtual EncoderType getEncoderType() const = 0;
+    virtual std::string getEncoderName() const = 0;
+    virtual std::string getBackendName() const = 0;
+
+    /**
+     * Output queue counters (depth, drops, max latency), "" if not applicable
+     */
+    virtual std::string getQueueStats() const { return ""; }
+};
+
+#endif // RECORDING_PIPELINE_HPP
@@ -0,0 +1,97 @@
+#ifndef SEEK_INDEX_HPP
+#define SEEK_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "index_file.hpp"
+
+/**
+ * SeekIndex - Keyframe sidecar of a recording file, written while recording
+ *
+ * Segments restart their timestamps at zero, so wall-clock time is only
+ * in the file name, and finding an IDR means parsing the MP4. The
+ * sidecar <name>.kidx (next to <name>.mp4, or one per <name>.chunk)
+ * maps time to bytes without opening the video:
+ *   8 bytes   magic "VMSKIX01"
+ *   24 bytes  per entry, little endian:
+ *             i64 time (Unix ms), u64 offset, u32 aux, u32 flags
+ *
+ * Entries, in file order:
+ * - INIT: a segment starts at offset (chunk files hold several); its
+ *   ftyp+moov (init segment) is aux bytes, time = segment start
+ * - KEYFRAME: an IDR at time, in the fragment (moof) starting at offset;
+ *   aux = its media time in the segment (ms, what a demuxer sees).
+ *   FRAGMENT_START: it is the first video sample of that fragment
+ *
+ * To play from time T: last KEYFRAME with time <= T, send the segment's
+ * init bytes followed by the file from offset. Fixed-size records, so a
+ * lookup is one read (or a binary search by pread on a large chunk).
+ * Fragmented MP4 only; entries of a fragment are appended once it is
+ * flushed, so they never point past the data on disk.
+ */
+class SeekIndex {
+public:
+    enum Flags : uint32_t {
+        KEYFRAME = 1,
+        FRAGMENT_START = 2,
+        INIT = 4
+    };
+
+    struct Entry {
+        int64_t timeMs;
+        uint64_t offset;
+        uint32_t aux;
+        uint32_t flags;
+    };
+
+    static constexpr size_t ENTRY_BYTES = 24;
+
+private:
+    IndexFile file;
+
+public:
+    /**
+     * Sidecar of a recording file: <name>.mp4|.chunk -> <name>.kidx
+     */
+    static std::string pathFor(const std::string& recordingPath) {
+        size_t dot = recordingPath.rfind('.');
+        size_t slash = recordingPath.rfind('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            return recordingPath + ".kidx";
+        }
+        return recordingPath.substr(0, dot) + ".kidx";
+    }
+
+    /**
+     * Start the index of a new recording file (truncates)
+     */
+    bool create(const std::string& recordingPath) {
+        return file.create(pathFor(recordingPath), "VMSKIX01");
+    }
+
+    /**
+     * Add entries with one write
+     */
+    bool append(const std::vector<Entry>& entries) {
+        if (entries.empty()) return true;
+        std::vector<uint8_t> records(entries.size() * ENTRY_BYTES);
+        uint8_t* record = records.data();
+        for (const auto& entry : entries) {
+            IndexFile::putLittleEndian(record, (uint64_t)entry.timeMs, 8);
+            IndexFile::putLittleEndian(record + 8, entry.offset, 8);
+            IndexFile::putLittleEndian(record + 16, entry.aux, 4);
+            IndexFile::putLittleEndian(record + 20, entry.flags, 4);
+            record += ENTRY_BYTES;
+        }
+        return file.append(records.data(), records.size());
+    }
+
+    void close() {
+        file.close();
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+};
+
+#endif // SEEK_INDEX_HPP
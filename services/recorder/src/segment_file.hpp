@@ -0,0 +1,321 @@
+#ifndef SEGMENT_FILE_HPP
+#define SEGMENT_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "async_writer.hpp"
+#include "logger.hpp"
+
+/**
+ * SegmentFile - Output file of one recording segment
+ *
+ * Plain positioned writes (the muxer seeks back to patch box sizes),
+ * plus two things the default file protocol does not do:
+ * - Preallocation: fallocate(KEEP_SIZE) of the expected segment size at
+ *   open, so concurrent cameras appending small chunks get few large
+ *   extents instead of interleaved small ones; st_size still grows with
+ *   the data (near-live readers see no zero tail). The unused rest is
+ *   released by ftruncate at close.
+ * - Write-behind: every FLUSH_WINDOW_BYTES, writeback of the new window
+ *   is started (sync_file_range WRITE) and the previous window, by then
+ *   on disk, is waited for and dropped from the page cache
+ *   (posix_fadvise DONTNEED). Write-once video stops pushing out the
+ *   Postgres/API working set; dirty memory per camera stays around two
+ *   windows.
+ *
+ * Append mode (chunk files, see ChunkIndex): the segment starts at the
+ * current end of an existing file; positions seen by the muxer are
+ * relative to that base, so the segment's box offsets are its own.
+ *
+ * With an AsyncWriter (Options.writer): appends are copied into a
+ * buffer that ends at the next COALESCE_BYTES boundary of the file and
+ * queued when full; the pipeline thread only waits when the file has
+ * maxInFlightBytes queued. Anything else (the muxer seeking back to
+ * patch a box) first drains the file, then is written in place. flush()
+ * makes everything written so far reach the file (fragment boundaries,
+ * before sidecar entries point at it). Write-behind follows the writes
+ * completed so far (Stream::getCompletedOffset), so classic MP4 without
+ * fragment flushes is written back progressively too.
+ *
+ * Not thread-safe: owned by the recording writer thread.
+ */
+class SegmentFile {
+public:
+    struct Options {
+        bool preallocate;
+        bool dropCache;
+        int chunkSeconds;       // > 0: SegmentWriter packs segments into chunk files of this period
+        std::shared_ptr<AsyncWriter> writer;   // nullptr = blocking pwrite on the calling thread
+        uint64_t maxInFlightBytes;             // Per file, with a writer
+        const std::atomic<bool>* abortFlag;    // Set: stop waiting for the writer (forced stop), nullptr = never
+        Options() : preallocate(true), dropCache(true), chunkSeconds(0), maxInFlightBytes(8ULL * 1024 * 1024),
+                    abortFlag(nullptr) {}
+    };
+
+    static constexpr uint64_t FLUSH_WINDOW_BYTES = 8ULL * 1024 * 1024;
+
+private:
+    int fd;
+    std::string path;
+    Options options;
+    uint64_t base;              // File offset of the segment (append mode)
+    uint64_t position;
+    uint64_t fileSize;          // Highest offset written
+    uint64_t preallocated;
+    uint64_t flushStarted;      // Writeback started for [0, flushStarted)
+    uint64_t dropped;           // Dropped from the cache for [0, dropped)
+
+    // Async writes
+    std::shared_ptr<AsyncWriter::Stream> stream;
+    AsyncWriter::Buffer buffer;
+    uint64_t bufferStart;       // Position of buffer[0]
+    size_t bufferLength;
+    size_t bufferCapacity;      // Up to the next COALESCE_BYTES boundary of the file
+
+    /**
+     * @param written Segment bytes [0, written) are in the file
+     */
+    void writeBehind(uint64_t written) {
+        while (written >= flushStarted + FLUSH_WINDOW_BYTES) {
+            uint64_t windowStart = flushStarted;
+            sync_file_range(fd, (off64_t)(base + windowStart), (off64_t)FLUSH_WINDOW_BYTES, SYNC_FILE_RANGE_WRITE);
+            flushStarted += FLUSH_WINDOW_BYTES;
+
+            // Previous window: wait for its writeback, then drop it
+            if (windowStart > dropped) {
+                sync_file_range(fd, (off64_t)(base + dropped), (off64_t)(windowStart - dropped),
+                                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                                SYNC_FILE_RANGE_WAIT_AFTER);
+                posix_fadvise(fd, (off_t)(base + dropped), (off_t)(windowStart - dropped), POSIX_FADV_DONTNEED);
+                dropped = windowStart;
+            }
+        }
+    }
+
+    /**
+     * Synchronous write at the current position
+     */
+    int writeAt(const uint8_t* data, int size) {
+        int remaining = size;
+        while (remaining > 0) {
+            ssize_t n = pwrite(fd, data, (size_t)remaining, (off_t)(base + position));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -errno;
+            }
+            data += n;
+            remaining -= (int)n;
+            position += (uint64_t)n;
+        }
+        return size;
+    }
+
+    /**
+     * Queue the coalescing buffer (if anything is in it)
+     */
+    int submitBuffer() {
+        if (bufferLength == 0) return 0;
+        size_t length = bufferLength;
+        bufferLength = 0;
+        return options.writer->submit(stream, fd, std::move(buffer), length, base + bufferStart);
+    }
+
+    /**
+     * Append through the coalescing buffer
+     */
+    int writeBuffered(const uint8_t* data, int size) {
+        int remaining = size;
+        while (remaining > 0) {
+            if (bufferLength == 0) {
+                if (!buffer) {
+                    buffer = options.writer->acquireBuffer();
+                    if (!buffer) return -ENOMEM;
+                }
+                bufferStart = position;
+                uint64_t offset = base + position;
+                bufferCapacity = AsyncWriter::COALESCE_BYTES - (size_t)(offset % AsyncWriter::COALESCE_BYTES);
+            }
+            size_t n = std::min((size_t)remaining, bufferCapacity - bufferLength);
+            std::memcpy(buffer.get() + bufferLength, data, n);
+            bufferLength += n;
+            position += n;
+            data += n;
+            remaining -= (int)n;
+            if (bufferLength == bufferCapacity) {
+                int ret = submitBuffer();
+                if (ret < 0) return ret;
+            }
+        }
+        return size;
+    }
+
+public:
+    explicit SegmentFile(const Options& fileOptions = Options())
+        : fd(-1), options(fileOptions), base(0), position(0), fileSize(0), preallocated(0),
+          flushStarted(0), dropped(0), bufferStart(0), bufferLength(0), bufferCapacity(0) {}
+
+    ~SegmentFile() {
+        close();
+    }
+
+    SegmentFile(const SegmentFile&) = delete;
+    SegmentFile& operator=(const SegmentFile&) = delete;
+
+    /**
+     * @param expectedBytes Preallocation size (0 = none)
+     * @param append Start at the end of an existing file instead of truncating
+     * @return 0 or -errno
+     */
+    int open(const std::string& filePath, uint64_t expectedBytes, bool append = false) {
+        close();
+        fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC), 0644);
+        if (fd < 0) return -errno;
+        path = filePath;
+        base = position = fileSize = preallocated = flushStarted = dropped = 0;
+        if (append) {
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                int error = errno;
+                ::close(fd);
+                fd = -1;
+                return -error;
+            }
+            base = (uint64_t)st.st_size;
+        }
+
+        if (options.preallocate && expectedBytes > 0) {
+            if (fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)base, (off_t)expectedBytes) == 0) {
+                preallocated = expectedBytes;
+            } else if (errno == EOPNOTSUPP || errno == ENOSYS) {
+                Logger::debug("SegmentFile: no fallocate on this file system, not preallocating");
+                options.preallocate = false;
+            }
+            // ENOSPC: record without preallocation, eviction will catch up
+        }
+
+        if (options.writer) {
+            stream = options.writer->openStream(fd, path, options.maxInFlightBytes, options.abortFlag);
+        }
+        bufferLength = 0;
+        return 0;
+    }
+
+    /**
+     * Write at the current position
+     *
+     * @return size, or -errno
+     */
+    int write(const uint8_t* data, int size) {
+        if (!stream) {
+            int ret = writeAt(data, size);
+            if (ret < 0) return ret;
+            fileSize = std::max(fileSize, position);
+            if (options.dropCache) {
+                writeBehind(fileSize);
+            }
+            return size;
+        }
+
+        int ret;
+        bool append = bufferLength > 0 ? position == bufferStart + bufferLength : position == fileSize;
+        if (append) {
+            ret = writeBuffered(data, size);
+        } else {
+            // Patch (or gap): earlier writes of this range must land first
+            ret = submitBuffer();
+            if (ret == 0) ret = stream->drain();
+            if (ret == 0) ret = writeAt(data, size);
+        }
+        if (ret < 0) return ret;
+        fileSize = std::max(fileSize, position);
+        if (options.dropCache) {
+            uint64_t completed = stream->getCompletedOffset();
+            if (completed > base) {
+                writeBehind(completed - base);
+            }
+        }
+        return size;
+    }
+
+    /**
+     * Everything written so far is in the file (no-op without a writer)
+     *
+     * @return 0 or -errno of a failed write
+     */
+    int flush() {
+        if (!stream || fd < 0) return 0;
+        int ret = submitBuffer();
+        if (ret == 0) ret = stream->drain();
+        if (ret == 0 && options.dropCache) {
+            writeBehind(fileSize);
+        }
+        return ret;
+    }
+
+    /**
+     * lseek semantics; whence = SEEK_SET/SEEK_CUR/SEEK_END
+     *
+     * @return New position, or -errno
+     */
+    int64_t seek(int64_t offset, int whence) {
+        if (whence != SEEK_SET && whence != SEEK_CUR && whence != SEEK_END) return -EINVAL;
+        int64_t origin = whence == SEEK_CUR ? (int64_t)position : whence == SEEK_END ? (int64_t)fileSize : 0;
+        if (origin + offset < 0) return -EINVAL;
+        position = (uint64_t)(origin + offset);
+        return (int64_t)position;
+    }
+
+    /**
+     * Release unused preallocation, flush and drop what is left cached
+     *
+     * Aborted while writes are still queued: the file is left to the
+     * writer, which closes it after the last one.
+     */
+    void close() {
+        if (fd < 0) return;
+        if (stream) {
+            int ret = submitBuffer();
+            if (ret == 0) ret = stream->drain();
+            if (ret < 0) {
+                Logger::error("SegmentFile: writes to " + path + " failed: " + strerror(-ret));
+            }
+            options.writer->releaseBuffer(std::move(buffer));
+            bufferLength = 0;
+            if (ret == -ECANCELED) {
+                stream->abandon(fd);
+                stream.reset();
+                fd = -1;
+                return;
+            }
+            stream.reset();
+        }
+        if (preallocated > fileSize) {
+            // Truncating to the current size frees the blocks past EOF
+            if (ftruncate(fd, (off_t)(base + fileSize)) != 0) {
+                Logger::warn("SegmentFile: cannot trim " + path + ": " + strerror(errno));
+            }
+        }
+        if (options.dropCache && fileSize > dropped) {
+            sync_file_range(fd, (off64_t)(base + dropped), 0,
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            posix_fadvise(fd, (off_t)(base + dropped), 0, POSIX_FADV_DONTNEED);
+        }
+        ::close(fd);
+        fd = -1;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+    uint64_t getSize() const { return fileSize; }
+    uint64_t getBase() const { return base; }
+    uint64_t getPreallocated() const { return preallocated; }
+};
+
+#endif // SEGMENT_FILE_HPP
@@ -0,0 +1,412 @@
+#ifndef SEGMENT_INDEX_HPP
+#define SEGMENT_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <queue>
+#include <mutex>
+#include <ctime>
+#include <cstdint>
+#include <cerrno>
+#include <iterator>
+#include <cstring>
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "chunk_index.hpp"
+#include "seek_index.hpp"
+#include "logger.hpp"
+
+/**
+ * SegmentIndex - Closed recording segments per camera, oldest first
+ *
+ * Replaces directory walks in StorageManager: one scan at startup
+ * (readdir + fstatat, one stat per file), then segments are added as
+ * they close. Retention and eviction pop from the oldest end, so their
+ * cost is O(segments removed), not O(segments on disk).
+ *
+ * Order is by modification time (= segment end), the same key the
+ * directory-walking cleanup used. Segments still being written are
+ * never in the index. In chunk mode an entry is a whole chunk file
+ * (added when the chunk is finished), so retention and eviction drop
+ * chunks, never single segments out of one.
+ */
+class SegmentIndex {
+public:
+    struct Segment {
+        std::string path;
+        std::time_t mtime;
+        uint64_t size;
+    };
+
+private:
+    struct CameraSegments {
+        std::deque<Segment> segments;   // Ascending mtime
+        uint64_t bytes = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, CameraSegments> cameras;   // Camera directory -> segments
+    uint64_t totalBytes;
+    size_t totalSegments;
+
+    static bool isSegmentName(const char* name) {
+        size_t length = std::strlen(name);
+        if (length == 0 || name[0] == '.') return false;
+        return (length > 4 && std::strcmp(name + length - 4, ".mp4") == 0) ||
+               (length > 6 && std::strcmp(name + length - 6, ".chunk") == 0);
+    }
+
+    /**
+     * Segments of one directory, sorted (caller holds no lock)
+     *
+     * @param newerThan Only names sorting after this one ("" = all)
+     * @param skipNewest Leave out the newest name (still being written)
+     */
+    static std::vector<Segment> scanDirectory(const std::string& dir, const std::string& newerThan,
+                                              bool skipNewest) {
+        std::vector<Segment> found;
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) return found;
+
+        std::vector<std::string> names;
+        int dirFd = dirfd(handle);
+        while (dirent* entry = readdir(handle)) {
+            if (entry->d_type != DT_REG && entry->d_type != DT_UNKNOWN) continue;
+            if (!isSegmentName(entry->d_name)) continue;
+            if (!newerThan.empty() && std::strcmp(entry->d_name, newerThan.c_str()) <= 0) continue;
+            names.push_back(entry->d_name);
+        }
+
+        // <camera>_YYYYMMDD_HHMMSS.mp4: name order = recording order
+        std::sort(names.begin(), names.end());
+        if (skipNewest && !names.empty()) {
+            names.pop_back();
+        }
+
+        found.reserve(names.size());
+        for (const auto& name : names) {
+            struct stat st;
+            if (fstatat(dirFd, name.c_str(), &st, 0) != 0 || !S_ISREG(st.st_mode)) continue;
+            found.push_back({dir + "/" + name, st.st_mtime, (uint64_t)st.st_size});
+        }
+        closedir(handle);
+
+        std::stable_sort(found.begin(), found.end(), [](const Segment& a, const Segment& b) {
+            return a.mtime < b.mtime;
+        });
+        return found;
+    }
+
+    void insertLocked(CameraSegments& camera, const Segment& segment) {
+        // Closes arrive in order; search from the back for the rare exception
+        auto position = camera.segments.end();
+        while (position != camera.segments.begin() && std::prev(position)->mtime > segment.mtime) {
+            --position;
+        }
+        camera.segments.insert(position, segment);
+        camera.bytes += segment.size;
+        totalBytes += segment.size;
+        totalSegments++;
+    }
+
+    void popFrontLocked(CameraSegments& camera, std::vector<Segment>& out) {
+        Segment& oldest = camera.segments.front();
+        camera.bytes -= oldest.size;
+        totalBytes -= oldest.size;
+        totalSegments--;
+        out.push_back(std::move(oldest));
+        camera.segments.pop_front();
+    }
+
+    /**
+     * Oldest first across cameras until bytes are popped
+     *
+     * @param cutoff Stop at the first segment not older than this (0 = none)
+     * @param maxSegments Stop after this many (0 = no limit)
+     */
+    std::vector<Segment> popOldestLocked(uint64_t bytes, std::time_t cutoff, size_t maxSegments) {
+        std::vector<Segment> removed;
+
+        // Min-heap over the oldest segment of every camera
+        using Front = std::pair<std::time_t, CameraSegments*>;
+        auto newer = [](const Front& a, const Front& b) { return a.first > b.first; };
+        std::priority_queue<Front, std::vector<Front>, decltype(newer)> fronts(newer);
+        for (auto& item : cameras) {
+            if (!item.second.segments.empty()) {
+                fronts.push({item.second.segments.front().mtime, &item.second});
+            }
+        }
+
+        uint64_t popped = 0;
+        while (popped < bytes && !fronts.empty()) {
+            if (cutoff > 0 && fronts.top().first >= cutoff) break;
+            if (maxSegments > 0 && removed.size() >= maxSegments) break;
+            CameraSegments* camera = fronts.top().second;
+            fronts.pop();
+            popped += camera->segments.front().size;
+            popFrontLocked(*camera, removed);
+            if (!camera->segments.empty()) {
+                fronts.push({camera->segments.front().mtime, camera});
+            }
+        }
+        return removed;
+    }
+
+    static std::string fileName(const std::string& path) {
+        size_t slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+public:
+    SegmentIndex() : totalBytes(0), totalSegments(0) {}
+
+    /**
+     * Sidecar files of a segment or chunk (may not exist); they are
+     * moved and deleted together with it
+     */
+    static std::vector<std::string> sidecarsOf(const std::string& path) {
+        std::vector<std::string> sidecars;
+        if (ChunkIndex::isChunkPath(path)) {
+            sidecars.push_back(ChunkIndex::pathFor(path));
+        }
+        sidecars.push_back(SeekIndex::pathFor(path));
+        return sidecars;
+    }
+
+    SegmentIndex(const SegmentIndex&) = delete;
+    SegmentIndex& operator=(const SegmentIndex&) = delete;
+
+    /**
+     * Index every camera directory under root (startup)
+     *
+     * @return Number of segments indexed
+     */
+    size_t rebuild(const std::string& root) {
+        std::map<std::string, CameraSegments> scanned;
+        uint64_t bytes = 0;
+        size_t count = 0;
+
+        DIR* handle = opendir(root.c_str());
+        if (!handle) {
+            Logger::warn("SegmentIndex: cannot open " + root + ": " + strerror(errno));
+            return 0;
+        }
+        std::vector<std::string> dirs;
+        while (dirent* entry = readdir(handle)) {
+            if (entry->d_name[0] == '.') continue;
+            if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+            dirs.push_back(root + "/" + entry->d_name);
+        }
+        closedir(handle);
+
+        for (const auto& dir : dirs) {
+            std::vector<Segment> found = scanDirectory(dir, "", false);
+            if (found.empty()) continue;
+            CameraSegments& camera = scanned[dir];
+            for (auto& segment : found) {
+                camera.bytes += segment.size;
+                camera.segments.push_back(std::move(segment));
+            }
+            bytes += camera.bytes;
+            count += camera.segments.size();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        cameras = std::move(scanned);
+        totalBytes = bytes;
+        totalSegments = count;
+        return count;
+    }
+
+    /**
+     * A segment was closed by a recorder
+     */
+    void add(const std::string& cameraDir, const std::string& path, uint64_t size,
+             std::time_t mtime = std::time(nullptr)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        insertLocked(cameras[cameraDir], {path, mtime, size});
+    }
+
+    /**
+     * Put segments back (eviction stopped before deleting them)
+     */
+    void restore(std::vector<Segment>&& segments) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& segment : segments) {
+            size_t slash = segment.path.rfind('/');
+            std::string cameraDir = slash == std::string::npos ? "" : segment.path.substr(0, slash);
+            insertLocked(cameras[cameraDir], segment);
+        }
+    }
+
+    /**
+     * Pick up segments closed by a writer that does not report them
+     * (ffmpeg CLI): stats only names newer than the newest indexed one,
+     * and leaves out the newest file, which is still being written
+     *
+     * @return Number of segments added
+     */
+    size_t syncCamera(const std::string& cameraDir) {
+        std::string newest;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = cameras.find(cameraDir);
+            if (it != cameras.end() && !it->second.segments.empty()) {
+                newest = fileName(it->second.segments.back().path);
+            }
+        }
+
+        std::vector<Segment> found = scanDirectory(cameraDir, newest, true);
+        if (found.empty()) return 0;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        CameraSegments& camera = cameras[cameraDir];
+        for (const auto& segment : found) {
+            insertLocked(camera, segment);
+        }
+        return found.size();
+    }
+
+    /**
+     * Remove and return every segment last written before cutoff
+     */
+    std::vector<Segment> popOlderThan(std::time_t cutoff) {
+        return popOlderThan(cutoff, std::map<std::string, std::time_t>());
+    }
+
+    /**
+     * Same with per camera cutoffs (camera directory -> cutoff); cameras
+     * not listed use cutoff, 0 = keep
+     */
+    std::vector<Segment> popOlderThan(std::time_t cutoff, const std::map<std::string, std::time_t>& cameraCutoffs) {
+        std::vector<Segment> removed;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& item : cameras) {
+            auto own = cameraCutoffs.find(item.first);
+            std::time_t cameraCutoff = own != cameraCutoffs.end() ? own->second : cutoff;
+            CameraSegments& camera = item.second;
+            while (!camera.segments.empty() && camera.segments.front().mtime < cameraCutoff) {
+                popFrontLocked(camera, removed);
+            }
+        }
+        return removed;
+    }
+
+    /**
+     * Remove and return the oldest segments of one camera until they add
+     * up to at least bytes (quota overage)
+     *
+     * @param maxSegments Stop after this many (0 = no limit)
+     */
+    std::vector<Segment> popCameraOldest(const std::string& cameraDir, uint64_t bytes, size_t maxSegments) {
+        std::vector<Segment> removed;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cameras.find(cameraDir);
+        if (it == cameras.end()) return removed;
+
+        uint64_t popped = 0;
+        while (popped < bytes && !it->second.segments.empty() &&
+               (maxSegments == 0 || removed.size() < maxSegments)) {
+            popped += it->second.segments.front().size;
+            popFrontLocked(it->second, removed);
+        }
+        return removed;
+    }
+
+    /**
+     * Weighted fair share: repeatedly take the oldest segment of the
+     * camera holding the most bytes per unit of weight, until bytes
+     *
+     * A high-bitrate camera is cut back to its share before the history
+     * of the others is touched.
+     *
+     * @param weights Camera directory -> weight; others get defaultWeight
+     * @param maxSegments Stop after this many (0 = no limit)
+     */
+    std::vector<Segment> popFairShare(uint64_t bytes, const std::map<std::string, double>& weights,
+                                      double defaultWeight, size_t maxSegments) {
+        std::vector<Segment> removed;
+        std::lock_guard<std::mutex> lock(mutex);
+
+        struct Share {
+            double bytesPerWeight;
+            double weight;
+            CameraSegments* camera;
+        };
+        auto smaller = [](const Share& a, const Share& b) { return a.bytesPerWeight < b.bytesPerWeight; };
+        std::priority_queue<Share, std::vector<Share>, decltype(smaller)> shares(smaller);
+        for (auto& item : cameras) {
+            if (item.second.segments.empty()) continue;
+            auto own = weights.find(item.first);
+            double weight = own != weights.end() && own->second > 0 ? own->second : defaultWeight;
+            shares.push({item.second.bytes / weight, weight, &item.second});
+        }
+
+        uint64_t popped = 0;
+        while (popped < bytes && !shares.empty() && (maxSegments == 0 || removed.size() < maxSegments)) {
+            Share top = shares.top();
+            shares.pop();
+            popped += top.camera->segments.front().size;
+            popFrontLocked(*top.camera, removed);
+            if (!top.camera->segments.empty()) {
+                shares.push({top.camera->bytes / top.weight, top.weight, top.camera});
+            }
+        }
+        return removed;
+    }
+
+    /**
+     * Remove and return the globally oldest segments until they add up
+     * to at least bytes (fewer if the index runs out)
+     */
+    std::vector<Segment> popOldest(uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return popOldestLocked(bytes, 0, 0);
+    }
+
+    /**
+     * Remove and return up to maxSegments of the globally oldest
+     * segments last written before cutoff (tier migration batches)
+     */
+    std::vector<Segment> popOldestBefore(std::time_t cutoff, size_t maxSegments) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return popOldestLocked(UINT64_MAX, cutoff, maxSegments);
+    }
+
+    uint64_t getTotalBytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totalBytes;
+    }
+
+    size_t getSegmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totalSegments;
+    }
+
+    uint64_t getCameraBytes(const std::string& cameraDir) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cameras.find(cameraDir);
+        return it == cameras.end() ? 0 : it->second.bytes;
+    }
+
+    /**
+     * Modification time of the oldest indexed segment (0 = empty)
+     */
+    std::time_t getOldestTime() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::time_t oldest = 0;
+        for (const auto& item : cameras) {
+            if (item.second.segments.empty()) continue;
+            std::time_t front = item.second.segments.front().mtime;
+            if (oldest == 0 || front < oldest) oldest = front;
+        }
+        return oldest;
+    }
+};
+
+#endif // SEGMENT_INDEX_HPP
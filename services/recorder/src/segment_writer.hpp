@@ -0,0 +1,615 @@
+#ifndef SEGMENT_WRITER_HPP
+#define SEGMENT_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "libav_common.hpp"
+#include "segment_file.hpp"
+#include "chunk_index.hpp"
+#include "seek_index.hpp"
+#include "logger.hpp"
+
+/**
+ * SegmentWriter - Time-based MP4 segmenter for the in-process pipeline
+ *
+ * Equivalent of `-f segment -segment_time 180 -segment_format mp4
+ * -strftime 1 -reset_timestamps 1` in the ffmpeg CLI:
+ * - A new file is opened on the first video keyframe after segmentSeconds
+ * - File name: <camera>_%Y%m%d_%H%M%S.mp4 (local time at segment start)
+ * - Timestamps restart at zero in every segment
+ *
+ * Fragmented MP4 (fragmentSeconds > 0, the default): the moov box is
+ * written up front (empty_moov) and media follows as moof+mdat pairs,
+ * cut every fragmentSeconds of video and flushed to the file right
+ * away. The segment being written is playable up to its last fragment
+ * (near-live playback from the API) and a crash loses at most one
+ * fragment instead of the whole segment. Cost per fragment: one moof
+ * (a few hundred bytes) and one write() of the buffered data.
+ * fragmentSeconds = 0 writes classic MP4 (moov at close).
+ *
+ * Files are written through SegmentFile (custom AVIO): preallocated
+ * from the measured bitrate of the previous segments x segment length,
+ * trimmed at close, and dropped from the page cache as they go.
+ *
+ * Chunk mode (fileOptions.chunkSeconds > 0): segments are appended to
+ * <camera>_YYYYMMDD_HHMMSS.chunk and listed in its ChunkIndex sidecar
+ * (<name>.idx). A new chunk starts whenever a segment starts in another
+ * chunk period (local time, e.g. every hour) or the writer is recreated,
+ * so there is usually one file per camera and period, a new one after a
+ * reconnect, each with its .idx and (fragmented MP4) .kidx sidecars,
+ * instead of one file per segment.
+ *
+ * Fragmented MP4 also gets a SeekIndex sidecar (<name>.kidx, per
+ * segment file or per chunk): segment starts with their init size, and
+ * every IDR with its wall-clock time and the offset of its fragment,
+ * appended as each fragment is flushed.
+ *
+ * Packets are passed in with timestamps in the time base given to addStream().
+ */
+class SegmentWriter {
+public:
+    struct SegmentInfo {
+        std::string path;
+        std::chrono::system_clock::time_point startTime;
+        double durationSeconds;
+        uint64_t sizeBytes;
+        uint64_t offset;          // In path; > 0 only in chunk mode
+        std::string codec;        // Recorded video codec ("h264", "hevc")
+        int width;
+        int height;
+    };
+
+    using SegmentClosedCallback = std::function<void(const SegmentInfo&)>;
+    using SegmentOpenedCallback = std::function<void(const std::string&)>;
+    using FileClosedCallback = std::function<void(const std::string& path, uint64_t sizeBytes)>;
+    using DirectoryProvider = std::function<std::string()>;
+
+private:
+    static constexpr int AVIO_BUFFER_BYTES = 256 * 1024;
+    static constexpr int64_t DEFAULT_BITRATE = 4000000;            // Until the stream says otherwise
+    static constexpr double PREALLOCATE_HEADROOM = 1.1;
+    static constexpr uint64_t MAX_PREALLOCATE_BYTES = 1024ULL * 1024 * 1024;
+
+#if LIBAVFORMAT_VERSION_MAJOR < 61
+    using AvioBuffer = uint8_t*;          // FFmpeg 6.x write_packet signature
+#else
+    using AvioBuffer = const uint8_t*;
+#endif
+
+    struct OutputStream {
+        AVCodecParameters* codecpar;  // Owned copy
+        AVRational sourceTimeBase;
+        int64_t startOffset;          // Segment start in sourceTimeBase
+    };
+
+    std::string cameraName;
+    std::string recordingPath;
+    int segmentSeconds;
+    int fragmentSeconds;       // 0 = classic MP4
+
+    std::vector<OutputStream> streams;
+    int videoStream;
+
+    AVFormatContext* outputCtx;
+    std::string currentPath;
+    std::chrono::system_clock::time_point currentStartTime;
+    std::chrono::system_clock::time_point nextStartTime;   // Backdated start (pre-roll), epoch = now
+    int64_t segmentStartPts;   // Video source time base
+    int64_t fragmentStartPts;
+    int64_t lastVideoPts;
+    uint64_t totalBytesWritten;
+    std::atomic<uint64_t> packetBytes;   // Media handed to the muxer, read by other threads
+    int segmentCount;
+    uint64_t fragmentCount;
+
+    SegmentClosedCallback onSegmentClosed;
+    SegmentOpenedCallback onSegmentOpened;
+    FileClosedCallback onFileClosed;
+    DirectoryProvider directoryProvider;   // Volume placement, asked at every segment boundary
+
+    SegmentFile file;
+    double bytesPerSecond;     // Measured on closed segments, 0 = none yet
+
+    // Chunk mode
+    int chunkSeconds;          // 0 = one file per segment
+    std::string chunkPath;     // "" = no chunk open
+    int64_t chunkPeriod;
+    ChunkIndex chunkIndex;
+
+    // Keyframe sidecar (fragmented MP4)
+    SeekIndex seekIndex;
+    std::vector<SeekIndex::Entry> pendingKeyframes;   // In the fragment being buffered
+    uint64_t fragmentOffset;                          // Where that fragment starts (in the segment)
+
+    static int64_t toUnixMs(std::chrono::system_clock::time_point when) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(when.time_since_epoch()).count();
+    }
+
+    static int writeFile(void* opaque, AvioBuffer buffer, int size) {
+        return static_cast<SegmentFile*>(opaque)->write(buffer, size);
+    }
+
+    static int64_t seekFile(void* opaque, int64_t offset, int whence) {
+        SegmentFile* segmentFile = static_cast<SegmentFile*>(opaque);
+        if (whence & AVSEEK_SIZE) {
+            return (int64_t)segmentFile->getSize();
+        }
+        return segmentFile->seek(offset, whence & ~AVSEEK_FORCE);
+    }
+
+    /**
+     * Preallocation size: bitrate x segment length, with some headroom
+     */
+    uint64_t expectedSegmentBytes() const {
+        double rate = bytesPerSecond;
+        if (rate <= 0) {
+            int64_t bitrate = 0;
+            for (const auto& stream : streams) {
+                bitrate += stream.codecpar->bit_rate;
+            }
+            rate = (bitrate > 0 ? bitrate : DEFAULT_BITRATE) / 8.0;
+        }
+        return std::min((uint64_t)(rate * segmentSeconds * PREALLOCATE_HEADROOM), MAX_PREALLOCATE_BYTES);
+    }
+
+    /**
+     * Free the custom AVIO context and close the file
+     */
+    void releaseOutput() {
+        if (outputCtx->pb) {
+            av_freep(&outputCtx->pb->buffer);
+            avio_context_free(&outputCtx->pb);
+        }
+        file.close();
+    }
+
+    std::string buildPath(std::chrono::system_clock::time_point when, const char* extension) const {
+        std::string safeName = cameraName;
+        std::replace(safeName.begin(), safeName.end(), ' ', '_');
+
+        std::time_t t = std::chrono::system_clock::to_time_t(when);
+        std::tm tm = *std::localtime(&t);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+
+        return recordingPath + "/" + safeName + "_" + stamp + extension;
+    }
+
+    /**
+     * Chunk period of a wall-clock time (local time, so daily chunks
+     * start at midnight)
+     */
+    int64_t chunkPeriodOf(std::chrono::system_clock::time_point when) const {
+        std::time_t t = std::chrono::system_clock::to_time_t(when);
+        std::tm tm = *std::localtime(&t);
+        return ((int64_t)t + tm.tm_gmtoff) / chunkSeconds;
+    }
+
+    /**
+     * Start a new chunk file with its index
+     */
+    bool openChunk(std::chrono::system_clock::time_point when) {
+        closeChunk();
+        std::string path = buildPath(when, ".chunk");
+        if (!chunkIndex.create(path)) {
+            return false;
+        }
+        chunkPath = path;
+        chunkPeriod = chunkPeriodOf(when);
+        if (fragmentSeconds > 0) {
+            seekIndex.create(chunkPath);
+        }
+        Logger::debug("SegmentWriter: new chunk " + chunkPath);
+        return true;
+    }
+
+    /**
+     * Finish the current chunk; it is complete on disk from here on
+     */
+    void closeChunk() {
+        if (chunkPath.empty()) return;
+        uint64_t segments = chunkIndex.getEntryCount();
+        chunkIndex.close();
+        seekIndex.close();
+
+        struct stat st;
+        uint64_t size = stat(chunkPath.c_str(), &st) == 0 ? (uint64_t)st.st_size : 0;
+        if (segments == 0) {
+            // Nothing playable in it (first segment failed)
+            unlink(chunkPath.c_str());
+            unlink(ChunkIndex::pathFor(chunkPath).c_str());
+            unlink(SeekIndex::pathFor(chunkPath).c_str());
+        } else {
+            Logger::debug("SegmentWriter: closed chunk " + chunkPath + " (" + std::to_string(segments) +
+                          " segments, " + std::to_string(size / (1024 * 1024)) + " MB)");
+            if (onFileClosed) {
+                onFileClosed(chunkPath, size);
+            }
+        }
+        chunkPath.clear();
+    }
+
+    bool openSegment(int64_t startPts) {
+        currentStartTime = nextStartTime.time_since_epoch().count() != 0 ? nextStartTime
+                                                                         : std::chrono::system_clock::now();
+        nextStartTime = std::chrono::system_clock::time_point();
+        if (directoryProvider) {
+            std::string directory = directoryProvider();
+            if (!directory.empty() && directory != recordingPath) {
+                recordingPath = directory;
+                closeChunk();   // A chunk stays on one volume
+            }
+        }
+        if (chunkSeconds > 0) {
+            if ((chunkPath.empty() || chunkPeriodOf(currentStartTime) != chunkPeriod) &&
+                !openChunk(currentStartTime)) {
+                return false;
+            }
+            currentPath = chunkPath;
+        } else {
+            currentPath = buildPath(currentStartTime, ".mp4");
+        }
+
+        int ret = avformat_alloc_output_context2(&outputCtx, nullptr, "mp4", currentPath.c_str());
+        if (ret < 0 || !outputCtx) {
+            Logger::error("SegmentWriter: cannot create muxer for " + currentPath + ": " + avErrorString(ret));
+            outputCtx = nullptr;
+            return false;
+        }
+
+        for (auto& stream : streams) {
+            AVStream* out = avformat_new_stream(outputCtx, nullptr);
+            if (!out) {
+                Logger::error("SegmentWriter: cannot add stream for " + cameraName);
+                abortSegment();
+                return false;
+            }
+            avcodec_parameters_copy(out->codecpar, stream.codecpar);
+            out->codecpar->codec_tag = 0;
+            out->time_base = stream.sourceTimeBase;
+
+            stream.startOffset = av_rescale_q(startPts,
+                                              streams[videoStream].sourceTimeBase,
+                                              stream.sourceTimeBase);
+        }
+
+        ret = file.open(currentPath, expectedSegmentBytes(), chunkSeconds > 0);
+        if (ret < 0) {
+            Logger::error("SegmentWriter: cannot open " + currentPath + ": " + strerror(-ret));
+            abortSegment();
+            return false;
+        }
+        unsigned char* buffer = static_cast<unsigned char*>(av_malloc(AVIO_BUFFER_BYTES));
+        outputCtx->pb = buffer ? avio_alloc_context(buffer, AVIO_BUFFER_BYTES, 1, &file, nullptr,
+                                                    &SegmentWriter::writeFile, &SegmentWriter::seekFile)
+                               : nullptr;
+        if (!outputCtx->pb) {
+            av_free(buffer);
+            Logger::error("SegmentWriter: cannot allocate I/O context for " + currentPath);
+            abortSegment();
+            return false;
+        }
+        outputCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+        AVDictionary* options = nullptr;
+        if (fragmentSeconds > 0) {
+            // Fragments are cut by cutFragment(), not by the muxer
+            av_dict_set(&options, "movflags", "+empty_moov+default_base_moof+frag_custom", 0);
+        }
+        ret = avformat_write_header(outputCtx, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            Logger::error("SegmentWriter: cannot write header for " + currentPath + ": " + avErrorString(ret));
+            abortSegment();
+            return false;
+        }
+
+        segmentStartPts = startPts;
+        fragmentStartPts = startPts;
+        lastVideoPts = startPts;
+        segmentCount++;
+
+        if (fragmentSeconds > 0) {
+            // empty_moov: the init segment is complete after the header
+            avio_flush(outputCtx->pb);
+            file.flush();
+            fragmentOffset = file.getSize();
+            if (chunkSeconds == 0) {
+                seekIndex.create(currentPath);
+            }
+            seekIndex.append({{toUnixMs(currentStartTime), file.getBase(), (uint32_t)fragmentOffset,
+                               SeekIndex::INIT}});
+        }
+        Logger::debug("SegmentWriter: opened " + currentPath);
+
+        if (onSegmentOpened) {
+            onSegmentOpened(currentPath);
+        }
+        return true;
+    }
+
+    /**
+     * An IDR goes into the fragment being buffered (offset known at flush)
+     */
+    void noteKeyframe(int64_t pts) {
+        if (fragmentSeconds <= 0) return;
+        int64_t mediaMs = (int64_t)((pts - segmentStartPts) * av_q2d(streams[videoStream].sourceTimeBase) * 1000);
+        uint32_t flags = SeekIndex::KEYFRAME | (pts == fragmentStartPts ? (uint32_t)SeekIndex::FRAGMENT_START : 0u);
+        pendingKeyframes.push_back({toUnixMs(currentStartTime) + mediaMs, 0, (uint32_t)std::max<int64_t>(mediaMs, 0),
+                                    flags});
+    }
+
+    /**
+     * The buffered fragment is on disk: its keyframes go to the sidecar
+     */
+    void flushKeyframes() {
+        for (auto& entry : pendingKeyframes) {
+            entry.offset = file.getBase() + fragmentOffset;
+        }
+        seekIndex.append(pendingKeyframes);
+        pendingKeyframes.clear();
+        fragmentOffset = file.getSize();
+    }
+
+    /**
+     * Emit the buffered samples as one moof+mdat and push them to the file
+     */
+    bool cutFragment() {
+        int ret = av_interleaved_write_frame(outputCtx, nullptr);   // Drain the interleaving queue
+        if (ret >= 0) {
+            ret = av_write_frame(outputCtx, nullptr);
+        }
+        if (ret < 0) {
+            Logger::error("SegmentWriter: fragment flush failed for " + currentPath + ": " + avErrorString(ret));
+            return false;
+        }
+        avio_flush(outputCtx->pb);
+        ret = file.flush();   // Fragment in the file before its keyframes are indexed
+        if (ret < 0) {
+            Logger::error("SegmentWriter: write failed for " + currentPath + ": " + strerror(-ret));
+            return false;
+        }
+        flushKeyframes();
+        fragmentCount++;
+        return true;
+    }
+
+    void abortSegment() {
+        if (!outputCtx) return;
+        pendingKeyframes.clear();
+        if (chunkSeconds == 0) {
+            seekIndex.close();
+        }
+        releaseOutput();
+        avformat_free_context(outputCtx);
+        outputCtx = nullptr;
+    }
+
+    void closeSegment() {
+        if (!outputCtx) return;
+
+        av_write_trailer(outputCtx);
+        avio_flush(outputCtx->pb);
+        file.flush();
+        if (fragmentSeconds > 0) {
+            flushKeyframes();   // Last fragment, written by the trailer
+            if (chunkSeconds == 0) {
+                seekIndex.close();
+            }
+        }
+        uint64_t size = file.getSize();
+        uint64_t offset = file.getBase();
+        releaseOutput();
+        avformat_free_context(outputCtx);
+        outputCtx = nullptr;
+
+        SegmentInfo info;
+        info.path = currentPath;
+        info.startTime = currentStartTime;
+        info.durationSeconds = (lastVideoPts - segmentStartPts) * av_q2d(streams[videoStream].sourceTimeBase);
+        info.sizeBytes = size;
+        info.offset = offset;
+        const AVCodecParameters* video = streams[videoStream].codecpar;
+        info.codec = avcodec_get_name(video->codec_id);
+        info.width = video->width;
+        info.height = video->height;
+        totalBytesWritten += size;
+        if (info.durationSeconds >= 1) {
+            double rate = size / info.durationSeconds;
+            bytesPerSecond = bytesPerSecond > 0 ? (bytesPerSecond + rate) / 2 : rate;
+        }
+
+        Logger::debug("SegmentWriter: closed " + currentPath + " (" +
+                      std::to_string(size / (1024 * 1024)) + " MB at " + std::to_string(offset) + ")");
+
+        if (chunkSeconds > 0) {
+            ChunkIndex::Entry entry;
+            entry.offset = offset;
+            entry.length = size;
+            entry.startMs = toUnixMs(currentStartTime);
+            entry.durationMs = (uint32_t)std::max(info.durationSeconds * 1000, 0.0);
+            entry.flags = 0;
+            chunkIndex.append(entry);
+        } else if (onFileClosed) {
+            onFileClosed(currentPath, size);
+        }
+        if (onSegmentClosed) {
+            onSegmentClosed(info);
+        }
+    }
+
+public:
+    SegmentWriter(const std::string& name, const std::string& path, int segmentDuration = 180,
+                  int fragmentDuration = 2, const SegmentFile::Options& fileOptions = SegmentFile::Options())
+        : cameraName(name), recordingPath(path), segmentSeconds(segmentDuration),
+          fragmentSeconds(std::max(fragmentDuration, 0)), videoStream(-1), outputCtx(nullptr),
+          segmentStartPts(0), fragmentStartPts(0), lastVideoPts(0), totalBytesWritten(0), packetBytes(0),
+          segmentCount(0), fragmentCount(0), file(fileOptions), bytesPerSecond(0),
+          chunkSeconds(std::max(fileOptions.chunkSeconds, 0)), chunkPeriod(0), fragmentOffset(0) {}
+
+    ~SegmentWriter() {
+        close();
+        for (auto& stream : streams) {
+            avcodec_parameters_free(&stream.codecpar);
+        }
+    }
+
+    SegmentWriter(const SegmentWriter&) = delete;
+    SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+    /**
+     * Register an output stream (must happen before the first segment opens)
+     *
+     * @return Stream index to use with writePacket()
+     */
+    int addStream(const AVCodecParameters* codecpar, AVRational timeBase) {
+        OutputStream stream;
+        stream.codecpar = avcodec_parameters_alloc();
+        avcodec_parameters_copy(stream.codecpar, codecpar);
+        stream.sourceTimeBase = timeBase;
+        stream.startOffset = 0;
+        streams.push_back(stream);
+
+        int index = (int)streams.size() - 1;
+        if (videoStream < 0 && codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            videoStream = index;
+        }
+        return index;
+    }
+
+    /**
+     * Write a packet, rotating segments on video keyframes
+     *
+     * Consumes the packet reference. Packets before the first video
+     * keyframe are dropped.
+     */
+    bool writePacket(AVPacket* pkt, int streamIndex) {
+        if (videoStream < 0 || streamIndex < 0 || streamIndex >= (int)streams.size()) {
+            av_packet_unref(pkt);
+            return false;
+        }
+
+        const OutputStream& stream = streams[streamIndex];
+        bool isVideo = (streamIndex == videoStream);
+
+        if (isVideo && pkt->pts != AV_NOPTS_VALUE) {
+            bool isKey = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+            if (isKey) {
+                double elapsed = (pkt->pts - segmentStartPts) * av_q2d(stream.sourceTimeBase);
+                if (!outputCtx || elapsed >= segmentSeconds) {
+                    closeSegment();
+                    if (!openSegment(pkt->pts)) {
+                        av_packet_unref(pkt);
+                        return false;
+                    }
+                }
+            }
+            if (outputCtx && fragmentSeconds > 0 &&
+                (pkt->pts - fragmentStartPts) * av_q2d(stream.sourceTimeBase) >= fragmentSeconds) {
+                if (!cutFragment()) {
+                    av_packet_unref(pkt);
+                    return false;
+                }
+                fragmentStartPts = pkt->pts;
+            }
+            if (outputCtx) {
+                lastVideoPts = std::max(lastVideoPts, pkt->pts);
+                if (isKey) {
+                    noteKeyframe(pkt->pts);
+                }
+            }
+        }
+
+        if (!outputCtx) {
+            av_packet_unref(pkt);
+            return true;  // Waiting for first keyframe
+        }
+
+        // Reset timestamps to segment start
+        if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= stream.startOffset;
+        if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= stream.startOffset;
+        if (!isVideo && pkt->pts != AV_NOPTS_VALUE && pkt->pts < 0) {
+            av_packet_unref(pkt);
+            return true;  // Audio from before the segment start
+        }
+
+        AVStream* out = outputCtx->streams[streamIndex];
+        av_packet_rescale_ts(pkt, stream.sourceTimeBase, out->time_base);
+        pkt->stream_index = streamIndex;
+        pkt->pos = -1;
+
+        int size = pkt->size;
+        int ret = av_interleaved_write_frame(outputCtx, pkt);
+        if (ret < 0) {
+            Logger::error("SegmentWriter: write failed for " + currentPath + ": " + avErrorString(ret));
+            return false;
+        }
+        packetBytes += size;
+        return true;
+    }
+
+    /**
+     * Finish the current segment (and chunk)
+     */
+    void close() {
+        closeSegment();
+        closeChunk();
+    }
+
+    /**
+     * Every closed segment (path = chunk file in chunk mode)
+     */
+    void setSegmentClosedCallback(SegmentClosedCallback callback) {
+        onSegmentClosed = std::move(callback);
+    }
+
+    /**
+     * Every file complete on disk: each segment, or each chunk in chunk mode
+     */
+    void setFileClosedCallback(FileClosedCallback callback) {
+        onFileClosed = std::move(callback);
+    }
+
+    /**
+     * Directory of each new segment (or chunk) instead of the fixed
+     * path; "" keeps the current one
+     */
+    void setDirectoryProvider(DirectoryProvider provider) {
+        directoryProvider = std::move(provider);
+    }
+
+    /**
+     * Wall-clock start of the next segment when its first packets are
+     * older than "now" (pre-roll); names the file and SegmentInfo
+     */
+    void setNextSegmentStartTime(std::chrono::system_clock::time_point when) {
+        nextStartTime = when;
+    }
+
+    void setSegmentOpenedCallback(SegmentOpenedCallback callback) {
+        onSegmentOpened = std::move(callback);
+    }
+
+    bool isFragmented() const { return fragmentSeconds > 0; }
+    uint64_t getFragmentCount() const { return fragmentCount; }
+    bool hasStreams() const { return videoStream >= 0; }
+    bool isSegmentOpen() const { return outputCtx != nullptr; }
+    std::string getCurrentPath() const { return currentPath; }
+    uint64_t getTotalBytesWritten() const { return totalBytesWritten; }
+
+    /**
+     * Bytes written so far, including the open segment (any thread)
+     */
+    uint64_t getPacketBytes() const { return packetBytes; }
+    int getSegmentCount() const { return segmentCount; }
+};
+
+#endif // SEGMENT_WRITER_HPP
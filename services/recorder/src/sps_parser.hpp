@@ -0,0 +1,446 @@
+#ifndef SPS_PARSER_HPP
+#define SPS_PARSER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "libav_common.hpp"
+
+/**
+ * SpsParser - Stream properties straight from an H.264/H.265 SPS
+ *
+ * The sequence parameter set carries everything the recorder needs to
+ * plan a pipeline (resolution, profile/level, chroma format, bit depth,
+ * colour range, VUI frame rate), so there is no need to decode frames
+ * the way avformat_find_stream_info does. The SPS comes from the SDP
+ * sprop-parameter-sets (libavformat puts them in codecpar->extradata)
+ * or from the first in-band SPS NAL of the stream.
+ *
+ * Input is Annex B (start codes) or avcC; anything unparseable returns
+ * false and the caller falls back to the regular probe.
+ */
+class SpsParser {
+public:
+    struct SpsInfo {
+        int profile = 0;            // profile_idc
+        int level = 0;              // level_idc
+        int chromaFormatIdc = 1;    // 0 = mono, 1 = 4:2:0, 2 = 4:2:2, 3 = 4:4:4
+        int bitDepth = 8;
+        int width = 0;
+        int height = 0;
+        bool fullRange = false;     // VUI video_full_range_flag
+        double frameRate = 0;       // VUI timing info, 0 if absent
+    };
+
+private:
+    static constexpr int H264_NAL_SPS = 7;
+    static constexpr int HEVC_NAL_SPS = 33;
+
+    /**
+     * Exp-Golomb bit reader over an RBSP (emulation prevention removed)
+     */
+    class BitReader {
+    private:
+        std::vector<uint8_t> rbsp;
+        size_t bitPos;
+        bool overrun;
+
+    public:
+        BitReader(const uint8_t* nal, size_t size) : bitPos(0), overrun(false) {
+            rbsp.reserve(size);
+            int zeros = 0;
+            for (size_t i = 0; i < size; i++) {
+                if (zeros >= 2 && nal[i] == 0x03) {
+                    zeros = 0;
+                    continue;
+                }
+                zeros = (nal[i] == 0) ? zeros + 1 : 0;
+                rbsp.push_back(nal[i]);
+            }
+        }
+
+        uint32_t bits(int count) {
+            uint32_t value = 0;
+            for (int i = 0; i < count; i++) {
+                if (bitPos >= rbsp.size() * 8) {
+                    overrun = true;
+                    return 0;
+                }
+                value = (value << 1) | ((rbsp[bitPos / 8] >> (7 - bitPos % 8)) & 1);
+                bitPos++;
+            }
+            return value;
+        }
+
+        bool flag() { return bits(1) != 0; }
+
+        void skip(size_t count) {
+            bitPos += count;
+            if (bitPos > rbsp.size() * 8) overrun = true;
+        }
+
+        uint32_t ue() {
+            int leadingZeros = 0;
+            while (!flag()) {
+                if (overrun || ++leadingZeros > 31) {
+                    overrun = true;
+                    return 0;
+                }
+            }
+            return ((1u << leadingZeros) - 1) + bits(leadingZeros);
+        }
+
+        int32_t se() {
+            uint32_t value = ue();
+            return (value & 1) ? (int32_t)((value + 1) / 2) : -(int32_t)(value / 2);
+        }
+
+        bool ok() const { return !overrun; }
+    };
+
+    static void skipH264ScalingList(BitReader& reader, int size) {
+        int last = 8;
+        int next = 8;
+        for (int j = 0; j < size; j++) {
+            if (next != 0) {
+                next = (last + reader.se() + 256) % 256;
+            }
+            last = (next == 0) ? last : next;
+        }
+    }
+
+    static void parseVuiSignal(BitReader& reader, SpsInfo& info) {
+        if (reader.flag()) {                 // aspect_ratio_info_present_flag
+            if (reader.bits(8) == 255) {     // Extended_SAR
+                reader.skip(32);
+            }
+        }
+        if (reader.flag()) {                 // overscan_info_present_flag
+            reader.skip(1);
+        }
+        if (reader.flag()) {                 // video_signal_type_present_flag
+            reader.skip(3);                  // video_format
+            info.fullRange = reader.flag();
+            if (reader.flag()) {             // colour_description_present_flag
+                reader.skip(24);
+            }
+        }
+        if (reader.flag()) {                 // chroma_loc_info_present_flag
+            reader.ue();
+            reader.ue();
+        }
+    }
+
+    static bool parseH264(const uint8_t* nal, size_t size, SpsInfo& info) {
+        BitReader reader(nal + 1, size - 1);
+        info.profile = reader.bits(8);
+        reader.skip(8);                      // constraint flags
+        info.level = reader.bits(8);
+        reader.ue();                         // seq_parameter_set_id
+
+        bool separateColourPlane = false;
+        static const int highProfiles[] = {100, 110, 122, 244, 44, 83, 86, 118, 128, 138, 139, 134, 135};
+        if (std::find(std::begin(highProfiles), std::end(highProfiles), info.profile) != std::end(highProfiles)) {
+            info.chromaFormatIdc = reader.ue();
+            if (info.chromaFormatIdc == 3) {
+                separateColourPlane = reader.flag();
+            }
+            info.bitDepth = reader.ue() + 8;
+            reader.ue();                     // bit_depth_chroma_minus8
+            reader.skip(1);                  // qpprime_y_zero_transform_bypass_flag
+            if (reader.flag()) {             // seq_scaling_matrix_present_flag
+                int lists = (info.chromaFormatIdc != 3) ? 8 : 12;
+                for (int i = 0; i < lists; i++) {
+                    if (reader.flag()) {
+                        skipH264ScalingList(reader, i < 6 ? 16 : 64);
+                    }
+                }
+            }
+        }
+
+        reader.ue();                         // log2_max_frame_num_minus4
+        uint32_t pocType = reader.ue();
+        if (pocType == 0) {
+            reader.ue();                     // log2_max_pic_order_cnt_lsb_minus4
+        } else if (pocType == 1) {
+            reader.skip(1);
+            reader.se();
+            reader.se();
+            uint32_t cycle = reader.ue();
+            for (uint32_t i = 0; i < cycle && reader.ok(); i++) {
+                reader.se();
+            }
+        }
+        reader.ue();                         // max_num_ref_frames
+        reader.skip(1);                      // gaps_in_frame_num_value_allowed_flag
+
+        uint32_t widthMbs = reader.ue() + 1;
+        uint32_t heightMapUnits = reader.ue() + 1;
+        bool frameMbsOnly = reader.flag();
+        if (!frameMbsOnly) {
+            reader.skip(1);                  // mb_adaptive_frame_field_flag
+        }
+        reader.skip(1);                      // direct_8x8_inference_flag
+
+        uint32_t cropLeft = 0, cropRight = 0, cropTop = 0, cropBottom = 0;
+        if (reader.flag()) {
+            cropLeft = reader.ue();
+            cropRight = reader.ue();
+            cropTop = reader.ue();
+            cropBottom = reader.ue();
+        }
+
+        int chromaArrayType = separateColourPlane ? 0 : info.chromaFormatIdc;
+        int cropUnitX = (chromaArrayType == 1 || chromaArrayType == 2) ? 2 : 1;
+        int cropUnitY = ((chromaArrayType == 1) ? 2 : 1) * (frameMbsOnly ? 1 : 2);
+        info.width = (int)(widthMbs * 16 - cropUnitX * (cropLeft + cropRight));
+        info.height = (int)((frameMbsOnly ? 1 : 2) * heightMapUnits * 16 - cropUnitY * (cropTop + cropBottom));
+
+        if (reader.flag()) {                 // vui_parameters_present_flag
+            parseVuiSignal(reader, info);
+            if (reader.flag()) {             // timing_info_present_flag
+                uint32_t unitsInTick = reader.bits(32);
+                uint32_t timeScale = reader.bits(32);
+                if (unitsInTick > 0) {
+                    info.frameRate = timeScale / (2.0 * unitsInTick);
+                }
+            }
+        }
+        return reader.ok();
+    }
+
+    static void skipHevcProfileTierLevel(BitReader& reader, int maxSubLayersMinus1, SpsInfo& info) {
+        reader.skip(3);                      // general_profile_space, general_tier_flag
+        info.profile = reader.bits(5);
+        reader.skip(32 + 48);                // compatibility flags, constraint flags
+        info.level = reader.bits(8);
+
+        std::vector<bool> profilePresent(maxSubLayersMinus1), levelPresent(maxSubLayersMinus1);
+        for (int i = 0; i < maxSubLayersMinus1; i++) {
+            profilePresent[i] = reader.flag();
+            levelPresent[i] = reader.flag();
+        }
+        if (maxSubLayersMinus1 > 0) {
+            reader.skip(2 * (8 - maxSubLayersMinus1));
+        }
+        for (int i = 0; i < maxSubLayersMinus1; i++) {
+            if (profilePresent[i]) reader.skip(88);
+            if (levelPresent[i]) reader.skip(8);
+        }
+    }
+
+    static void skipHevcScalingListData(BitReader& reader) {
+        for (int sizeId = 0; sizeId < 4; sizeId++) {
+            for (int matrixId = 0; matrixId < 6; matrixId += (sizeId == 3) ? 3 : 1) {
+                if (!reader.flag()) {        // scaling_list_pred_mode_flag
+                    reader.ue();
+                    continue;
+                }
+                int coefNum = std::min(64, 1 << (4 + (sizeId << 1)));
+                if (sizeId > 1) {
+                    reader.se();
+                }
+                for (int i = 0; i < coefNum; i++) {
+                    reader.se();
+                }
+            }
+        }
+    }
+
+    static bool parseHevc(const uint8_t* nal, size_t size, SpsInfo& info) {
+        if (size < 3) return false;
+        BitReader reader(nal + 2, size - 2);
+        reader.skip(4);                      // sps_video_parameter_set_id
+        int maxSubLayersMinus1 = reader.bits(3);
+        reader.skip(1);                      // sps_temporal_id_nesting_flag
+        skipHevcProfileTierLevel(reader, maxSubLayersMinus1, info);
+
+        reader.ue();                         // sps_seq_parameter_set_id
+        info.chromaFormatIdc = reader.ue();
+        if (info.chromaFormatIdc == 3) {
+            reader.skip(1);                  // separate_colour_plane_flag
+        }
+        info.width = reader.ue();
+        info.height = reader.ue();
+        if (reader.flag()) {                 // conformance_window_flag
+            int subWidth = (info.chromaFormatIdc == 1 || info.chromaFormatIdc == 2) ? 2 : 1;
+            int subHeight = (info.chromaFormatIdc == 1) ? 2 : 1;
+            uint32_t left = reader.ue(), right = reader.ue(), top = reader.ue(), bottom = reader.ue();
+            info.width -= subWidth * (left + right);
+            info.height -= subHeight * (top + bottom);
+        }
+        info.bitDepth = reader.ue() + 8;
+        reader.ue();                         // bit_depth_chroma_minus8
+        int log2MaxPocLsb = reader.ue() + 4;
+
+        bool orderingInfoPresent = reader.flag();
+        for (int i = orderingInfoPresent ? 0 : maxSubLayersMinus1; i <= maxSubLayersMinus1; i++) {
+            reader.ue();
+            reader.ue();
+            reader.ue();
+        }
+        for (int i = 0; i < 6; i++) {        // luma CB/TB sizes, transform hierarchy depths
+            reader.ue();
+        }
+        if (reader.flag() && reader.flag()) {  // scaling_list_enabled, sps_scaling_list_data_present
+            skipHevcScalingListData(reader);
+        }
+        reader.skip(2);                      // amp_enabled_flag, sample_adaptive_offset_enabled_flag
+        if (reader.flag()) {                 // pcm_enabled_flag
+            reader.skip(8);
+            reader.ue();
+            reader.ue();
+            reader.skip(1);
+        }
+
+        uint32_t numShortTermSets = reader.ue();
+        if (numShortTermSets > 64) return false;
+        std::vector<uint32_t> numDeltaPocs(numShortTermSets, 0);
+        for (uint32_t idx = 0; idx < numShortTermSets && reader.ok(); idx++) {
+            bool interPrediction = idx != 0 && reader.flag();
+            if (interPrediction) {
+                reader.skip(1);              // delta_rps_sign
+                reader.ue();                 // abs_delta_rps_minus1
+                for (uint32_t j = 0; j <= numDeltaPocs[idx - 1]; j++) {
+                    bool used = reader.flag();
+                    bool useDelta = used || reader.flag();
+                    if (useDelta) numDeltaPocs[idx]++;
+                }
+            } else {
+                uint32_t negative = reader.ue();
+                uint32_t positive = reader.ue();
+                if (negative > 16 || positive > 16) return false;
+                for (uint32_t j = 0; j < negative + positive; j++) {
+                    reader.ue();
+                    reader.skip(1);
+                }
+                numDeltaPocs[idx] = negative + positive;
+            }
+        }
+
+        if (reader.flag()) {                 // long_term_ref_pics_present_flag
+            uint32_t count = reader.ue();
+            if (count > 32) return false;
+            for (uint32_t i = 0; i < count; i++) {
+                reader.skip(log2MaxPocLsb + 1);
+            }
+        }
+        reader.skip(2);                      // temporal_mvp, strong_intra_smoothing
+
+        if (reader.flag()) {                 // vui_parameters_present_flag
+            parseVuiSignal(reader, info);
+            reader.skip(3);                  // neutral_chroma, field_seq, frame_field_info
+            if (reader.flag()) {             // default_display_window_flag
+                reader.ue();
+                reader.ue();
+                reader.ue();
+                reader.ue();
+            }
+            if (reader.flag()) {             // vui_timing_info_present_flag
+                uint32_t unitsInTick = reader.bits(32);
+                uint32_t timeScale = reader.bits(32);
+                if (unitsInTick > 0) {
+                    info.frameRate = (double)timeScale / unitsInTick;
+                }
+            }
+        }
+        return reader.ok();
+    }
+
+    static bool isSps(const uint8_t* nal, size_t size, AVCodecID codec) {
+        if (size < 2) return false;
+        if (codec == AV_CODEC_ID_H264) {
+            return (nal[0] & 0x1f) == H264_NAL_SPS;
+        }
+        return ((nal[0] >> 1) & 0x3f) == HEVC_NAL_SPS;
+    }
+
+    static bool parseNal(const uint8_t* nal, size_t size, AVCodecID codec, SpsInfo& info) {
+        SpsInfo parsed;
+        bool ok = (codec == AV_CODEC_ID_H264) ? parseH264(nal, size, parsed) : parseHevc(nal, size, parsed);
+        if (!ok || parsed.width <= 0 || parsed.height <= 0) {
+            return false;
+        }
+        info = parsed;
+        return true;
+    }
+
+public:
+    static bool isSupported(AVCodecID codec) {
+        return codec == AV_CODEC_ID_H264 || codec == AV_CODEC_ID_HEVC;
+    }
+
+    /**
+     * Find and parse the first SPS in extradata or a packet
+     *
+     * @param data Annex B byte stream, or avcC (H.264 extradata)
+     * @return true if an SPS was found and parsed
+     */
+    static bool findSps(const uint8_t* data, size_t size, AVCodecID codec, SpsInfo& info) {
+        if (!data || size < 4 || !isSupported(codec)) {
+            return false;
+        }
+
+        // avcC: version 1, SPS count at byte 5, 16-bit length prefixed
+        if (codec == AV_CODEC_ID_H264 && data[0] == 1 && size > 8) {
+            size_t length = ((size_t)data[6] << 8) | data[7];
+            return (data[5] & 0x1f) > 0 && 8 + length <= size &&
+                   isSps(data + 8, length, codec) && parseNal(data + 8, length, codec, info);
+        }
+
+        // Annex B: NAL units between 00 00 01 start codes
+        size_t pos = 0;
+        while (pos + 3 <= size) {
+            if (data[pos] != 0 || data[pos + 1] != 0 || data[pos + 2] != 1) {
+                pos++;
+                continue;
+            }
+            size_t start = pos + 3;
+            size_t end = start;
+            while (end + 3 <= size && !(data[end] == 0 && data[end + 1] == 0 && data[end + 2] == 1)) {
+                end++;
+            }
+            if (end + 3 > size) end = size;   // Zero byte of a 4-byte start code stays attached, harmless
+
+            if (isSps(data + start, end - start, codec) && parseNal(data + start, end - start, codec, info)) {
+                return true;
+            }
+            pos = end;
+        }
+        return false;
+    }
+
+    /**
+     * libav pixel format the decoder will report for this SPS
+     */
+    static AVPixelFormat toPixelFormat(const SpsInfo& info) {
+        if (info.bitDepth == 8) {
+            switch (info.chromaFormatIdc) {
+                case 0: return AV_PIX_FMT_GRAY8;
+                case 2: return info.fullRange ? AV_PIX_FMT_YUVJ422P : AV_PIX_FMT_YUV422P;
+                case 3: return info.fullRange ? AV_PIX_FMT_YUVJ444P : AV_PIX_FMT_YUV444P;
+                default: return info.fullRange ? AV_PIX_FMT_YUVJ420P : AV_PIX_FMT_YUV420P;
+            }
+        }
+        if (info.bitDepth == 10) {
+            switch (info.chromaFormatIdc) {
+                case 2: return AV_PIX_FMT_YUV422P10LE;
+                case 3: return AV_PIX_FMT_YUV444P10LE;
+                default: return AV_PIX_FMT_YUV420P10LE;
+            }
+        }
+        return AV_PIX_FMT_NONE;
+    }
+
+    static const char* chromaFormatName(int chromaFormatIdc) {
+        switch (chromaFormatIdc) {
+            case 0: return "4:0:0";
+            case 2: return "4:2:2";
+            case 3: return "4:4:4";
+            default: return "4:2:0";
+        }
+    }
+};
+
+#endif // SPS_PARSER_HPP
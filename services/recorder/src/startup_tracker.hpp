@@ -0,0 +1,97 @@
+#ifndef STARTUP_TRACKER_HPP
+#define STARTUP_TRACKER_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include "logger.hpp"
+
+/**
+ * StartupTracker - Fleet time-to-first-segment
+ *
+ * Measures from startAll() until each camera has its first recording
+ * segment open; logs a summary (p50/p95/max) once every camera has
+ * reported. Cameras that never come up keep the summary at "k/N".
+ * Only the first segment after process start counts, restarts later
+ * on do not.
+ */
+class StartupTracker {
+private:
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point startTime;
+    size_t expected;
+    std::vector<std::pair<double, std::string>> firstSegments;   // Seconds since start, camera
+    bool completeLogged;
+
+    static std::string formatSeconds(double seconds) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1fs", seconds);
+        return buffer;
+    }
+
+    std::string summaryLocked() const {
+        std::string summary = std::to_string(firstSegments.size()) + "/" + std::to_string(expected) +
+                              " cameras recording";
+        if (firstSegments.empty()) {
+            return summary;
+        }
+
+        std::vector<double> times;
+        for (const auto& item : firstSegments) {
+            times.push_back(item.first);
+        }
+        std::sort(times.begin(), times.end());
+        auto percentile = [&times](double p) {
+            return times[std::min(times.size() - 1, (size_t)(p * (times.size() - 1)))];
+        };
+        auto slowest = std::max_element(firstSegments.begin(), firstSegments.end());
+
+        return summary + ", time-to-first-segment p50 " + formatSeconds(percentile(0.50)) +
+               ", p95 " + formatSeconds(percentile(0.95)) + ", max " + formatSeconds(slowest->first) +
+               " (" + slowest->second + ")";
+    }
+
+public:
+    StartupTracker() : startTime(std::chrono::steady_clock::now()), expected(0), completeLogged(false) {}
+
+    /**
+     * Start the clock for a fleet of cameras
+     */
+    void begin(size_t cameraCount) {
+        std::lock_guard<std::mutex> lock(mutex);
+        startTime = std::chrono::steady_clock::now();
+        expected = cameraCount;
+        firstSegments.clear();
+        completeLogged = false;
+    }
+
+    /**
+     * A camera opened its first segment (call once per camera)
+     */
+    void recordFirstSegment(const std::string& cameraName) {
+        std::lock_guard<std::mutex> lock(mutex);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        firstSegments.emplace_back(elapsed, cameraName);
+        Logger::debug("First segment for " + cameraName + " after " + formatSeconds(elapsed));
+
+        if (!completeLogged && firstSegments.size() >= expected) {
+            completeLogged = true;
+            Logger::info("Fleet startup complete: " + summaryLocked());
+        }
+    }
+
+    bool isComplete() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return completeLogged;
+    }
+
+    std::string getSummary() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return summaryLocked();
+    }
+};
+
+#endif // STARTUP_TRACKER_HPP
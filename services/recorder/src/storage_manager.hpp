@@ -6,7 +6,21 @@
 #include <sys/statvfs.h>
 #include <vector>
 #include <algorithm>
+#include <memory>
+#include <atomic>
+#include <iterator>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
 #include "logger.hpp"
+#include "segment_index.hpp"
+#include "eviction_engine.hpp"
 
 namespace fs = std::filesystem;
 
@@ -18,62 +32,508 @@ namespace fs = std::filesystem;
  * - Auto cleanup old recordings based on retention days
  * - Prevent recording when disk full
  * - Alert when disk usage high
+ *
+ * Segments are tracked in a SegmentIndex (one scan at startup, then
+ * updated as segments close), so cleanup never walks the recording tree.
+ * Deletion sets are computed from tracked sizes and unlinked by the
+ * EvictionEngine thread; callers never wait for file system I/O.
+ *
+ * Optional slower tiers (warm, cold = recordings.storage_tier) live on
+ * other paths with their own index; TierMover moves aged segments down.
+ * Retention covers every tier, free-space eviction works per tier.
+ *
+ * Per camera quotas (cameras.storage_quota_gb / retention_days): a
+ * camera over its byte quota loses its own oldest segments first, on
+ * every sweep and before anyone else under disk pressure. The rest of
+ * an eviction is a weighted fair share (bytes per quota), so one
+ * high-bitrate camera cannot wipe the history of all the others.
+ * Each eviction pass is bounded (MAX_EVICTION_SEGMENTS); a large
+ * deficit is paid off over the following passes.
+ *
+ * The hot tier can span several volumes (RECORDING_PATH plus
+ * RECORDING_VOLUMES, one file system each, JBOD). Every volume has its
+ * own index, free space reserve and eviction; a camera writes to one
+ * volume at a time, chosen at segment boundaries (getCameraDirectory):
+ * - score = capacity / (volume ingest + camera rate), divided by
+ *   1 + write latency / LATENCY_REFERENCE_MS: cameras spread by
+ *   retention time per byte/s, slow disks take fewer of them
+ * - sticky; moves when its volume is unhealthy or full, or when another
+ *   one scores REBALANCE_FACTOR better (a new disk fills up with cameras
+ *   and adds its write bandwidth)
+ * - one probe thread per volume (statvfs + 4 KB write and fdatasync
+ *   every PROBE_INTERVAL_SECONDS) measures latency and free space; a
+ *   volume whose probe fails or hangs takes no cameras and is skipped by
+ *   eviction. Callers only read the probe results, so a hung disk stalls
+ *   its own cameras and probe, not the control loop or other volumes.
  */
 class StorageManager {
 private:
-    std::string recordingPath;
+    std::string recordingPath;  // Primary hot volume
     int retentionDays;          // Số ngày lưu trữ (mặc định 2, có thể lên 30)
-    uint64_t minFreeSpaceGB;    // Minimum free space required (GB)
+    uint64_t minFreeSpaceGB;    // Minimum free space required (GB), per volume
     
-public:
-    StorageManager(const std::string& path, int retention = 2, uint64_t minFree = 10)
-        : recordingPath(path), retentionDays(retention), minFreeSpaceGB(minFree) {}
+    struct StorageTier {
+        std::string name;       // recordings.storage_tier
+        std::string path;
+        SegmentIndex index;
+        std::atomic<uint64_t> pendingBytes{0};      // Queued for eviction
+        std::atomic<uint64_t> freedBytes{0};        // Evicted
+        std::atomic<uint64_t> migratedOutBytes{0};  // Moved to a lower tier by TierMover
+        
+        // Probe results (hot volumes, while probes run)
+        std::atomic<uint64_t> freeBytes{0};
+        std::atomic<uint64_t> totalBytes{0};
+        std::atomic<uint64_t> usedBytes{0};
+        std::atomic<int64_t> latencyUs{0};          // EWMA of the probe write + fdatasync
+        std::atomic<int64_t> lastProbeOkMs{0};      // steadyMs(), 0 = never
+        std::atomic<int64_t> probeStartedMs{0};     // steadyMs() of the probe in progress, 0 = idle
+        double ingestRate = 0;                      // Cameras placed here, bytes/s (placementMutex)
+    };
+    std::vector<std::unique_ptr<StorageTier>> volumes;      // Hot tier; [0] = recordingPath (addVolume before rebuildIndex)
+    std::vector<std::unique_ptr<StorageTier>> lowerTiers;   // Warm, cold (addTier before rebuildIndex)
+    
+    struct CameraQuota {
+        uint64_t maxBytes;      // All tiers together, 0 = no byte quota
+        int retentionDays;      // 0 = global retention
+    };
+    mutable std::mutex quotaMutex;
+    std::map<std::string, CameraQuota> cameraQuotas;       // Camera directory name -> quota
+    
+    std::mutex placementMutex;
+    std::map<std::string, size_t> placements;              // Camera directory name -> volume
+    std::map<std::string, double> cameraRates;             // Camera directory name -> bytes/s (StorageMonitor)
+    
+    std::mutex probeMutex;
+    std::condition_variable probeCv;
+    std::vector<std::thread> probeThreads;
+    bool probesStopping;
+    std::atomic<bool> probing;      // Free space comes from the probes, not statvfs
+    
+    EvictionEngine evictionEngine;   // Declared last: stops before the indexes go away
+    
+    static constexpr uint64_t GB = 1024ULL * 1024ULL * 1024ULL;
+    static constexpr size_t MAX_EVICTION_SEGMENTS = 2048;    // Per pass (about 90 GB of 180 s segments)
+    static constexpr int PROBE_INTERVAL_SECONDS = 5;
+    static constexpr int64_t PROBE_TIMEOUT_MS = 10000;       // Probe running longer = volume hung
+    static constexpr int64_t PROBE_STALE_MS = 3 * PROBE_INTERVAL_SECONDS * 1000 + PROBE_TIMEOUT_MS;
+    static constexpr size_t PROBE_BYTES = 4096;
+    static constexpr double LATENCY_WEIGHT = 0.3;            // EWMA weight of the newest probe
+    static constexpr double LATENCY_REFERENCE_MS = 20.0;     // Latency that halves a volume's score
+    static constexpr double REBALANCE_FACTOR = 1.5;          // Move a camera to a volume scoring this much better
+    static constexpr double DEFAULT_CAMERA_RATE = 512.0 * 1024.0;   // 4 Mbps until measured
+    
+    static uint64_t freeBytesAt(const std::string& path) {
+        struct statvfs stat;
+        if (statvfs(path.c_str(), &stat) != 0) {
+            return 0;
+        }
+        return (uint64_t)stat.f_bavail * stat.f_frsize;
+    }
+    
+    static int64_t steadyMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    static std::unique_ptr<StorageTier> makeTier(const std::string& name, const std::string& path) {
+        std::unique_ptr<StorageTier> tier(new StorageTier());
+        tier->name = name;
+        tier->path = path;
+        return tier;
+    }
     
     /**
-     * Kiểm tra dung lượng disk còn trống
-     * Returns: GB còn trống
+     * Free space of a tier: last probe for hot volumes while probes run
+     * (never blocks on a hung disk), statvfs otherwise
      */
-    uint64_t getFreeSpaceGB() {
-        struct statvfs stat;
+    uint64_t freeBytesOf(const StorageTier& tier) const {
+        if (probing && tier.name == "hot") {
+            return tier.freeBytes;
+        }
+        return freeBytesAt(tier.path);
+    }
+    
+    /**
+     * Probe recently succeeded and none is stuck (always true without probes)
+     */
+    bool isHealthy(const StorageTier& volume) const {
+        if (!probing) return true;
+        int64_t now = steadyMs();
+        int64_t started = volume.probeStartedMs;
+        if (started != 0 && now - started > PROBE_TIMEOUT_MS) {
+            return false;
+        }
+        int64_t lastOk = volume.lastProbeOkMs;
+        return lastOk != 0 && now - lastOk <= PROBE_STALE_MS;
+    }
+    
+    /**
+     * Placement score of a volume for a camera adding cameraRate
+     * (0 = cannot take it)
+     */
+    double placementScore(const StorageTier& volume, double ingestRate, double cameraRate) const {
+        uint64_t reserve = minFreeSpaceGB * GB;
+        if (!isHealthy(volume) || freeBytesOf(volume) <= reserve) {
+            return 0;
+        }
+        uint64_t capacity = volume.totalBytes;
+        if (capacity == 0) {
+            capacity = freeBytesOf(volume);
+        }
+        double latencyMs = volume.latencyUs / 1000.0;
+        return (double)capacity / (ingestRate + cameraRate) / (1.0 + latencyMs / LATENCY_REFERENCE_MS);
+    }
+    
+    /**
+     * Volume for a camera's next segment (placementMutex held)
+     */
+    size_t placeCamera(const std::string& cameraName) {
+        if (volumes.size() == 1) {
+            placements[cameraName] = 0;
+            return 0;
+        }
+        auto rate = cameraRates.find(cameraName);
+        double cameraRate = rate != cameraRates.end() && rate->second > 0 ? rate->second : DEFAULT_CAMERA_RATE;
+        
+        auto placed = placements.find(cameraName);
+        bool hasCurrent = placed != placements.end();
+        size_t current = hasCurrent ? placed->second : 0;
+        double currentScore = 0;
+        if (hasCurrent) {
+            // Its own rate is already in the volume's ingest
+            const StorageTier& volume = *volumes[current];
+            currentScore = placementScore(volume, std::max(volume.ingestRate - cameraRate, 0.0), cameraRate);
+        }
+        
+        size_t best = current;
+        double bestScore = currentScore;
+        for (size_t i = 0; i < volumes.size(); i++) {
+            if (hasCurrent && i == current) continue;
+            double score = placementScore(*volumes[i], volumes[i]->ingestRate, cameraRate);
+            if (score > bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        if (hasCurrent && (best == current || (currentScore > 0 && bestScore < currentScore * REBALANCE_FACTOR))) {
+            return current;
+        }
+        if (bestScore <= 0) {
+            if (hasCurrent) return current;
+            // Nothing healthy with room: the one with the most free space
+            for (size_t i = 1; i < volumes.size(); i++) {
+                if (freeBytesOf(*volumes[i]) > freeBytesOf(*volumes[best])) best = i;
+            }
+            Logger::error("Storage: no healthy volume with free space for " + cameraName + ", using " +
+                          volumes[best]->path);
+        }
         
-        if (statvfs(recordingPath.c_str(), &stat) != 0) {
-            Logger::error("Failed to get disk stats for " + recordingPath);
+        if (hasCurrent) {
+            volumes[current]->ingestRate = std::max(volumes[current]->ingestRate - cameraRate, 0.0);
+            Logger::warn("Storage: moving " + cameraName + " from " + volumes[current]->path + " to " +
+                         volumes[best]->path + (currentScore > 0 ? " (rebalance)" : " (volume unhealthy or full)"));
+        } else {
+            Logger::info("Storage: " + cameraName + " placed on " + volumes[best]->path);
+        }
+        volumes[best]->ingestRate += cameraRate;
+        placements[cameraName] = best;
+        return best;
+    }
+    
+    /**
+     * Probe thread of one volume
+     */
+    void probeLoop(StorageTier* volume) {
+        std::string probePath = volume->path + "/.volume_probe";
+        std::vector<char> block(PROBE_BYTES, 0);
+        bool healthy = true;
+        
+        std::unique_lock<std::mutex> lock(probeMutex);
+        while (!probesStopping) {
+            lock.unlock();
+            auto started = std::chrono::steady_clock::now();
+            volume->probeStartedMs = steadyMs();
+            
+            struct statvfs stat;
+            int error = 0;
+            bool ok = statvfs(volume->path.c_str(), &stat) == 0;
+            if (ok) {
+                volume->freeBytes = (uint64_t)stat.f_bavail * stat.f_frsize;
+                volume->totalBytes = (uint64_t)stat.f_blocks * stat.f_frsize;
+                volume->usedBytes = (uint64_t)(stat.f_blocks - stat.f_bfree) * stat.f_frsize;
+                int fd = ::open(probePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                ok = fd >= 0 && ::pwrite(fd, block.data(), block.size(), 0) == (ssize_t)block.size() &&
+                     ::fdatasync(fd) == 0;
+                error = errno;
+                if (fd >= 0) ::close(fd);
+            } else {
+                error = errno;
+            }
+            
+            int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            volume->probeStartedMs = 0;
+            if (ok) {
+                int64_t latency = volume->latencyUs;
+                volume->latencyUs = latency == 0 ? elapsedUs
+                                                 : latency + (int64_t)((elapsedUs - latency) * LATENCY_WEIGHT);
+                volume->lastProbeOkMs = steadyMs();
+                if (!healthy) {
+                    Logger::info("Storage: volume " + volume->path + " is writable again");
+                }
+            } else if (healthy) {
+                Logger::error("Storage: volume " + volume->path + " failed its write probe: " + strerror(error));
+            }
+            healthy = ok;
+            
+            lock.lock();
+            probeCv.wait_for(lock, std::chrono::seconds(PROBE_INTERVAL_SECONDS), [this] { return probesStopping; });
+        }
+    }
+    
+    void stopVolumeProbes() {
+        {
+            std::lock_guard<std::mutex> lock(probeMutex);
+            probesStopping = true;
+        }
+        probeCv.notify_all();
+        for (auto& thread : probeThreads) {
+            thread.join();
+        }
+        probeThreads.clear();
+        probing = false;
+    }
+    
+    StorageTier* findLowerTier(const std::string& tier) {
+        for (auto& lower : lowerTiers) {
+            if (lower->name == tier) return lower.get();
+        }
+        return nullptr;
+    }
+    
+    /**
+     * Tier or hot volume a segment path lives on (primary volume if none matches)
+     */
+    StorageTier& tierForPath(const std::string& path) const {
+        for (const auto& lower : lowerTiers) {
+            if (path.compare(0, lower->path.size() + 1, lower->path + "/") == 0) {
+                return *lower;
+            }
+        }
+        for (size_t i = 1; i < volumes.size(); i++) {
+            if (path.compare(0, volumes[i]->path.size() + 1, volumes[i]->path + "/") == 0) {
+                return *volumes[i];
+            }
+        }
+        return *volumes.front();
+    }
+    
+    /**
+     * Bytes each camera is over its quota, counting all tiers
+     */
+    std::map<std::string, uint64_t> getQuotaOverage() {
+        std::map<std::string, CameraQuota> quotas;
+        {
+            std::lock_guard<std::mutex> lock(quotaMutex);
+            quotas = cameraQuotas;
+        }
+        std::map<std::string, uint64_t> overage;
+        for (const auto& item : quotas) {
+            if (item.second.maxBytes == 0) continue;
+            uint64_t bytes = 0;
+            for (const auto& volume : volumes) {
+                bytes += volume->index.getCameraBytes(volume->path + "/" + item.first);
+            }
+            for (const auto& tier : lowerTiers) {
+                bytes += tier->index.getCameraBytes(tier->path + "/" + item.first);
+            }
+            if (bytes > item.second.maxBytes) {
+                overage[item.first] = bytes - item.second.maxBytes;
+            }
+        }
+        return overage;
+    }
+    
+    /**
+     * Pop what cameras are over their quota from one tier's index
+     * (oldest first); overage is reduced by what was taken
+     */
+    void popOverage(StorageTier& tier, std::map<std::string, uint64_t>& overage,
+                    size_t maxSegments, std::vector<SegmentIndex::Segment>& out) {
+        for (auto& item : overage) {
+            if (item.second == 0 || out.size() >= maxSegments) continue;
+            std::vector<SegmentIndex::Segment> taken =
+                tier.index.popCameraOldest(tier.path + "/" + item.first, item.second, maxSegments - out.size());
+            for (auto& segment : taken) {
+                item.second -= std::min(item.second, segment.size);
+                out.push_back(std::move(segment));
+            }
+        }
+    }
+    
+    /**
+     * Fair-share weights of one tier's camera directories: the byte
+     * quota where set, the mean quota (or 1) for the others
+     */
+    double getFairShareWeights(const std::string& path, std::map<std::string, double>& weights) {
+        std::lock_guard<std::mutex> lock(quotaMutex);
+        double sum = 0;
+        size_t count = 0;
+        for (const auto& item : cameraQuotas) {
+            if (item.second.maxBytes == 0) continue;
+            weights[path + "/" + item.first] = (double)item.second.maxBytes;
+            sum += (double)item.second.maxBytes;
+            count++;
+        }
+        return count > 0 ? sum / count : 1.0;
+    }
+    
+    /**
+     * Hand segments to the eviction thread, counted as pending on the
+     * tier each one lives on
+     */
+    void submitEviction(std::vector<SegmentIndex::Segment>&& segments, const std::string& reason,
+                        EvictionEngine::StopCondition done = EvictionEngine::StopCondition()) {
+        for (const auto& segment : segments) {
+            tierForPath(segment.path).pendingBytes += segment.size;
+        }
+        evictionEngine.submit(std::move(segments), reason, std::move(done));
+    }
+    
+    /**
+     * Queue segments of one tier until its free space (counting
+     * deletions already queued) reaches targetFreeBytes: cameras over
+     * quota first, then weighted fair share; at most
+     * MAX_EVICTION_SEGMENTS per call
+     */
+    uint64_t evictFrom(StorageTier& tier, uint64_t targetFreeBytes, const std::string& reason) {
+        uint64_t available = freeBytesOf(tier) + tier.pendingBytes;
+        if (available >= targetFreeBytes) {
             return 0;
         }
+        uint64_t deficit = targetFreeBytes - available;
         
-        // Calculate free space in GB
-        uint64_t freeBytes = stat.f_bavail * stat.f_frsize;
-        uint64_t freeGB = freeBytes / (1024ULL * 1024ULL * 1024ULL);
+        std::vector<SegmentIndex::Segment> planned;
+        std::map<std::string, uint64_t> overage = getQuotaOverage();
+        popOverage(tier, overage, MAX_EVICTION_SEGMENTS, planned);
+        size_t overQuota = planned.size();
         
-        return freeGB;
+        uint64_t plannedBytes = 0;
+        for (const auto& segment : planned) {
+            plannedBytes += segment.size;
+        }
+        if (plannedBytes < deficit && planned.size() < MAX_EVICTION_SEGMENTS) {
+            std::map<std::string, double> weights;
+            double defaultWeight = getFairShareWeights(tier.path, weights);
+            std::vector<SegmentIndex::Segment> shared = tier.index.popFairShare(
+                deficit - plannedBytes, weights, defaultWeight, MAX_EVICTION_SEGMENTS - planned.size());
+            for (auto& segment : shared) {
+                plannedBytes += segment.size;
+                planned.push_back(std::move(segment));
+            }
+        }
+        if (planned.empty()) {
+            Logger::error("Eviction (" + reason + "): no indexed segments left to delete in " + tier.path);
+            return 0;
+        }
+        
+        Logger::warn("Eviction (" + reason + "): deleting " + std::to_string(planned.size()) + " segments (" +
+                   std::to_string(plannedBytes / (1024*1024)) + " MB, " + std::to_string(overQuota) +
+                   " over quota) in " + tier.path + (plannedBytes < deficit ? ", rest in the next pass" : ""));
+        std::string path = tier.path;
+        submitEviction(std::move(planned), reason, [path, targetFreeBytes]() {
+            return freeBytesAt(path) >= targetFreeBytes;
+        });
+        return plannedBytes;
+    }
+    
+public:
+    /**
+     * Per-volume view for StorageMonitor (never blocks on a hung disk
+     * while probes run)
+     */
+    struct VolumeStatus {
+        std::string path;
+        uint64_t freeBytes;
+        uint64_t pendingBytes;      // Queued for eviction
+        uint64_t releasedBytes;     // Evicted + moved to lower tiers, monotonic
+        double ingestRate;          // Cameras placed here, bytes/s
+        double latencyMs;           // Probe write latency, 0 = not probed
+        bool healthy;
+    };
+    
+    StorageManager(const std::string& path, int retention = 2, uint64_t minFree = 10)
+        : recordingPath(path), retentionDays(retention), minFreeSpaceGB(minFree),
+          probesStopping(false), probing(false) {
+        volumes.push_back(makeTier("hot", path));
+        evictionEngine.start([this](std::vector<SegmentIndex::Segment>&& segments) {
+            returnSegments(std::move(segments));
+        }, [this](const SegmentIndex::Segment& segment, bool deleted) {
+            StorageTier& tier = tierForPath(segment.path);
+            tier.pendingBytes -= segment.size;
+            if (deleted) {
+                tier.freedBytes += segment.size;
+            }
+        });
+    }
+    
+    ~StorageManager() {
+        stopVolumeProbes();
     }
     
     /**
-     * Kiểm tra % disk usage
+     * Kiểm tra dung lượng disk còn trống (all hot volumes)
+     * Returns: GB còn trống
+     */
+    uint64_t getFreeSpaceGB() {
+        return getFreeSpaceBytes() / GB;
+    }
+    
+    uint64_t getFreeSpaceBytes() {
+        uint64_t freeBytes = 0;
+        for (const auto& volume : volumes) {
+            freeBytes += freeBytesOf(*volume);
+        }
+        return freeBytes;
+    }
+    
+    /**
+     * Kiểm tra % disk usage (all hot volumes)
      * Returns: Percentage used (0-100)
      */
     int getDiskUsagePercent() {
-        struct statvfs stat;
-        
-        if (statvfs(recordingPath.c_str(), &stat) != 0) {
-            return 100; // Assume full on error
+        uint64_t totalBytes = 0;
+        uint64_t usedBytes = 0;
+        for (const auto& volume : volumes) {
+            if (probing) {
+                totalBytes += volume->totalBytes;
+                usedBytes += volume->usedBytes;
+                continue;
+            }
+            struct statvfs stat;
+            if (statvfs(volume->path.c_str(), &stat) != 0) {
+                continue;
+            }
+            totalBytes += (uint64_t)stat.f_blocks * stat.f_frsize;
+            usedBytes += (uint64_t)(stat.f_blocks - stat.f_bfree) * stat.f_frsize;
         }
         
-        uint64_t totalBlocks = stat.f_blocks;
-        uint64_t freeBlocks = stat.f_bfree;
-        uint64_t usedBlocks = totalBlocks - freeBlocks;
+        if (totalBytes == 0) return 100; // Assume full on error
         
-        if (totalBlocks == 0) return 100;
-        
-        return (usedBlocks * 100) / totalBlocks;
+        return (int)(usedBytes * 100 / totalBytes);
     }
     
     /**
      * Kiểm tra có đủ không gian để ghi không
-     * Returns: true nếu đủ space, false nếu gần đầy
+     * Returns: true nếu một volume khỏe còn đủ space, false nếu tất cả gần đầy
      */
     bool hasEnoughSpace() {
-        uint64_t freeGB = getFreeSpaceGB();
+        uint64_t freeGB = 0;
+        for (const auto& volume : volumes) {
+            if (isHealthy(*volume)) {
+                freeGB = std::max(freeGB, freeBytesOf(*volume) / GB);
+            }
+        }
         
         if (freeGB < minFreeSpaceGB) {
             Logger::error("Disk space critical! Only " + std::to_string(freeGB) + 
@@ -90,154 +550,391 @@ public:
     }
     
     /**
-     * Xóa recordings cũ hơn retention days
+     * Thêm volume ghi hình (JBOD, cùng tier hot) - gọi trước rebuildIndex()
      */
-    void cleanupOldRecordings() {
-        if (retentionDays <= 0) {
-            Logger::info("Retention cleanup disabled (retentionDays = 0)");
+    void addVolume(const std::string& path) {
+        for (const auto& volume : volumes) {
+            if (volume->path == path) return;
+        }
+        std::error_code ec;
+        fs::create_directories(path, ec);
+        if (ec) {
+            Logger::error("Cannot create recording volume " + path + ": " + ec.message());
             return;
         }
+        volumes.push_back(makeTier("hot", path));
+        Logger::info("Recording volume: " + path);
+    }
+    
+    /**
+     * Start the per-volume probes (with more than one volume; placement
+     * has nothing to choose otherwise)
+     */
+    void startVolumeProbes() {
+        if (volumes.size() < 2 || !probeThreads.empty()) return;
+        for (auto& volume : volumes) {
+            struct statvfs stat;
+            if (statvfs(volume->path.c_str(), &stat) == 0) {
+                volume->freeBytes = (uint64_t)stat.f_bavail * stat.f_frsize;
+                volume->totalBytes = (uint64_t)stat.f_blocks * stat.f_frsize;
+                volume->usedBytes = (uint64_t)(stat.f_blocks - stat.f_bfree) * stat.f_frsize;
+                volume->lastProbeOkMs = steadyMs();
+            }
+        }
+        probing = true;
+        probesStopping = false;
+        for (auto& volume : volumes) {
+            probeThreads.emplace_back(&StorageManager::probeLoop, this, volume.get());
+        }
+        Logger::info("Storage: probing " + std::to_string(volumes.size()) + " recording volumes every " +
+                     std::to_string(PROBE_INTERVAL_SECONDS) + " s");
+    }
+    
+    /**
+     * Thêm tier lưu trữ chậm hơn (warm, cold) - gọi trước rebuildIndex()
+     */
+    void addTier(const std::string& name, const std::string& path) {
+        std::error_code ec;
+        fs::create_directories(path, ec);
+        if (ec) {
+            Logger::error("Cannot create " + name + " tier path " + path + ": " + ec.message());
+            return;
+        }
+        lowerTiers.push_back(makeTier(name, path));
+        Logger::info("Storage tier " + name + ": " + path);
+    }
+    
+    bool hasTier(const std::string& name) const {
+        return name == "hot" || std::any_of(lowerTiers.begin(), lowerTiers.end(),
+            [&name](const std::unique_ptr<StorageTier>& tier) { return tier->name == name; });
+    }
+    
+    /**
+     * Root path of a tier ("" if not configured; primary volume for hot)
+     */
+    std::string getTierPath(const std::string& name) const {
+        if (name == "hot") return recordingPath;
+        for (const auto& tier : lowerTiers) {
+            if (tier->name == name) return tier->path;
+        }
+        return "";
+    }
+    
+    uint64_t getTierFreeBytes(const std::string& name) const {
+        std::string path = getTierPath(name);
+        return path.empty() ? 0 : freeBytesAt(path);
+    }
+    
+    /**
+     * Root of the tier or hot volume a segment path lives on
+     */
+    std::string getVolumeRoot(const std::string& path) const {
+        return tierForPath(path).path;
+    }
+    
+    size_t getVolumeCount() const { return volumes.size(); }
+    
+    VolumeStatus getVolumeStatus(size_t volume) {
+        const StorageTier& tier = *volumes.at(volume);
+        double ingestRate;
+        {
+            std::lock_guard<std::mutex> lock(placementMutex);
+            ingestRate = tier.ingestRate;
+        }
+        return {tier.path, freeBytesOf(tier), tier.pendingBytes, tier.freedBytes + tier.migratedOutBytes,
+                ingestRate, tier.latencyUs / 1000.0, isHealthy(tier)};
+    }
+    
+    /**
+     * Thư mục ghi của camera cho segment tiếp theo (creates it)
+     *
+     * Called by writers at every segment boundary; returns "" if the
+     * directory cannot be created.
+     */
+    std::string getCameraDirectory(const std::string& cameraName) {
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(placementMutex);
+            directory = volumes[placeCamera(cameraName)]->path + "/" + cameraName;
+        }
+        std::error_code ec;
+        fs::create_directories(directory, ec);
+        if (ec) {
+            Logger::error("Failed to create directory " + directory + ": " + ec.message());
+            return "";
+        }
+        return directory;
+    }
+    
+    /**
+     * Measured camera write rates (StorageMonitor, control loop); volume
+     * ingest is recomputed from where the cameras are placed
+     */
+    void updateIngestRates(const std::map<std::string, double>& rates) {
+        std::lock_guard<std::mutex> lock(placementMutex);
+        cameraRates = rates;
+        for (auto& volume : volumes) {
+            volume->ingestRate = 0;
+        }
+        for (const auto& item : placements) {
+            auto rate = cameraRates.find(item.first);
+            volumes[item.second]->ingestRate += rate != cameraRates.end() ? rate->second : DEFAULT_CAMERA_RATE;
+        }
+    }
+    
+    /**
+     * Build the segment indexes (one scan of every volume and tier, at startup)
+     */
+    void rebuildIndex() {
+        for (auto& volume : volumes) {
+            auto started = std::chrono::steady_clock::now();
+            size_t count = volume->index.rebuild(volume->path);
+            auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            Logger::info("Segment index (" + volume->path + "): " + std::to_string(count) + " segments, " +
+                       std::to_string(volume->index.getTotalBytes() / GB) + " GB (" +
+                       std::to_string(elapsedMs) + " ms)");
+        }
         
-        auto now = std::chrono::system_clock::now();
-        auto cutoffTime = now - std::chrono::hours(retentionDays * 24);
-        
-        std::vector<fs::path> filesToDelete;
-        uint64_t totalSize = 0;
-        int fileCount = 0;
-        
-        try {
-            // Scan all camera directories
-            for (const auto& cameraDir : fs::directory_iterator(recordingPath)) {
-                if (!fs::is_directory(cameraDir)) continue;
-                
-                // Check all MP4 files in camera directory
-                for (const auto& entry : fs::directory_iterator(cameraDir)) {
-                    if (!entry.is_regular_file()) continue;
-                    if (entry.path().extension() != ".mp4") continue;
-                    
-                    // Check file modification time
-                    auto fileTime = fs::last_write_time(entry);
-                    auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-                        fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now()
-                    );
-                    
-                    if (sctp < cutoffTime) {
-                        filesToDelete.push_back(entry.path());
-                        totalSize += fs::file_size(entry);
-                        fileCount++;
-                    }
+        for (auto& tier : lowerTiers) {
+            size_t tierCount = tier->index.rebuild(tier->path);
+            Logger::info("Segment index (" + tier->name + "): " + std::to_string(tierCount) + " segments, " +
+                       std::to_string(tier->index.getTotalBytes() / GB) + " GB");
+        }
+    }
+    
+    /**
+     * A recorder closed a segment (any thread)
+     */
+    void onSegmentClosed(const std::string& path, uint64_t size) {
+        tierForPath(path).index.add(path.substr(0, path.rfind('/')), path, size);
+    }
+    
+    /**
+     * Index segments of a camera whose writer does not report closes
+     * (ffmpeg CLI backend), on every volume it may have written to
+     */
+    void syncCameraSegments(const std::string& cameraName) {
+        for (auto& volume : volumes) {
+            std::string cameraDir = volume->path + "/" + cameraName;
+            std::error_code ec;
+            if (fs::is_directory(cameraDir, ec)) {
+                volume->index.syncCamera(cameraDir);
+            }
+        }
+    }
+    
+    /**
+     * Take the oldest segments of a tier for a move to the next one
+     * (they leave the index until onSegmentMigrated/returnSegments)
+     */
+    std::vector<SegmentIndex::Segment> takeForMigration(const std::string& tier, std::time_t cutoff,
+                                                        size_t maxSegments) {
+        if (tier != "hot") {
+            StorageTier* lower = findLowerTier(tier);
+            if (!lower) return {};
+            return lower->index.popOldestBefore(cutoff, maxSegments);
+        }
+        std::vector<SegmentIndex::Segment> taken;
+        for (auto& volume : volumes) {
+            if (taken.size() >= maxSegments) break;
+            if (!isHealthy(*volume)) continue;
+            std::vector<SegmentIndex::Segment> aged = volume->index.popOldestBefore(cutoff, maxSegments - taken.size());
+            std::move(aged.begin(), aged.end(), std::back_inserter(taken));
+        }
+        return taken;
+    }
+    
+    /**
+     * A segment now lives on another tier (source already deleted)
+     */
+    void onSegmentMigrated(const std::string& sourcePath, const std::string& toTier,
+                           const std::string& cameraDir, const SegmentIndex::Segment& segment) {
+        StorageTier* tier = findLowerTier(toTier);
+        if (tier) {
+            tier->index.add(cameraDir, segment.path, segment.size, segment.mtime);
+        }
+        tierForPath(sourcePath).migratedOutBytes += segment.size;
+    }
+    
+    /**
+     * Put segments back into the index of the tier they live on
+     */
+    void returnSegments(std::vector<SegmentIndex::Segment>&& segments) {
+        if (lowerTiers.empty() && volumes.size() == 1) {
+            volumes.front()->index.restore(std::move(segments));
+            return;
+        }
+        for (auto& segment : segments) {
+            std::vector<SegmentIndex::Segment> one;
+            one.push_back(std::move(segment));
+            tierForPath(one.front().path).index.restore(std::move(one));
+        }
+    }
+    
+    /**
+     * Quota riêng cho từng camera (cameras.storage_quota_gb, retention_days)
+     *
+     * @param cameraName Camera directory name under each tier
+     * @param maxBytes 0 = no byte quota
+     * @param cameraRetentionDays 0 = global retention
+     */
+    void setCameraQuota(const std::string& cameraName, uint64_t maxBytes, int cameraRetentionDays) {
+        std::lock_guard<std::mutex> lock(quotaMutex);
+        if (maxBytes == 0 && cameraRetentionDays <= 0) {
+            cameraQuotas.erase(cameraName);
+            return;
+        }
+        cameraQuotas[cameraName] = {maxBytes, std::max(cameraRetentionDays, 0)};
+    }
+    
+    /**
+     * Xóa recordings cũ hơn retention days (global or per camera) and
+     * what cameras hold beyond their byte quota
+     *
+     * Expired segments are popped from the index and deleted in the
+     * background. Unhealthy volumes are left alone until they recover.
+     */
+    void cleanupOldRecordings() {
+        std::time_t now = std::time(nullptr);
+        std::time_t cutoff = retentionDays > 0 ? now - (std::time_t)retentionDays * 86400 : 0;
+        std::map<std::string, int> cameraRetention;
+        {
+            std::lock_guard<std::mutex> lock(quotaMutex);
+            for (const auto& item : cameraQuotas) {
+                if (item.second.retentionDays > 0) {
+                    cameraRetention[item.first] = item.second.retentionDays;
                 }
             }
-            
-            // Delete old files
-            if (!filesToDelete.empty()) {
-                Logger::info("Cleaning up " + std::to_string(fileCount) + 
-                           " old recordings (" + std::to_string(totalSize / (1024*1024)) + " MB)");
-                
-                for (const auto& file : filesToDelete) {
-                    try {
-                        fs::remove(file);
-                        Logger::debug("Deleted: " + file.filename().string());
-                    } catch (const std::exception& e) {
-                        Logger::error("Failed to delete " + file.string() + ": " + e.what());
-                    }
+        }
+        
+        std::vector<SegmentIndex::Segment> filesToDelete;
+        if (cutoff > 0 || !cameraRetention.empty()) {
+            auto expire = [&](StorageTier& tier) {
+                std::map<std::string, std::time_t> cutoffs;
+                for (const auto& item : cameraRetention) {
+                    cutoffs[tier.path + "/" + item.first] = now - (std::time_t)item.second * 86400;
                 }
-                
-                Logger::info("Cleanup completed. Freed " + 
-                           std::to_string(totalSize / (1024*1024*1024)) + " GB");
-            } else {
-                Logger::debug("No old recordings to cleanup");
+                std::vector<SegmentIndex::Segment> expired = tier.index.popOlderThan(cutoff, cutoffs);
+                std::move(expired.begin(), expired.end(), std::back_inserter(filesToDelete));
+            };
+            for (auto& volume : volumes) {
+                if (isHealthy(*volume)) expire(*volume);
             }
-            
-        } catch (const std::exception& e) {
-            Logger::error("Cleanup failed: " + std::string(e.what()));
+            for (auto& tier : lowerTiers) {
+                expire(*tier);
+            }
+        }
+        size_t expiredCount = filesToDelete.size();
+        
+        // Byte quotas: oldest data first, which lives on the slowest tier
+        std::map<std::string, uint64_t> overage = getQuotaOverage();
+        if (!overage.empty()) {
+            for (auto tier = lowerTiers.rbegin(); tier != lowerTiers.rend(); ++tier) {
+                popOverage(**tier, overage, MAX_EVICTION_SEGMENTS, filesToDelete);
+            }
+            for (auto& volume : volumes) {
+                if (isHealthy(*volume)) popOverage(*volume, overage, MAX_EVICTION_SEGMENTS, filesToDelete);
+            }
+        }
+        
+        if (filesToDelete.empty()) {
+            Logger::debug("No old recordings to cleanup");
+            return;
+        }
+        
+        uint64_t totalSize = 0;
+        for (const auto& file : filesToDelete) {
+            totalSize += file.size;
+        }
+        Logger::info("Cleaning up " + std::to_string(filesToDelete.size()) + 
+                   " old recordings (" + std::to_string(totalSize / (1024*1024)) + " MB, " +
+                   std::to_string(filesToDelete.size() - expiredCount) + " over quota)");
+        submitEviction(std::move(filesToDelete), "retention");
+    }
+    
+    /**
+     * Queue the oldest segments until free space (counting deletions
+     * already queued) reaches targetFreeBytes, on every healthy volume
+     *
+     * One statvfs per volume; free space is re-checked between batches
+     * and segments not needed go back to the index.
+     *
+     * Returns: bytes queued for deletion
+     */
+    uint64_t evictToFree(uint64_t targetFreeBytes, const std::string& reason) {
+        uint64_t queued = 0;
+        for (size_t i = 0; i < volumes.size(); i++) {
+            queued += evictVolumeToFree(i, targetFreeBytes, reason);
         }
+        return queued;
+    }
+    
+    /**
+     * Same for one hot volume (skipped while it is unhealthy: its
+     * unlinks would hold up the eviction thread)
+     */
+    uint64_t evictVolumeToFree(size_t volume, uint64_t targetFreeBytes, const std::string& reason) {
+        StorageTier& tier = *volumes.at(volume);
+        if (!isHealthy(tier)) return 0;
+        return evictFrom(tier, targetFreeBytes, reason);
+    }
+    
+    /**
+     * Same for a lower tier (TierMover making room before a move)
+     */
+    uint64_t evictTierToFree(const std::string& tier, uint64_t targetFreeBytes) {
+        StorageTier* lower = findLowerTier(tier);
+        if (!lower) return 0;
+        return evictFrom(*lower, targetFreeBytes, tier + " tier full");
     }
     
     /**
      * Emergency cleanup - xóa recordings cũ nhất khi disk đầy
-     * Returns: số GB đã giải phóng
+     * Returns: số GB đã lên lịch xóa
      */
     uint64_t emergencyCleanup(uint64_t targetFreeGB) {
         Logger::warn("Emergency cleanup triggered! Target: " + std::to_string(targetFreeGB) + "GB free");
-        
-        struct FileInfo {
-            fs::path path;
-            fs::file_time_type mtime;
-            uint64_t size;
-        };
-        
-        std::vector<FileInfo> allFiles;
-        
-        try {
-            // Collect all MP4 files with timestamps
-            for (const auto& cameraDir : fs::directory_iterator(recordingPath)) {
-                if (!fs::is_directory(cameraDir)) continue;
-                
-                for (const auto& entry : fs::directory_iterator(cameraDir)) {
-                    if (!entry.is_regular_file()) continue;
-                    if (entry.path().extension() != ".mp4") continue;
-                    
-                    allFiles.push_back({
-                        entry.path(),
-                        fs::last_write_time(entry),
-                        fs::file_size(entry)
-                    });
-                }
-            }
-            
-            // Sort by oldest first
-            std::sort(allFiles.begin(), allFiles.end(), 
-                     [](const FileInfo& a, const FileInfo& b) {
-                         return a.mtime < b.mtime;
-                     });
-            
-            // Delete oldest files until we have enough space
-            uint64_t freedBytes = 0;
-            uint64_t targetBytes = targetFreeGB * 1024ULL * 1024ULL * 1024ULL;
-            
-            for (const auto& file : allFiles) {
-                if (getFreeSpaceGB() >= targetFreeGB) {
-                    break;
-                }
-                
-                try {
-                    fs::remove(file.path);
-                    freedBytes += file.size;
-                    Logger::info("Emergency deleted: " + file.path.filename().string() + 
-                               " (" + std::to_string(file.size / (1024*1024)) + " MB)");
-                } catch (const std::exception& e) {
-                    Logger::error("Failed to delete " + file.path.string() + ": " + e.what());
-                }
-                
-                if (freedBytes >= targetBytes) {
-                    break;
-                }
-            }
-            
-            uint64_t freedGB = freedBytes / (1024ULL * 1024ULL * 1024ULL);
-            Logger::warn("Emergency cleanup freed " + std::to_string(freedGB) + " GB");
-            return freedGB;
-            
-        } catch (const std::exception& e) {
-            Logger::error("Emergency cleanup failed: " + std::string(e.what()));
-            return 0;
+        return evictToFree(targetFreeGB * GB, "emergency") / GB;
+    }
+    
+    uint64_t getEvictedBytes() const { return evictionEngine.getFreedBytes(); }
+    uint64_t getPendingEvictionBytes() const { return evictionEngine.getPendingBytes(); }
+    
+    uint64_t getMigratedOutBytes() const {
+        uint64_t bytes = 0;
+        for (const auto& volume : volumes) {
+            bytes += volume->migratedOutBytes;
         }
+        return bytes;
+    }
+    
+    /**
+     * Wait for queued deletions (startup only; the control loop never waits)
+     */
+    bool waitForEviction(std::chrono::milliseconds timeout) {
+        return evictionEngine.waitIdle(timeout);
     }
     
     /**
      * Lấy thông tin tổng quan storage
      */
     void logStorageInfo() {
-        struct statvfs stat;
-        if (statvfs(recordingPath.c_str(), &stat) != 0) {
+        uint64_t totalBytes = 0;
+        for (const auto& volume : volumes) {
+            struct statvfs stat;
+            if (statvfs(volume->path.c_str(), &stat) == 0) {
+                totalBytes += (uint64_t)stat.f_blocks * stat.f_frsize;
+            }
+        }
+        if (totalBytes == 0) {
             Logger::error("Cannot get storage info");
             return;
         }
         
-        uint64_t totalGB = (stat.f_blocks * stat.f_frsize) / (1024ULL * 1024ULL * 1024ULL);
+        uint64_t totalGB = totalBytes / GB;
         uint64_t freeGB = getFreeSpaceGB();
-        uint64_t usedGB = totalGB - freeGB;
+        uint64_t usedGB = totalGB - std::min(totalGB, freeGB);
         int usagePercent = getDiskUsagePercent();
         
         Logger::info("=== Storage Info ===");
@@ -248,8 +945,35 @@ public:
         Logger::info("Free: " + std::to_string(freeGB) + " GB");
         Logger::info("Retention: " + std::to_string(retentionDays) + " days");
         Logger::info("Min Free Required: " + std::to_string(minFreeSpaceGB) + " GB");
+        uint64_t indexedSegments = 0;
+        uint64_t indexedBytes = 0;
+        for (const auto& volume : volumes) {
+            indexedSegments += volume->index.getSegmentCount();
+            indexedBytes += volume->index.getTotalBytes();
+        }
+        Logger::info("Indexed: " + std::to_string(indexedSegments) + " segments (" +
+                   std::to_string(indexedBytes / GB) + " GB)");
+        Logger::info("Evicted: " + std::to_string(evictionEngine.getFilesDeleted()) + " segments, " +
+                   std::to_string(evictionEngine.getFreedBytes() / GB) + " GB (" +
+                   std::to_string(evictionEngine.getPendingBytes() / GB) + " GB pending, " +
+                   std::to_string(evictionEngine.getFilesFailed()) + " failed)");
+        if (volumes.size() > 1) {
+            for (const auto& volume : volumes) {
+                Logger::info("Volume " + volume->path + ": " + std::to_string(volume->index.getSegmentCount()) +
+                           " segments (" + std::to_string(volume->index.getTotalBytes() / GB) + " GB), " +
+                           std::to_string(freeBytesOf(*volume) / GB) + " GB free");
+            }
+        }
+        for (const auto& tier : lowerTiers) {
+            Logger::info("Tier " + tier->name + ": " + tier->path + ", " +
+                       std::to_string(tier->index.getSegmentCount()) + " segments (" +
+                       std::to_string(tier->index.getTotalBytes() / GB) + " GB), " +
+                       std::to_string(freeBytesAt(tier->path) / GB) + " GB free");
+        }
     }
     
+    uint64_t getMinFreeSpaceGB() const { return minFreeSpaceGB; }
+    
     /**
      * Set retention days (có thể thay đổi từ 2 → 30 ngày)
      */
@@ -264,4 +988,37 @@ public:
     }
     
     int getRetentionDays() const { return retentionDays; }
+    
+    /**
+     * Longest retention in force, global or per camera, 0 = some files
+     * are kept forever (bound of PartitionMaintainer's drops)
+     */
+    int getLongestRetentionDays() const {
+        if (retentionDays <= 0) return 0;
+        int longest = retentionDays;
+        std::lock_guard<std::mutex> lock(quotaMutex);
+        for (const auto& item : cameraQuotas) {
+            longest = std::max(longest, item.second.retentionDays);
+        }
+        return longest;
+    }
+    
+    /**
+     * Modification time of the oldest indexed segment on any tier, 0 =
+     * none (metadata of older recordings may go, PartitionMaintainer)
+     */
+    std::time_t getOldestSegmentTime() const {
+        std::time_t oldest = 0;
+        auto consider = [&oldest](const StorageTier& tier) {
+            std::time_t tierOldest = tier.index.getOldestTime();
+            if (tierOldest > 0 && (oldest == 0 || tierOldest < oldest)) oldest = tierOldest;
+        };
+        for (const auto& volume : volumes) {
+            consider(*volume);
+        }
+        for (const auto& tier : lowerTiers) {
+            consider(*tier);
+        }
+        return oldest;
+    }
 };
@@ -0,0 +1,217 @@
+#ifndef STORAGE_MONITOR_HPP
+#define STORAGE_MONITOR_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include "storage_manager.hpp"
+#include "logger.hpp"
+
+/**
+ * StorageMonitor - Disk consumption rate, time-to-full, predictive eviction
+ *
+ * Sampled every few seconds from the control loop:
+ * - Per camera ingest rate from the recorders' own byte counters
+ * - File system consumption rate from free space (one statvfs per
+ *   sample), corrected for what eviction freed meanwhile; covers
+ *   writers without counters (ffmpeg CLI) and anything else on the disk
+ *
+ * Both are kept per recording volume (camera rates summed by where
+ * StorageManager placed each camera). With rate = max(both),
+ * headroom = free - MIN_FREE_SPACE_GB: eviction on a volume starts when
+ * headroom < rate x horizon and frees up to 1.5 x rate x horizon. A
+ * burst of high-bitrate cameras shrinks the time-to-full and triggers
+ * eviction early, instead of waiting for an hourly sweep or for free
+ * space to cross the minimum. Camera rates also go back to
+ * StorageManager for placement.
+ *
+ * Retention (age-based) runs every minute; with the segment index it
+ * only costs the expired segments.
+ */
+class StorageMonitor {
+public:
+    struct CameraBytes {
+        std::string name;
+        uint64_t bytesWritten;      // Monotonic counter
+    };
+
+private:
+    static constexpr double RATE_WEIGHT = 0.3;          // EWMA weight of the newest sample
+    static constexpr double EVICTION_TARGET_FACTOR = 1.5;
+    static constexpr int RETENTION_SWEEP_SECONDS = 60;
+
+    struct CameraRate {
+        uint64_t lastBytes = 0;
+        double bytesPerSecond = 0;
+    };
+
+    struct VolumeRate {
+        uint64_t lastFree = 0;
+        uint64_t lastReleased = 0;
+        double fsRate = 0;
+        double timeToFull = -1;
+    };
+
+    std::shared_ptr<StorageManager> storage;
+    int horizonSeconds;
+    uint64_t reserveBytes;
+
+    std::unordered_map<std::string, CameraRate> cameras;
+    std::vector<VolumeRate> volumes;
+    std::chrono::steady_clock::time_point lastSample;
+    std::chrono::steady_clock::time_point lastSweep;
+    bool sampled;
+
+    double ingestRate;        // Sum of camera rates, bytes/s
+    double fsRate;            // Free space consumption of all volumes, bytes/s
+    double timeToFull;        // Seconds until the first volume is full, < 0 = not filling
+    std::string volumeSummary;
+    uint64_t predictiveEvictions;
+
+    static double smooth(double current, double sample) {
+        return current + (sample - current) * RATE_WEIGHT;
+    }
+
+    static std::string formatRate(double bytesPerSecond) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1f MB/s", bytesPerSecond / (1024.0 * 1024.0));
+        return buffer;
+    }
+
+    static std::string formatDuration(double seconds) {
+        if (seconds < 0) return "not filling";
+        char buffer[32];
+        if (seconds >= 86400) {
+            std::snprintf(buffer, sizeof(buffer), "%.1f d", seconds / 86400);
+        } else if (seconds >= 3600) {
+            std::snprintf(buffer, sizeof(buffer), "%.1f h", seconds / 3600);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%.0f min", seconds / 60);
+        }
+        return buffer;
+    }
+
+public:
+    /**
+     * @param horizonMinutes Keep at least this much recording time free
+     */
+    StorageMonitor(std::shared_ptr<StorageManager> storageManager, int horizonMinutes, uint64_t minFreeGB)
+        : storage(std::move(storageManager)), horizonSeconds(std::max(horizonMinutes, 1) * 60),
+          reserveBytes(minFreeGB * 1024ULL * 1024ULL * 1024ULL), sampled(false),
+          ingestRate(0), fsRate(0), timeToFull(-1), predictiveEvictions(0) {}
+
+    /**
+     * Take a sample and evict ahead of time if needed (control loop)
+     */
+    void sample(const std::vector<CameraBytes>& counters) {
+        auto now = std::chrono::steady_clock::now();
+        double dt = sampled ? std::chrono::duration<double>(now - lastSample).count() : 0;
+        if (sampled && dt <= 0) return;
+
+        std::map<std::string, double> cameraRates;
+        double total = 0;
+        for (const auto& counter : counters) {
+            CameraRate& rate = cameras[counter.name];
+            if (sampled && counter.bytesWritten >= rate.lastBytes) {
+                rate.bytesPerSecond = smooth(rate.bytesPerSecond, (counter.bytesWritten - rate.lastBytes) / dt);
+            }
+            rate.lastBytes = counter.bytesWritten;
+            cameraRates[counter.name] = rate.bytesPerSecond;
+            total += rate.bytesPerSecond;
+        }
+        ingestRate = total;
+        storage->updateIngestRates(cameraRates);
+
+        volumes.resize(storage->getVolumeCount());
+        double totalFsRate = 0;
+        double firstFull = -1;
+        std::string summary;
+        for (size_t i = 0; i < volumes.size(); i++) {
+            VolumeRate& volume = volumes[i];
+            StorageManager::VolumeStatus status = storage->getVolumeStatus(i);
+
+            if (sampled) {
+                // Consumed = drop in free space + what eviction and tier moves gave back meanwhile
+                double consumed = (double)volume.lastFree - (double)status.freeBytes +
+                                  (double)(status.releasedBytes - volume.lastReleased);
+                volume.fsRate = smooth(volume.fsRate, std::max(consumed, 0.0) / dt);
+            }
+            volume.lastFree = status.freeBytes;
+            volume.lastReleased = status.releasedBytes;
+
+            double rate = std::max(status.ingestRate, volume.fsRate);
+            double headroom = (double)status.freeBytes + (double)status.pendingBytes - (double)reserveBytes;
+            volume.timeToFull = rate > 0 ? std::max(headroom, 0.0) / rate : -1;
+            totalFsRate += volume.fsRate;
+            if (volume.timeToFull >= 0 && (firstFull < 0 || volume.timeToFull < firstFull)) {
+                firstFull = volume.timeToFull;
+            }
+
+            if (status.healthy && (headroom < rate * horizonSeconds || headroom < 0)) {
+                uint64_t target = reserveBytes + (uint64_t)(rate * horizonSeconds * EVICTION_TARGET_FACTOR);
+                if (storage->evictVolumeToFree(i, target, "predictive") > 0) {
+                    predictiveEvictions++;
+                    Logger::warn("Storage: " + status.path + " " + formatDuration(volume.timeToFull) +
+                                 " to full at " + formatRate(rate) + ", evicting ahead of time");
+                }
+            }
+
+            if (volumes.size() > 1) {
+                char latency[32];
+                std::snprintf(latency, sizeof(latency), "%.1f ms", status.latencyMs);
+                summary += (i == 0 ? "; volumes: " : ", ") + status.path + " " + formatRate(status.ingestRate) +
+                           " " + formatDuration(volume.timeToFull) + " " + latency +
+                           (status.healthy ? "" : " UNHEALTHY");
+            }
+        }
+        fsRate = totalFsRate;
+        timeToFull = firstFull;
+        volumeSummary = summary;
+
+        if (!sampled) {
+            lastSweep = now;
+            sampled = true;
+        }
+        lastSample = now;
+
+        if (now - lastSweep >= std::chrono::seconds(RETENTION_SWEEP_SECONDS)) {
+            lastSweep = now;
+            storage->cleanupOldRecordings();
+        }
+    }
+
+    double getIngestRate() const { return ingestRate; }
+    double getFileSystemRate() const { return fsRate; }
+    double getTimeToFullSeconds() const { return timeToFull; }
+    uint64_t getPredictiveEvictions() const { return predictiveEvictions; }
+
+    /**
+     * One line for the status log, with the heaviest writers
+     */
+    std::string getSummary() const {
+        std::vector<std::pair<double, std::string>> top;
+        for (const auto& item : cameras) {
+            top.emplace_back(item.second.bytesPerSecond, item.first);
+        }
+        size_t shown = std::min<size_t>(3, top.size());
+        std::partial_sort(top.begin(), top.begin() + shown, top.end(),
+                          [](const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) {
+                              return a.first > b.first;
+                          });
+
+        std::string summary = "ingest " + formatRate(ingestRate) + ", disk " + formatRate(fsRate) +
+                              ", time to full " + formatDuration(timeToFull) + ", " +
+                              std::to_string(predictiveEvictions) + " predictive evictions";
+        for (size_t i = 0; i < shown; i++) {
+            summary += (i == 0 ? "; top: " : ", ") + top[i].second + " " + formatRate(top[i].first);
+        }
+        return summary + volumeSummary;
+    }
+};
+
+#endif // STORAGE_MONITOR_HPP
@@ -3,7 +3,10 @@
 
 #include <string>
 #include <memory>
+#include <deque>
+#include <chrono>
 #include "logger.hpp"
+#include "sps_parser.hpp"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -21,6 +24,13 @@ extern "C" {
  * - Codec
  * 
  * Used to determine optimal encoding strategy per camera
+ *
+ * Fast path (H.264/H.265): the properties come from the SPS - SDP
+ * sprop-parameter-sets, or the first in-band SPS - instead of
+ * avformat_find_stream_info decoding frames for seconds. The RTSP
+ * session stays open in a Session, which LibavPipeline takes over, so
+ * a (re)connect costs one RTSP handshake instead of two. Other codecs
+ * fall back to avformat_find_stream_info with tight probe limits.
  */
 class StreamAnalyzer {
 public:
@@ -30,75 +40,162 @@ public:
         int height;
         double frameRate;
         std::string codec;
+        std::string profile;       // e.g. "High", "Main"
+        int level;
+        std::string chromaFormat;  // "4:2:0", "4:2:2", ...
+        int bitDepth;
         bool isJpegColorRange;  // true if yuvj420p
         bool isValid;
         
-        StreamInfo() : width(0), height(0), frameRate(0), 
+        StreamInfo() : width(0), height(0), frameRate(0), level(0), bitDepth(0),
                       isJpegColorRange(false), isValid(false) {}
     };
 
     /**
-     * Analyze RTSP stream and return properties
-     * 
-     * @param rtspUrl RTSP URL to analyze
-     * @param timeoutSeconds Timeout for analysis (default: 10 seconds)
-     * @return StreamInfo structure with detected properties
+     * Open RTSP session after analysis, handed to the recording pipeline
+     *
+     * Packets read while looking for an in-band SPS are kept and
+     * returned first by readPacket(), so the pipeline sees the stream
+     * from the start (keyframe included).
      */
-    static StreamInfo analyze(const std::string& rtspUrl, int timeoutSeconds = 10) {
+    class Session {
+    private:
+        AVFormatContext* formatCtx;
+        int videoStreamIndex;
+        std::deque<AVPacket*> buffered;
+
+    public:
         StreamInfo info;
-        AVFormatContext* formatCtx = nullptr;
-        
-        Logger::info("Analyzing stream: " + rtspUrl);
-        
-        // Set timeout
-        AVDictionary* opts = nullptr;
-        av_dict_set(&opts, "rtsp_transport", "tcp", 0);
-        av_dict_set(&opts, "timeout", std::to_string(timeoutSeconds * 1000000).c_str(), 0);
-        
-        // Open input
-        int ret = avformat_open_input(&formatCtx, rtspUrl.c_str(), nullptr, &opts);
-        av_dict_free(&opts);
-        
-        if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, sizeof(errbuf));
-            Logger::error("Failed to open stream: " + std::string(errbuf));
-            return info;
-        }
-        
-        // Find stream info
-        ret = avformat_find_stream_info(formatCtx, nullptr);
-        if (ret < 0) {
-            Logger::error("Failed to find stream info");
+        bool usedSps;   // Fast path (false = avformat_find_stream_info)
+
+        Session(AVFormatContext* ctx, int videoIndex)
+            : formatCtx(ctx), videoStreamIndex(videoIndex), usedSps(false) {}
+
+        ~Session() {
+            for (AVPacket* pkt : buffered) {
+                av_packet_free(&pkt);
+            }
             avformat_close_input(&formatCtx);
-            return info;
         }
-        
-        // Find video stream
-        int videoStreamIndex = -1;
-        for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
-            if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-                videoStreamIndex = i;
-                break;
+
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        void buffer(AVPacket* pkt) {
+            buffered.push_back(pkt);
+        }
+
+        /**
+         * Next packet: buffered ones first, then av_read_frame
+         */
+        int readPacket(AVPacket* pkt) {
+            if (!buffered.empty()) {
+                AVPacket* next = buffered.front();
+                buffered.pop_front();
+                av_packet_move_ref(pkt, next);
+                av_packet_free(&next);
+                return 0;
             }
+            return av_read_frame(formatCtx, pkt);
         }
-        
-        if (videoStreamIndex == -1) {
-            Logger::error("No video stream found");
-            avformat_close_input(&formatCtx);
-            return info;
+
+        AVFormatContext* getFormatContext() const { return formatCtx; }
+        int getVideoStreamIndex() const { return videoStreamIndex; }
+        size_t getBufferedPackets() const { return buffered.size(); }
+    };
+
+private:
+    static constexpr int SPS_SEARCH_PACKETS = 200;          // ~2 GOPs of a typical camera
+    static constexpr int SPS_SEARCH_MS = 3000;
+    static constexpr int FALLBACK_PROBE_SIZE = 512 * 1024;  // Bytes (libav default 5 MB)
+    static constexpr int FALLBACK_ANALYZE_US = 1000000;     // 1 s (libav default 5 s)
+
+    /**
+     * SPS from the SDP (extradata), else from the first packets
+     */
+    static bool findSps(Session& session, SpsParser::SpsInfo& sps) {
+        AVFormatContext* formatCtx = session.getFormatContext();
+        const AVStream* video = formatCtx->streams[session.getVideoStreamIndex()];
+        AVCodecID codecId = video->codecpar->codec_id;
+        if (!SpsParser::isSupported(codecId)) {
+            return false;
         }
-        
-        // Get stream parameters
-        AVStream* videoStream = formatCtx->streams[videoStreamIndex];
-        AVCodecParameters* codecpar = videoStream->codecpar;
+        if (SpsParser::findSps(video->codecpar->extradata, video->codecpar->extradata_size, codecId, sps)) {
+            return true;
+        }
+
+        // No sprop-parameter-sets: cameras repeat the SPS before every IDR
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SPS_SEARCH_MS);
+        for (int i = 0; i < SPS_SEARCH_PACKETS && std::chrono::steady_clock::now() < deadline; i++) {
+            AVPacket* pkt = av_packet_alloc();
+            if (!pkt || av_read_frame(formatCtx, pkt) < 0) {
+                av_packet_free(&pkt);
+                return false;
+            }
+            bool found = pkt->stream_index == video->index &&
+                         SpsParser::findSps(pkt->data, pkt->size, codecId, sps);
+            session.buffer(pkt);
+            if (found) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Fill the codec parameters find_stream_info would have set
+     */
+    static void applySps(AVStream* video, const SpsParser::SpsInfo& sps) {
+        AVCodecParameters* codecpar = video->codecpar;
+        codecpar->width = sps.width;
+        codecpar->height = sps.height;
+        codecpar->profile = sps.profile;
+        codecpar->level = sps.level;
+        codecpar->format = SpsParser::toPixelFormat(sps);
+        codecpar->color_range = sps.fullRange ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+        if (sps.frameRate > 0 && sps.frameRate <= 240) {
+            AVRational rate = av_d2q(sps.frameRate, 1001000);
+            if (video->avg_frame_rate.num == 0) video->avg_frame_rate = rate;
+            if (video->r_frame_rate.num == 0) video->r_frame_rate = rate;
+        }
+    }
+
+    static void logInfo(const StreamInfo& info, const std::string& method) {
+        Logger::info("Stream analysis complete (" + method + "):");
+        Logger::info("  Resolution: " + std::to_string(info.width) + "x" + std::to_string(info.height));
+        Logger::info("  Frame rate: " + std::to_string(info.frameRate) + " fps");
+        Logger::info("  Codec: " + info.codec + (info.profile.empty() ? "" : " " + info.profile) +
+                     (info.level > 0 ? " level " + std::to_string(info.level) : ""));
+        Logger::info("  Pixel format: " + info.pixelFormat + (info.chromaFormat.empty() ? "" :
+                     " (" + info.chromaFormat + ", " + std::to_string(info.bitDepth) + "-bit)"));
+        if (info.isJpegColorRange) {
+            Logger::warn("  ⚠️  JPEG color range detected - will use optimized encoding");
+        }
+    }
+
+public:
+    /**
+     * Extract properties from an already opened video stream
+     * 
+     * @param videoStream Stream after avformat_find_stream_info
+     * @return StreamInfo (isValid is left to the caller)
+     */
+    static StreamInfo fromStream(const AVStream* videoStream) {
+        StreamInfo info;
+        const AVCodecParameters* codecpar = videoStream->codecpar;
         
         // Extract information
         info.width = codecpar->width;
         info.height = codecpar->height;
+        info.level = codecpar->level;
+        const char* profileName = avcodec_profile_name(codecpar->codec_id, codecpar->profile);
+        if (profileName) {
+            info.profile = profileName;
+        }
         
         // Frame rate
-        if (videoStream->avg_frame_rate.den != 0) {
+        if (videoStream->avg_frame_rate.num > 0 && videoStream->avg_frame_rate.den > 0) {
             info.frameRate = (double)videoStream->avg_frame_rate.num / videoStream->avg_frame_rate.den;
         } else {
             info.frameRate = 25.0;  // Default
@@ -117,29 +214,111 @@ public:
             
             // Check if JPEG color range (yuvj420p, yuvj422p, yuvj444p)
             std::string pixFmt = info.pixelFormat;
-            info.isJpegColorRange = (pixFmt.find("yuvj") == 0);
+            info.isJpegColorRange = (pixFmt.find("yuvj") == 0) || codecpar->color_range == AVCOL_RANGE_JPEG;
+
+            const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get((AVPixelFormat)codecpar->format);
+            if (desc) {
+                info.bitDepth = desc->comp[0].depth;
+                info.chromaFormat = desc->nb_components < 3 ? "4:0:0" :
+                                    desc->log2_chroma_w == 0 ? "4:4:4" :
+                                    desc->log2_chroma_h == 0 ? "4:2:2" : "4:2:0";
+            }
         } else {
             info.pixelFormat = "unknown";
         }
         
-        info.isValid = true;
-        
-        // Log results
-        Logger::info("Stream analysis complete:");
-        Logger::info("  Resolution: " + std::to_string(info.width) + "x" + std::to_string(info.height));
-        Logger::info("  Frame rate: " + std::to_string(info.frameRate) + " fps");
-        Logger::info("  Codec: " + info.codec);
-        Logger::info("  Pixel format: " + info.pixelFormat);
-        if (info.isJpegColorRange) {
-            Logger::warn("  ⚠️  JPEG color range detected - will use optimized encoding");
-        }
-        
-        // Cleanup
-        avformat_close_input(&formatCtx);
-        
         return info;
     }
     
+    /**
+     * Open an RTSP session and analyze it, keeping the session open
+     *
+     * @param rtspUrl RTSP URL to analyze
+     * @param timeoutSeconds Socket timeout
+     * @param interrupt Interrupt callback for the session (nullptr = none)
+     * @return Open session with info filled in, nullptr on failure
+     */
+    static std::unique_ptr<Session> openSession(const std::string& rtspUrl, int timeoutSeconds,
+                                                const AVIOInterruptCB* interrupt = nullptr) {
+        auto started = std::chrono::steady_clock::now();
+        AVFormatContext* formatCtx = avformat_alloc_context();
+        if (!formatCtx) return nullptr;
+        if (interrupt) {
+            formatCtx->interrupt_callback = *interrupt;
+        }
+
+        // Limits only matter for the avformat_find_stream_info fallback
+        AVDictionary* opts = nullptr;
+        av_dict_set(&opts, "rtsp_transport", "tcp", 0);
+        av_dict_set(&opts, "timeout", std::to_string(timeoutSeconds * 1000000LL).c_str(), 0);
+        av_dict_set(&opts, "probesize", std::to_string(FALLBACK_PROBE_SIZE).c_str(), 0);
+        av_dict_set(&opts, "analyzeduration", std::to_string(FALLBACK_ANALYZE_US).c_str(), 0);
+
+        int ret = avformat_open_input(&formatCtx, rtspUrl.c_str(), nullptr, &opts);
+        av_dict_free(&opts);
+        if (ret < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            Logger::error("Failed to open stream: " + std::string(errbuf));
+            return nullptr;
+        }
+
+        int videoIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (videoIndex < 0) {
+            Logger::error("No video stream found");
+            avformat_close_input(&formatCtx);
+            return nullptr;
+        }
+
+        std::unique_ptr<Session> session(new Session(formatCtx, videoIndex));
+        AVStream* video = formatCtx->streams[videoIndex];
+
+        SpsParser::SpsInfo sps;
+        if (findSps(*session, sps)) {
+            applySps(video, sps);
+            session->usedSps = true;
+        } else {
+            if (SpsParser::isSupported(video->codecpar->codec_id)) {
+                Logger::warn("No usable SPS in SDP or first packets, probing with find_stream_info");
+            }
+            ret = avformat_find_stream_info(formatCtx, nullptr);
+            if (ret < 0) {
+                Logger::error("Failed to find stream info");
+                return nullptr;
+            }
+        }
+
+        session->info = fromStream(video);
+        if (session->usedSps) {
+            session->info.chromaFormat = SpsParser::chromaFormatName(sps.chromaFormatIdc);
+            session->info.bitDepth = sps.bitDepth;
+        }
+        session->info.isValid = session->info.width > 0 && session->info.height > 0;
+
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        logInfo(session->info, std::string(session->usedSps ? "SPS" : "find_stream_info") + ", " +
+                std::to_string(elapsedMs) + " ms");
+        return session;
+    }
+
+    /**
+     * Analyze RTSP stream and return properties
+     * 
+     * @param rtspUrl RTSP URL to analyze
+     * @param timeoutSeconds Timeout for analysis (default: 10 seconds)
+     * @return StreamInfo structure with detected properties
+     */
+    static StreamInfo analyze(const std::string& rtspUrl, int timeoutSeconds = 10) {
+        Logger::info("Analyzing stream: " + rtspUrl);
+
+        std::unique_ptr<Session> session = openSession(rtspUrl, timeoutSeconds);
+        if (!session) {
+            return StreamInfo();
+        }
+        return session->info;
+    }
+    
     /**
      * Get recommended bitrate based on resolution
      * 
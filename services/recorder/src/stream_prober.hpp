@@ -0,0 +1,236 @@
+#ifndef STREAM_PROBER_HPP
+#define STREAM_PROBER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cmath>
+#include <algorithm>
+#include "stream_analyzer.hpp"
+#include "probe_cache.hpp"
+#include "logger.hpp"
+
+/**
+ * StreamProber - Bounded worker pool for StreamAnalyzer::analyze()
+ *
+ * Probing used to run synchronously in every FFmpegMultiOutput
+ * constructor (up to 10 s per camera, on every restart). Now:
+ * - Probes run on a fixed number of workers, concurrently across cameras
+ * - Results go to a ProbeCache keyed by RTSP URL; a restart (or a
+ *   process restart, the cache is persistent) uses the cached value
+ *   straight away and revalidates it once in the background
+ * - Concurrent requests for the same URL share one probe
+ *
+ * Callbacks run on a worker thread; callers hop back to their own
+ * thread (reactor loop) before touching their state.
+ */
+class StreamProber {
+public:
+    using ProbeCallback = std::function<void(const StreamAnalyzer::StreamInfo&)>;
+
+private:
+    static constexpr int PROBE_TIMEOUT_SECONDS = 10;
+
+    ProbeCache cache;
+    size_t workerCount;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::string> queue;
+    std::unordered_map<std::string, std::vector<ProbeCallback>> pending;  // Queued or in flight
+    std::unordered_set<std::string> revalidated;                          // Probed by this process
+    size_t activeProbes;
+    bool stopping;
+
+    std::atomic<uint64_t> probesRun;
+    std::atomic<uint64_t> probesFailed;
+    std::atomic<uint64_t> cacheHits;
+    std::atomic<uint64_t> cacheMisses;
+
+    /**
+     * Codec, resolution, pix_fmt or fps differ
+     */
+    static bool propertiesChanged(const StreamAnalyzer::StreamInfo& a, const StreamAnalyzer::StreamInfo& b) {
+        return a.codec != b.codec || a.width != b.width || a.height != b.height ||
+               a.pixelFormat != b.pixelFormat || std::fabs(a.frameRate - b.frameRate) > 0.5;
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+
+            std::string url = queue.front();
+            queue.pop_front();
+            activeProbes++;
+            lock.unlock();
+
+            StreamAnalyzer::StreamInfo info = StreamAnalyzer::analyze(url, PROBE_TIMEOUT_SECONDS);
+            probesRun++;
+            if (info.isValid) {
+                cache.put(url, info);
+            } else {
+                probesFailed++;
+            }
+
+            lock.lock();
+            std::vector<ProbeCallback> callbacks = std::move(pending[url]);
+            pending.erase(url);
+            activeProbes--;
+            bool idle = queue.empty() && activeProbes == 0;
+            lock.unlock();
+
+            for (auto& callback : callbacks) {
+                callback(info);
+            }
+
+            // Persist once per burst (fleet startup), not once per camera
+            if (idle) {
+                cache.save();
+            }
+            lock.lock();
+        }
+    }
+
+    void enqueue(const std::string& url, ProbeCallback callback) {
+        std::lock_guard<std::mutex> lock(mutex);
+        revalidated.insert(url);
+        auto it = pending.find(url);
+        if (it != pending.end()) {
+            it->second.push_back(std::move(callback));
+            return;
+        }
+        pending[url].push_back(std::move(callback));
+        queue.push_back(url);
+        cv.notify_one();
+    }
+
+public:
+    /**
+     * @param cachePath Probe cache file
+     * @param threads Number of concurrent probes
+     */
+    StreamProber(const std::string& cachePath, size_t threads)
+        : cache(cachePath), workerCount(std::max<size_t>(threads, 1)), activeProbes(0), stopping(false),
+          probesRun(0), probesFailed(0), cacheHits(0), cacheMisses(0) {}
+
+    ~StreamProber() {
+        stop();
+    }
+
+    StreamProber(const StreamProber&) = delete;
+    StreamProber& operator=(const StreamProber&) = delete;
+
+    void start() {
+        if (!workers.empty()) return;
+
+        size_t loaded = cache.load();
+        Logger::info("Stream prober: " + std::to_string(workerCount) + " workers, " +
+                     std::to_string(loaded) + " cached streams (" + cache.getPath() + ")");
+
+        stopping = false;
+        for (size_t i = 0; i < workerCount; i++) {
+            workers.emplace_back(&StreamProber::workerLoop, this);
+        }
+    }
+
+    /**
+     * Stop the workers (queued probes are dropped) and persist the cache
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (workers.empty()) return;
+            stopping = true;
+            queue.clear();
+        }
+        cv.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        pending.clear();
+        cache.save();
+    }
+
+    /**
+     * Cached properties for a URL
+     *
+     * The first hit per URL in this process queues a background probe;
+     * onChanged runs (worker thread) if the camera now reports different
+     * properties. The cache is updated either way.
+     *
+     * @return false if the URL was never probed, use probe()
+     */
+    bool lookup(const std::string& url, StreamAnalyzer::StreamInfo& info, ProbeCallback onChanged) {
+        ProbeCache::Entry entry;
+        if (!cache.get(url, entry)) {
+            cacheMisses++;
+            return false;
+        }
+        cacheHits++;
+        info = entry.info;
+
+        bool revalidate;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            revalidate = revalidated.find(url) == revalidated.end();
+        }
+        if (revalidate) {
+            StreamAnalyzer::StreamInfo cached = entry.info;
+            enqueue(url, [cached, onChanged](const StreamAnalyzer::StreamInfo& fresh) {
+                if (fresh.isValid && propertiesChanged(cached, fresh) && onChanged) {
+                    onChanged(fresh);
+                }
+            });
+        }
+        return true;
+    }
+
+    /**
+     * Probe a URL on the pool; callback gets the result (isValid = false
+     * if the stream could not be analyzed)
+     */
+    void probe(const std::string& url, ProbeCallback callback) {
+        enqueue(url, std::move(callback));
+    }
+
+    /**
+     * Record properties found by a pipeline that probes its own session
+     */
+    void store(const std::string& url, const StreamAnalyzer::StreamInfo& info) {
+        cache.put(url, info);
+    }
+
+    /**
+     * Write pending cache updates
+     */
+    void flush() {
+        cache.save();
+    }
+
+    std::string getStats() {
+        size_t queued;
+        size_t active;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued = queue.size();
+            active = activeProbes;
+        }
+        return std::to_string(cache.size()) + " cached, " + std::to_string(cacheHits) + " hits, " +
+               std::to_string(cacheMisses) + " misses, " + std::to_string(probesRun) + " probes (" +
+               std::to_string(probesFailed) + " failed), " + std::to_string(active) + " active, " +
+               std::to_string(queued) + " queued";
+    }
+};
+
+#endif // STREAM_PROBER_HPP
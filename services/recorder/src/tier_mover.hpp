@@ -0,0 +1,366 @@
+#ifndef TIER_MOVER_HPP
+#define TIER_MOVER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sendfile.h>
+#include <sys/resource.h>
+#include <linux/ioprio.h>
+#include "storage_manager.hpp"
+#include "database_pool.hpp"
+#include "logger.hpp"
+
+/**
+ * TierMover - Moves aged segments from the hot volumes to warm/cold tiers
+ *
+ * One background thread at idle I/O priority (and nice 19), so
+ * recording writes always win the disk. Per segment:
+ * 1. copy_file_range into a hidden .part file on the target tier
+ *    (sendfile where the kernel refuses cross-file-system ranges),
+ *    throttled to TIER_MOVE_MBPS across all moves
+ * 2. fsync, keep the original mtime, rename into place
+ * 3. UPDATE recordings SET filepath, storage_tier in one statement
+ * 4. unlink the source
+ *
+ * A crash between any two steps leaves the source in place and the row
+ * pointing at a file that exists; the next pass redoes the move.
+ * Sidecars (chunk offset index, keyframe index) are copied first, so
+ * the moved file is never without them. Chunk files move as a whole;
+ * the UPDATE repoints every segment row of the chunk at once.
+ * Segments are taken from the index in small batches, oldest first, so
+ * eviction still sees everything that is not being copied right now.
+ */
+class TierMover {
+public:
+    struct Settings {
+        int warmAfterHours = 24;
+        int coldAfterDays = 7;
+        int bandwidthMBps = 50;
+    };
+
+private:
+    static constexpr size_t BATCH_SEGMENTS = 16;
+    static constexpr size_t COPY_CHUNK_BYTES = 4 * 1024 * 1024;
+    static constexpr int IDLE_POLL_SECONDS = 60;
+
+    struct Stage {
+        std::string from;
+        std::string to;
+        int afterSeconds;
+    };
+
+    enum class MoveResult { MOVED, GONE, FAILED };
+
+    std::shared_ptr<StorageManager> storage;
+    std::shared_ptr<DatabasePool> pool;
+    Settings settings;
+    std::vector<Stage> stages;
+    uint64_t reserveBytes;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+
+    bool useCopyFileRange;
+    std::chrono::steady_clock::time_point nextChunkTime;   // Bandwidth cap, shared by all moves
+
+    std::atomic<uint64_t> segmentsMoved;
+    std::atomic<uint64_t> bytesMoved;
+    std::atomic<uint64_t> segmentsFailed;
+
+    /**
+     * Sleep that stop() cuts short; false = stopping
+     */
+    bool sleepUntil(std::chrono::steady_clock::time_point when) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return !cv.wait_until(lock, when, [this] { return stopping; });
+    }
+
+    bool isStopping() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stopping;
+    }
+
+    static void setIdlePriority() {
+        // ioprio and nice are per thread on Linux (who = 0: calling thread)
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)) != 0) {
+            Logger::warn("TierMover: cannot set idle I/O priority: " + std::string(strerror(errno)));
+        }
+        if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19) != 0) {
+            Logger::debug("TierMover: cannot lower CPU priority");
+        }
+    }
+
+    /**
+     * Copy size bytes from in to out at the configured rate
+     */
+    bool copyThrottled(int in, int out, uint64_t size) {
+        double bytesPerSecond = std::max(settings.bandwidthMBps, 1) * 1024.0 * 1024.0;
+        uint64_t copied = 0;
+
+        while (copied < size) {
+            size_t chunk = (size_t)std::min<uint64_t>(COPY_CHUNK_BYTES, size - copied);
+            ssize_t n = -1;
+            if (useCopyFileRange) {
+                n = copy_file_range(in, nullptr, out, nullptr, chunk, 0);
+                if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                    Logger::info("TierMover: copy_file_range not usable between tiers, using sendfile");
+                    useCopyFileRange = false;
+                }
+            }
+            if (!useCopyFileRange) {
+                n = sendfile(out, in, nullptr, chunk);
+            }
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                Logger::error("TierMover: copy failed: " + std::string(strerror(errno)));
+                return false;
+            }
+            if (n == 0) break;   // Source shorter than its stat said
+            copied += (uint64_t)n;
+
+            auto now = std::chrono::steady_clock::now();
+            nextChunkTime = std::max(nextChunkTime, now) +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(n / bytesPerSecond));
+            if (nextChunkTime > now && !sleepUntil(nextChunkTime)) {
+                return false;
+            }
+        }
+        return copied == size;
+    }
+
+    /**
+     * Copy into place on the target tier: hidden .part, fsync, same
+     * mtime, rename (target directory must exist)
+     */
+    MoveResult copyFile(const std::string& source, const std::string& targetPath) {
+        size_t slash = targetPath.rfind('/');
+        std::string partPath = targetPath.substr(0, slash) + "/." + targetPath.substr(slash + 1) + ".part";
+
+        int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            if (errno == ENOENT) return MoveResult::GONE;
+            Logger::error("TierMover: cannot open " + source + ": " + strerror(errno));
+            return MoveResult::FAILED;
+        }
+        struct stat st;
+        if (fstat(in, &st) != 0) {
+            close(in);
+            return MoveResult::FAILED;
+        }
+        posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        int out = open(partPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out < 0) {
+            Logger::error("TierMover: cannot create " + partPath + ": " + strerror(errno));
+            close(in);
+            return MoveResult::FAILED;
+        }
+
+        bool ok = copyThrottled(in, out, (uint64_t)st.st_size) && fsync(out) == 0;
+        if (ok) {
+            // Same mtime on the new tier: index order and retention stay the same
+            timespec times[2] = {st.st_atim, st.st_mtim};
+            futimens(out, times);
+        }
+        // Migration traffic must not push recent video out of the page cache
+        posix_fadvise(in, 0, 0, POSIX_FADV_DONTNEED);
+        posix_fadvise(out, 0, 0, POSIX_FADV_DONTNEED);
+        close(in);
+        close(out);
+
+        if (!ok || rename(partPath.c_str(), targetPath.c_str()) != 0) {
+            unlink(partPath.c_str());
+            return MoveResult::FAILED;
+        }
+        return MoveResult::MOVED;
+    }
+
+    MoveResult moveSegment(const Stage& stage, const SegmentIndex::Segment& segment,
+                           std::string& targetPath, std::string& targetDir) {
+        std::string fromRoot = storage->getVolumeRoot(segment.path);   // Hot tier: one of several volumes
+        if (segment.path.compare(0, fromRoot.size(), fromRoot) != 0) {
+            return MoveResult::FAILED;
+        }
+        std::string relative = segment.path.substr(fromRoot.size());   // /<camera>/<file>.mp4
+        targetPath = storage->getTierPath(stage.to) + relative;
+        targetDir = targetPath.substr(0, targetPath.rfind('/'));
+        std::error_code ec;
+        fs::create_directories(targetDir, ec);
+
+        std::vector<std::string> sidecars = SegmentIndex::sidecarsOf(segment.path);
+        std::vector<std::string> targetSidecars = SegmentIndex::sidecarsOf(targetPath);
+        MoveResult copied = MoveResult::MOVED;
+        for (size_t i = 0; i < sidecars.size() && copied != MoveResult::FAILED; i++) {
+            copied = copyFile(sidecars[i], targetSidecars[i]);   // GONE: file has no such sidecar
+        }
+        if (copied != MoveResult::FAILED) {
+            copied = copyFile(segment.path, targetPath);
+        }
+
+        // The row follows the file; if it cannot, the copy goes away again
+        if (copied == MoveResult::MOVED) {
+            DatabasePool::Lease database = pool->acquire();
+            if (!database || database->updateRecordingLocation(segment.path, targetPath, stage.to) < 0) {
+                unlink(targetPath.c_str());
+                copied = MoveResult::FAILED;
+            }
+        }
+        if (copied != MoveResult::MOVED) {
+            for (const auto& sidecar : targetSidecars) {
+                unlink(sidecar.c_str());
+            }
+            return copied;
+        }
+
+        if (unlink(segment.path.c_str()) != 0 && errno != ENOENT) {
+            Logger::warn("TierMover: moved " + segment.path + " but cannot delete it: " + strerror(errno));
+        }
+        for (const auto& sidecar : sidecars) {
+            unlink(sidecar.c_str());
+        }
+        return MoveResult::MOVED;
+    }
+
+    /**
+     * Move one batch of a stage; returns segments moved
+     */
+    size_t runStage(const Stage& stage) {
+        std::time_t cutoff = std::time(nullptr) - stage.afterSeconds;
+        std::vector<SegmentIndex::Segment> batch = storage->takeForMigration(stage.from, cutoff, BATCH_SEGMENTS);
+        if (batch.empty()) return 0;
+
+        auto started = std::chrono::steady_clock::now();
+        size_t moved = 0;
+        uint64_t movedBytes = 0;
+        size_t next = 0;
+        for (; next < batch.size(); next++) {
+            if (isStopping()) break;
+            const SegmentIndex::Segment& segment = batch[next];
+
+            // Room on the target tier: evict its oldest, retry the batch later
+            if (storage->getTierFreeBytes(stage.to) < reserveBytes + segment.size) {
+                storage->evictTierToFree(stage.to, reserveBytes + BATCH_SEGMENTS * segment.size);
+                break;
+            }
+
+            std::string targetPath, targetDir;
+            MoveResult result = moveSegment(stage, segment, targetPath, targetDir);
+            if (result == MoveResult::MOVED) {
+                storage->onSegmentMigrated(segment.path, stage.to, targetDir,
+                                           {targetPath, segment.mtime, segment.size});
+                moved++;
+                movedBytes += segment.size;
+                segmentsMoved++;
+                bytesMoved += segment.size;
+            } else if (result == MoveResult::FAILED) {
+                storage->returnSegments({segment});
+                if (isStopping()) {
+                    next++;
+                    break;
+                }
+                segmentsFailed++;
+            }
+            // GONE: deleted under us (retention), nothing to track
+        }
+        if (next < batch.size()) {
+            storage->returnSegments(std::vector<SegmentIndex::Segment>(batch.begin() + next, batch.end()));
+        }
+
+        if (moved > 0) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            Logger::info("Tier move " + stage.from + " -> " + stage.to + ": " + std::to_string(moved) +
+                         " segments, " + std::to_string(movedBytes / (1024 * 1024)) + " MB in " +
+                         std::to_string((int)seconds) + " s");
+        }
+        return moved;
+    }
+
+    void workerLoop() {
+        setIdlePriority();
+
+        while (!isStopping()) {
+            size_t moved = 0;
+            for (const auto& stage : stages) {
+                moved += runStage(stage);
+            }
+            if (moved == 0 &&
+                !sleepUntil(std::chrono::steady_clock::now() + std::chrono::seconds(IDLE_POLL_SECONDS))) {
+                break;
+            }
+        }
+    }
+
+public:
+    TierMover(std::shared_ptr<DatabasePool> databasePool, std::shared_ptr<StorageManager> storageManager,
+              const Settings& tierSettings)
+        : storage(std::move(storageManager)), pool(std::move(databasePool)), settings(tierSettings),
+          reserveBytes(storage->getMinFreeSpaceGB() * 1024ULL * 1024ULL * 1024ULL), stopping(false),
+          useCopyFileRange(true), segmentsMoved(0), bytesMoved(0), segmentsFailed(0) {
+        // hot -> warm -> cold; a missing tier is skipped
+        std::string from = "hot";
+        if (storage->hasTier("warm")) {
+            stages.push_back({from, "warm", std::max(settings.warmAfterHours, 1) * 3600});
+            from = "warm";
+        }
+        if (storage->hasTier("cold")) {
+            stages.push_back({from, "cold", std::max(settings.coldAfterDays, 1) * 86400});
+        }
+    }
+
+    ~TierMover() {
+        stop();
+    }
+
+    TierMover(const TierMover&) = delete;
+    TierMover& operator=(const TierMover&) = delete;
+
+    /**
+     * @return false if no lower tier is configured
+     */
+    bool start() {
+        if (stages.empty() || worker.joinable()) return false;
+        for (const auto& stage : stages) {
+            Logger::info("Tier mover: " + stage.from + " -> " + stage.to + " after " +
+                         std::to_string(stage.afterSeconds / 3600) + " h, " +
+                         std::to_string(settings.bandwidthMBps) + " MB/s cap");
+        }
+        worker = std::thread(&TierMover::workerLoop, this);
+        return true;
+    }
+
+    /**
+     * Stop after the current chunk (the partial copy is discarded)
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    uint64_t getSegmentsMoved() const { return segmentsMoved; }
+    uint64_t getBytesMoved() const { return bytesMoved; }
+    uint64_t getSegmentsFailed() const { return segmentsFailed; }
+};
+
+#endif // TIER_MOVER_HPP
@@ -0,0 +1,258 @@
+#ifndef VIDEO_ENCODER_HPP
+#define VIDEO_ENCODER_HPP
+
+#include <string>
+#include <memory>
+#include <functional>
+#include "libav_common.hpp"
+#include "logger.hpp"
+#include "video_filter.hpp"
+
+/**
+ * VideoEncoder - Optional per-output filter + encoder
+ *
+ * Replaces one `-vf ... -c:v ...` output of the ffmpeg CLI. Frames
+ * normally arrive already converted by the pipeline's shared stage
+ * (format/hwupload done once), so most outputs have no filter at all
+ * and feed the encoder directly; only per-output work such as `fps`
+ * or scaling for live is filtered here.
+ *
+ * The encoder is opened lazily from the first frame. Encoded packets
+ * are delivered through the packet callback with timestamps in
+ * getTimeBase().
+ */
+class VideoEncoder {
+public:
+    struct Settings {
+        std::string encoderName;      // hevc_nvenc, h264_nvenc, h264_vaapi, libx264
+        std::string softwareFilter;   // Filter chain for system memory frames ("" = none)
+        std::string hardwareFilter;   // Filter chain for hardware frames ("" = none)
+        int bitrateMbps;
+        bool constrainedBitrate;      // -maxrate/-bufsize (live output)
+        bool lowLatency;              // -tune ll / zerolatency
+        int gopSize;                  // 0 = encoder default
+        bool globalHeader;            // MP4 needs extradata in the header
+        AVBufferRef* hwDevice;        // Borrowed, for hwupload (VAAPI)
+
+        Settings() : bitrateMbps(2), constrainedBitrate(false), lowLatency(false),
+                     gopSize(0), globalHeader(false), hwDevice(nullptr) {}
+    };
+
+    using PacketCallback = std::function<void(AVPacket*)>;
+
+private:
+    std::string cameraName;
+    Settings settings;
+    AVRational inputTimeBase;
+    AVRational inputFrameRate;
+
+    std::unique_ptr<VideoFilter> filter;
+    bool filterChecked;
+    AVCodecContext* encoderCtx;
+    AVFrame* filteredFrame;
+    AVPacket* packet;
+    bool failed;
+
+    PacketCallback onPacket;
+
+    bool initEncoder(const AVFrame* frame) {
+        const AVCodec* codec = avcodec_find_encoder_by_name(settings.encoderName.c_str());
+        if (!codec) {
+            Logger::error("VideoEncoder: encoder " + settings.encoderName + " not available");
+            return false;
+        }
+
+        encoderCtx = avcodec_alloc_context3(codec);
+        if (!encoderCtx) return false;
+
+        AVBufferRef* hwFrames = nullptr;
+        if (filter) {
+            encoderCtx->width = filter->getWidth();
+            encoderCtx->height = filter->getHeight();
+            encoderCtx->pix_fmt = filter->getFormat();
+            encoderCtx->sample_aspect_ratio = filter->getSampleAspectRatio();
+            encoderCtx->time_base = filter->getTimeBase();
+            AVRational frameRate = filter->getFrameRate();
+            if (frameRate.num > 0 && frameRate.den > 0) {
+                encoderCtx->framerate = frameRate;
+            }
+            hwFrames = filter->getHwFramesContext();
+        } else {
+            encoderCtx->width = frame->width;
+            encoderCtx->height = frame->height;
+            encoderCtx->pix_fmt = (AVPixelFormat)frame->format;
+            encoderCtx->sample_aspect_ratio = frame->sample_aspect_ratio;
+            encoderCtx->time_base = inputTimeBase;
+            if (inputFrameRate.num > 0 && inputFrameRate.den > 0) {
+                encoderCtx->framerate = inputFrameRate;
+            }
+            hwFrames = frame->hw_frames_ctx;
+        }
+        if (hwFrames) {
+            encoderCtx->hw_frames_ctx = av_buffer_ref(hwFrames);
+        }
+
+        int64_t bitrate = (int64_t)settings.bitrateMbps * 1000000;
+        encoderCtx->bit_rate = bitrate;
+        if (settings.constrainedBitrate) {
+            encoderCtx->rc_max_rate = bitrate;
+            encoderCtx->rc_buffer_size = (int)(bitrate * 2);
+        }
+        if (settings.gopSize > 0) {
+            encoderCtx->gop_size = settings.gopSize;
+        }
+        if (settings.globalHeader) {
+            encoderCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+
+        AVDictionary* opts = nullptr;
+        bool isNvenc = settings.encoderName.find("nvenc") != std::string::npos;
+        bool isX264 = settings.encoderName == "libx264";
+        if (isNvenc) {
+            av_dict_set(&opts, "preset", "p4", 0);
+            if (settings.lowLatency) av_dict_set(&opts, "tune", "ll", 0);
+        } else if (isX264) {
+            av_dict_set(&opts, "preset", "veryfast", 0);
+            if (settings.lowLatency) av_dict_set(&opts, "tune", "zerolatency", 0);
+        }
+
+        int ret = avcodec_open2(encoderCtx, codec, &opts);
+        av_dict_free(&opts);
+        if (ret < 0) {
+            Logger::error("VideoEncoder: cannot open " + settings.encoderName + " for " + cameraName + ": " + avErrorString(ret));
+            return false;
+        }
+
+        Logger::info("VideoEncoder: " + settings.encoderName + " " + std::to_string(encoderCtx->width) + "x" +
+                     std::to_string(encoderCtx->height) + " @ " + std::to_string(settings.bitrateMbps) +
+                     "Mbps for " + cameraName + (filter ? "" : " (no filter)"));
+        return true;
+    }
+
+    bool drainEncoder() {
+        while (true) {
+            int ret = avcodec_receive_packet(encoderCtx, packet);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+            if (ret < 0) {
+                Logger::error("VideoEncoder: encode failed for " + cameraName + ": " + avErrorString(ret));
+                return false;
+            }
+            if (onPacket) {
+                onPacket(packet);
+            }
+            av_packet_unref(packet);
+        }
+    }
+
+    bool sendToEncoder(AVFrame* frame) {
+        if (!encoderCtx && !initEncoder(frame)) {
+            return false;
+        }
+
+        frame->pict_type = AV_PICTURE_TYPE_NONE;
+        int ret = avcodec_send_frame(encoderCtx, frame);
+        if (ret < 0 && ret != AVERROR(EAGAIN)) {
+            Logger::error("VideoEncoder: send frame failed for " + cameraName + ": " + avErrorString(ret));
+            return false;
+        }
+        return drainEncoder();
+    }
+
+    bool drainFilter() {
+        while (true) {
+            int ret = filter->pull(filteredFrame);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+            if (ret < 0) return false;
+
+            bool ok = sendToEncoder(filteredFrame);
+            av_frame_unref(filteredFrame);
+            if (!ok) return false;
+        }
+    }
+
+public:
+    VideoEncoder(const std::string& name, const Settings& s,
+                 AVRational timeBase, AVRational frameRate)
+        : cameraName(name), settings(s), inputTimeBase(timeBase), inputFrameRate(frameRate),
+          filterChecked(false), encoderCtx(nullptr),
+          filteredFrame(av_frame_alloc()), packet(av_packet_alloc()), failed(false) {}
+
+    ~VideoEncoder() {
+        avcodec_free_context(&encoderCtx);
+        av_frame_free(&filteredFrame);
+        av_packet_free(&packet);
+    }
+
+    VideoEncoder(const VideoEncoder&) = delete;
+    VideoEncoder& operator=(const VideoEncoder&) = delete;
+
+    /**
+     * Filter (if needed) and encode one frame (frame is not consumed)
+     */
+    bool encode(const AVFrame* frame) {
+        if (failed) return false;
+
+        // First frame decides whether this output needs its own filter
+        if (!filterChecked) {
+            filterChecked = true;
+            const std::string& spec = frame->hw_frames_ctx ? settings.hardwareFilter : settings.softwareFilter;
+            if (!spec.empty()) {
+                filter.reset(new VideoFilter(cameraName, settings.softwareFilter, settings.hardwareFilter,
+                                             settings.hwDevice, inputTimeBase, inputFrameRate));
+            }
+        }
+
+        bool ok;
+        if (filter) {
+            ok = filter->push(frame) && drainFilter();
+        } else {
+            // Direct encode: a shallow reference avoids touching frame data
+            if (av_frame_ref(filteredFrame, frame) < 0) {
+                failed = true;
+                return false;
+            }
+            ok = sendToEncoder(filteredFrame);
+            av_frame_unref(filteredFrame);
+        }
+
+        if (!ok) {
+            failed = true;
+        }
+        return ok;
+    }
+
+    /**
+     * Flush filter and encoder at end of stream
+     */
+    void flush() {
+        if (failed) return;
+
+        if (filter && filter->isConfigured()) {
+            filter->pushEof();
+            drainFilter();
+        }
+
+        if (encoderCtx) {
+            avcodec_send_frame(encoderCtx, nullptr);
+            drainEncoder();
+        }
+    }
+
+    void setPacketCallback(PacketCallback callback) {
+        onPacket = std::move(callback);
+    }
+
+    bool isOpen() const { return encoderCtx != nullptr; }
+    bool hasFailed() const { return failed; }
+    AVRational getTimeBase() const { return encoderCtx ? encoderCtx->time_base : inputTimeBase; }
+
+    /**
+     * Fill stream parameters for muxers (valid once isOpen())
+     */
+    bool getCodecParameters(AVCodecParameters* codecpar) const {
+        if (!encoderCtx) return false;
+        return avcodec_parameters_from_context(codecpar, encoderCtx) >= 0;
+    }
+};
+
+#endif // VIDEO_ENCODER_HPP
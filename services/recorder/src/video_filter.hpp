@@ -0,0 +1,171 @@
+#ifndef VIDEO_FILTER_HPP
+#define VIDEO_FILTER_HPP
+
+#include <string>
+#include "libav_common.hpp"
+#include "logger.hpp"
+
+/**
+ * VideoFilter - libavfilter graph with a single video input and output
+ *
+ * Equivalent of one `-vf` chain in the ffmpeg CLI. The graph is created
+ * lazily from the first frame so the pixel format and hardware frames
+ * context (CUDA from NVDEC) are known before anything is configured.
+ *
+ * Two chains are given: one for system memory frames and one for
+ * hardware frames; the first frame decides which one is used.
+ */
+class VideoFilter {
+private:
+    std::string cameraName;
+    std::string softwareSpec;
+    std::string hardwareSpec;
+    AVBufferRef* hwDevice;        // Borrowed, for hwupload (VAAPI)
+    AVRational inputTimeBase;
+    AVRational inputFrameRate;
+
+    AVFilterGraph* filterGraph;
+    AVFilterContext* bufferSrc;
+    AVFilterContext* bufferSink;
+    bool failed;
+
+    bool init(const AVFrame* frame) {
+        filterGraph = avfilter_graph_alloc();
+        if (!filterGraph) return false;
+
+        AVRational sar = frame->sample_aspect_ratio.num ? frame->sample_aspect_ratio : AVRational{1, 1};
+        std::string args = "video_size=" + std::to_string(frame->width) + "x" + std::to_string(frame->height) +
+                           ":pix_fmt=" + std::to_string(frame->format) +
+                           ":time_base=" + std::to_string(inputTimeBase.num) + "/" + std::to_string(inputTimeBase.den) +
+                           ":pixel_aspect=" + std::to_string(sar.num) + "/" + std::to_string(sar.den);
+        if (inputFrameRate.num > 0 && inputFrameRate.den > 0) {
+            args += ":frame_rate=" + std::to_string(inputFrameRate.num) + "/" + std::to_string(inputFrameRate.den);
+        }
+
+        int ret = avfilter_graph_create_filter(&bufferSrc, avfilter_get_by_name("buffer"), "in",
+                                               args.c_str(), nullptr, filterGraph);
+        if (ret < 0) {
+            Logger::error("VideoFilter: cannot create buffer source for " + cameraName + ": " + avErrorString(ret));
+            return false;
+        }
+
+        // Hardware decoded frames carry their frames context into the graph
+        if (frame->hw_frames_ctx) {
+            AVBufferSrcParameters* par = av_buffersrc_parameters_alloc();
+            par->hw_frames_ctx = frame->hw_frames_ctx;
+            ret = av_buffersrc_parameters_set(bufferSrc, par);
+            av_free(par);
+            if (ret < 0) return false;
+        }
+
+        ret = avfilter_graph_create_filter(&bufferSink, avfilter_get_by_name("buffersink"), "out",
+                                           nullptr, nullptr, filterGraph);
+        if (ret < 0) {
+            Logger::error("VideoFilter: cannot create buffer sink for " + cameraName + ": " + avErrorString(ret));
+            return false;
+        }
+
+        const std::string& spec = frame->hw_frames_ctx ? hardwareSpec : softwareSpec;
+        std::string filterSpec = spec.empty() ? "null" : spec;
+
+        AVFilterInOut* outputs = avfilter_inout_alloc();
+        AVFilterInOut* inputs = avfilter_inout_alloc();
+        outputs->name = av_strdup("in");
+        outputs->filter_ctx = bufferSrc;
+        outputs->pad_idx = 0;
+        outputs->next = nullptr;
+        inputs->name = av_strdup("out");
+        inputs->filter_ctx = bufferSink;
+        inputs->pad_idx = 0;
+        inputs->next = nullptr;
+
+        ret = avfilter_graph_parse_ptr(filterGraph, filterSpec.c_str(), &inputs, &outputs, nullptr);
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        if (ret < 0) {
+            Logger::error("VideoFilter: invalid filter '" + filterSpec + "' for " + cameraName + ": " + avErrorString(ret));
+            return false;
+        }
+
+        // Equivalent of -filter_hw_device: hwupload needs the device
+        if (hwDevice) {
+            for (unsigned int i = 0; i < filterGraph->nb_filters; i++) {
+                filterGraph->filters[i]->hw_device_ctx = av_buffer_ref(hwDevice);
+            }
+        }
+
+        ret = avfilter_graph_config(filterGraph, nullptr);
+        if (ret < 0) {
+            Logger::error("VideoFilter: cannot configure filter '" + filterSpec + "' for " + cameraName + ": " + avErrorString(ret));
+            return false;
+        }
+        return true;
+    }
+
+public:
+    VideoFilter(const std::string& name, const std::string& swSpec, const std::string& hwSpec,
+                AVBufferRef* device, AVRational timeBase, AVRational frameRate)
+        : cameraName(name), softwareSpec(swSpec), hardwareSpec(hwSpec), hwDevice(device),
+          inputTimeBase(timeBase), inputFrameRate(frameRate),
+          filterGraph(nullptr), bufferSrc(nullptr), bufferSink(nullptr), failed(false) {}
+
+    ~VideoFilter() {
+        avfilter_graph_free(&filterGraph);
+    }
+
+    VideoFilter(const VideoFilter&) = delete;
+    VideoFilter& operator=(const VideoFilter&) = delete;
+
+    /**
+     * Feed one frame (frame is not consumed)
+     */
+    bool push(const AVFrame* frame) {
+        if (failed) return false;
+
+        if (!filterGraph && !init(frame)) {
+            failed = true;
+            return false;
+        }
+
+        int ret = av_buffersrc_add_frame_flags(bufferSrc, const_cast<AVFrame*>(frame),
+                                               AV_BUFFERSRC_FLAG_KEEP_REF);
+        if (ret < 0) {
+            Logger::error("VideoFilter: cannot feed filter for " + cameraName + ": " + avErrorString(ret));
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Signal end of stream
+     */
+    void pushEof() {
+        if (failed || !filterGraph) return;
+        av_buffersrc_add_frame_flags(bufferSrc, nullptr, 0);
+    }
+
+    /**
+     * Get one filtered frame
+     *
+     * @return 0 on success, AVERROR(EAGAIN)/AVERROR_EOF when drained, <0 on error
+     */
+    int pull(AVFrame* frame) {
+        if (failed || !filterGraph) return AVERROR(EAGAIN);
+        return av_buffersink_get_frame(bufferSink, frame);
+    }
+
+    bool isConfigured() const { return filterGraph != nullptr && !failed; }
+    bool hasFailed() const { return failed; }
+
+    // Output properties (valid once isConfigured())
+    int getWidth() const { return av_buffersink_get_w(bufferSink); }
+    int getHeight() const { return av_buffersink_get_h(bufferSink); }
+    AVPixelFormat getFormat() const { return (AVPixelFormat)av_buffersink_get_format(bufferSink); }
+    AVRational getTimeBase() const { return av_buffersink_get_time_base(bufferSink); }
+    AVRational getFrameRate() const { return av_buffersink_get_frame_rate(bufferSink); }
+    AVRational getSampleAspectRatio() const { return av_buffersink_get_sample_aspect_ratio(bufferSink); }
+    AVBufferRef* getHwFramesContext() const { return av_buffersink_get_hw_frames_ctx(bufferSink); }
+};
+
+#endif // VIDEO_FILTER_HPP